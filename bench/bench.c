@@ -0,0 +1,168 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file bench/bench.c
+ */
+
+#include "bench.h"
+
+#define BENCH_HISTOGRAM_BAR_WIDTH 40
+
+void
+bench_histogram_init(BENCH_Histogram *histogram)
+{
+  g_assert(histogram);
+
+  memset(histogram, 0, sizeof(*histogram));
+
+  histogram->min = G_MAXINT64;
+}
+
+static guint
+_bench_histogram_bucket(gint64 value)
+{
+  guint bucket = 0;
+
+  // Bucket zero only holds values below one
+  while ((value > 0) && (bucket + 1 < BENCH_HISTOGRAM_BUCKETS))
+  {
+    value >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+static gint64
+_bench_histogram_bound(guint bucket)
+{
+  return bucket? ((gint64) 1) << bucket : 1;
+}
+
+void
+bench_histogram_add(BENCH_Histogram *histogram,
+                    gint64 value)
+{
+  g_assert(histogram);
+
+  histogram->buckets[_bench_histogram_bucket(value)]++;
+  histogram->count++;
+
+  histogram->total += value;
+  histogram->min = MIN(histogram->min, value);
+  histogram->max = MAX(histogram->max, value);
+}
+
+gint64
+bench_histogram_percentile(const BENCH_Histogram *histogram,
+                           gdouble percentile)
+{
+  g_assert(histogram);
+
+  const guint64 rank = (guint64) (histogram->count * percentile / 100.0);
+  guint64 count = 0;
+
+  for (guint i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++)
+  {
+    count += histogram->buckets[i];
+
+    if (count > rank)
+      return MIN(_bench_histogram_bound(i), histogram->max);
+  }
+
+  return histogram->max;
+}
+
+void
+bench_histogram_print(const BENCH_Histogram *histogram,
+                      const gchar *name,
+                      const gchar *unit)
+{
+  g_assert((histogram) && (name) && (unit));
+
+  if (!(histogram->count))
+  {
+    g_print("%s: no values\n", name);
+    return;
+  }
+
+  g_print(
+    "%s: %" G_GUINT64_FORMAT " values, mean %.1f %s, min %" G_GINT64_FORMAT
+    ", p50 <= %" G_GINT64_FORMAT ", p90 <= %" G_GINT64_FORMAT
+    ", p99 <= %" G_GINT64_FORMAT ", max %" G_GINT64_FORMAT "\n",
+    name,
+    histogram->count,
+    (gdouble) histogram->total / histogram->count,
+    unit,
+    histogram->min,
+    bench_histogram_percentile(histogram, 50.0),
+    bench_histogram_percentile(histogram, 90.0),
+    bench_histogram_percentile(histogram, 99.0),
+    histogram->max
+  );
+
+  guint64 largest = 0;
+  for (guint i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++)
+    largest = MAX(largest, histogram->buckets[i]);
+
+  for (guint i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++)
+  {
+    if (!(histogram->buckets[i]))
+      continue;
+
+    const guint width = (guint) (
+      histogram->buckets[i] * BENCH_HISTOGRAM_BAR_WIDTH / largest
+    );
+
+    gchar *bar = g_strnfill(MAX(width, 1), '#');
+
+    g_print(
+      "  < %10" G_GINT64_FORMAT " %s | %-*s %" G_GUINT64_FORMAT "\n",
+      _bench_histogram_bound(i),
+      unit,
+      BENCH_HISTOGRAM_BAR_WIDTH,
+      bar,
+      histogram->buckets[i]
+    );
+
+    g_free(bar);
+  }
+}
+
+void
+bench_print_rate(const gchar *name,
+                 guint64 count,
+                 gint64 duration)
+{
+  g_assert(name);
+
+  const gdouble rate = duration > 0? (
+    (gdouble) count * G_USEC_PER_SEC / duration
+  ) : 0.0;
+
+  g_print(
+    "%s: %" G_GUINT64_FORMAT " in %" G_GINT64_FORMAT " us (%.0f/s)\n",
+    name,
+    count,
+    duration,
+    rate
+  );
+}
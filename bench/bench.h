@@ -0,0 +1,103 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file bench/bench.h
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <glib-2.0/glib.h>
+#include <string.h>
+
+#ifndef UNUSED
+#define UNUSED __attribute__((unused))
+#endif
+
+#define BENCH_HISTOGRAM_BUCKETS 32
+
+typedef struct BENCH_Histogram
+{
+  guint64 buckets [BENCH_HISTOGRAM_BUCKETS];
+  guint64 count;
+
+  gint64 total;
+  gint64 min;
+  gint64 max;
+} BENCH_Histogram;
+
+/**
+ * Initializes a histogram with buckets growing by
+ * powers of two.
+ *
+ * @param histogram Histogram
+ */
+void
+bench_histogram_init(BENCH_Histogram *histogram);
+
+/**
+ * Adds a measured value to a histogram.
+ *
+ * @param histogram Histogram
+ * @param value Value
+ */
+void
+bench_histogram_add(BENCH_Histogram *histogram,
+                    gint64 value);
+
+/**
+ * Returns an upper bound for a given percentile of
+ * all values added to a histogram.
+ *
+ * @param histogram Histogram
+ * @param percentile Percentile between 0 and 100
+ * @return Upper bound of the percentile
+ */
+gint64
+bench_histogram_percentile(const BENCH_Histogram *histogram,
+                           gdouble percentile);
+
+/**
+ * Prints a summary and all non-empty buckets of
+ * a histogram.
+ *
+ * @param histogram Histogram
+ * @param name Name of the measurement
+ * @param unit Unit of the values
+ */
+void
+bench_histogram_print(const BENCH_Histogram *histogram,
+                      const gchar *name,
+                      const gchar *unit);
+
+/**
+ * Prints the throughput of a measurement.
+ *
+ * @param name Name of the measurement
+ * @param count Amount of processed items
+ * @param duration Duration in microseconds
+ */
+void
+bench_print_rate(const gchar *name,
+                 guint64 count,
+                 gint64 duration);
+
+#endif /* BENCH_H_ */
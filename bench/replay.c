@@ -0,0 +1,519 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file bench/replay.c
+ *
+ * Generated workload posted through the commands of the
+ * application against the chat library and a running
+ * messenger service.
+ */
+
+#include "bench.h"
+
+#include "../src/application.h"
+#include "../src/command.h"
+#include "../src/util.h"
+#include "../src/ui/chat_entry.h"
+
+#include <gnunet/gnunet_chat_lib.h>
+
+#define BENCH_REPLAY_ACCOUNT "bench-replay"
+#define BENCH_REPLAY_GROUP "Replay"
+
+#define BENCH_REPLAY_MESSAGES 50000
+#define BENCH_REPLAY_CONTEXTS 500
+#define BENCH_REPLAY_BURST 250
+#define BENCH_REPLAY_SEED 42
+
+#define BENCH_REPLAY_INTERVAL 5 // ms between bursts
+#define BENCH_REPLAY_POLL 10 // ms between checks for idle
+#define BENCH_REPLAY_QUIET 1000000 // us without events to be idle
+#define BENCH_REPLAY_TIMEOUT 30000000 // us to wait for a login
+
+typedef struct BENCH_ReplayPost
+{
+  MESSENGER_CommandType type;
+
+  struct GNUNET_CHAT_Context *context;
+  struct GNUNET_CHAT_Message *target;
+} BENCH_ReplayPost;
+
+typedef struct BENCH_Replay
+{
+  MESSENGER_Application app;
+  GRand *rand;
+
+  guint messages;
+  guint contexts;
+  guint burst;
+
+  gboolean requested;
+  GPtrArray *groups;
+  BENCH_ReplayPost *posts;
+
+  guint posted;
+  guint completed;
+  guint failed;
+
+  gint64 wait;
+  gint64 start;
+  gint64 finished;
+  gint64 idle;
+  gint64 last_change;
+
+  guint64 start_calls;
+  guint64 calls;
+
+  guint tick;
+  gint64 last_frame;
+
+  BENCH_Histogram frames;
+  BENCH_Histogram locks;
+  BENCH_Histogram bursts;
+
+  int status;
+} BENCH_Replay;
+
+static BENCH_Replay replay;
+
+static const gchar *words [] = {
+  "hello", "meeting", "tomorrow", "*important*", "_maybe_", "file",
+  "https://gnunet.org", "peer", "message", "`code`", "~old~", "chat",
+  "group", "thanks", "see", "you", "later", "ok", "why", "not",
+};
+
+static const gchar *tags [] = {
+  "todo", "done", "important", "later",
+};
+
+static guint
+_replay_env(const gchar *name,
+            guint fallback)
+{
+  const gchar *value = g_getenv(name);
+
+  if ((!value) || (!(*value)))
+    return fallback;
+
+  const guint64 parsed = g_ascii_strtoull(value, NULL, 10);
+  return parsed > 0? (guint) parsed : fallback;
+}
+
+static gchar*
+_replay_text(void)
+{
+  const guint count = g_rand_int_range(replay.rand, 1, 24);
+  GString *text = g_string_new(NULL);
+
+  for (guint i = 0; i < count; i++)
+  {
+    if (i)
+      g_string_append_c(text, ' ');
+
+    g_string_append(
+      text,
+      words[g_rand_int_range(replay.rand, 0, G_N_ELEMENTS(words))]
+    );
+  }
+
+  return g_string_free(text, FALSE);
+}
+
+static void
+_replay_completed(UNUSED MESSENGER_Application *app,
+                  gboolean success,
+                  UNUSED gpointer user_data)
+{
+  replay.completed++;
+
+  if (!success)
+    replay.failed++;
+}
+
+static gboolean
+_replay_tick(UNUSED GtkWidget *widget,
+             GdkFrameClock *clock,
+             UNUSED gpointer user_data)
+{
+  const gint64 frame = gdk_frame_clock_get_frame_time(clock);
+
+  if (replay.last_frame)
+    bench_histogram_add(&(replay.frames), frame - replay.last_frame);
+
+  replay.last_frame = frame;
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+_replay_finish(int status)
+{
+  GtkWidget *window = GTK_WIDGET(replay.app.ui.messenger.main_window);
+
+  if (replay.tick)
+    gtk_widget_remove_tick_callback(window, replay.tick);
+
+  replay.tick = 0;
+  replay.status = status;
+
+  gtk_widget_destroy(window);
+}
+
+static void
+_replay_report(void)
+{
+  const MESSENGER_ScheduleStats *stats = &(replay.app.ui.schedule.queue.stats);
+
+  g_print(
+    "replay: %u messages across %u contexts in bursts of %u\n",
+    replay.posted,
+    replay.groups->len,
+    replay.burst
+  );
+
+  bench_print_rate(
+    "posted commands",
+    replay.posted,
+    replay.finished - replay.start
+  );
+
+  bench_print_rate(
+    "handled events until idle",
+    replay.calls - replay.start_calls,
+    replay.idle - replay.start
+  );
+
+  g_print(
+    "time to idle: %" G_GINT64_FORMAT " us after the last command"
+    " (%u of %u commands failed)\n",
+    replay.idle - replay.finished,
+    replay.failed,
+    replay.completed
+  );
+
+  bench_histogram_print(&(replay.frames), "ui frame interval", "us");
+  bench_histogram_print(&(replay.locks), "chat lock per burst", "us");
+  bench_histogram_print(&(replay.bursts), "burst", "us");
+
+  g_print(
+    "ui schedule: %" G_GUINT64_FORMAT " calls in %" G_GUINT64_FORMAT
+    " batches, busy %" G_GINT64_FORMAT " us, longest batch %" G_GINT64_FORMAT
+    " us\n",
+    stats->calls,
+    stats->batches,
+    stats->busy_time,
+    stats->longest_batch
+  );
+}
+
+static gboolean
+_replay_idle(UNUSED gpointer user_data)
+{
+  const MESSENGER_ScheduleStats *stats = &(replay.app.ui.schedule.queue.stats);
+  const gint64 now = g_get_monotonic_time();
+
+  // Deferred rendering still counts as work of the UI
+  if ((stats->calls != replay.calls) || (util_frame_pending()))
+  {
+    replay.calls = stats->calls;
+    replay.last_change = now;
+  }
+
+  if ((replay.completed < replay.posted) ||
+      (now - replay.last_change < BENCH_REPLAY_QUIET))
+    return TRUE;
+
+  replay.idle = replay.last_change;
+
+  _replay_report();
+  _replay_finish(EXIT_SUCCESS);
+  return FALSE;
+}
+
+static struct GNUNET_CHAT_Message*
+_replay_pick_target(struct GNUNET_CHAT_Context *context)
+{
+  UI_CHAT_ENTRY_Handle *entry = GNUNET_CHAT_context_get_user_pointer(context);
+
+  if ((!entry) || (g_queue_is_empty(&(entry->deferred))))
+    return NULL;
+
+  // Only sent texts of the chat can be tagged or deleted
+  struct GNUNET_CHAT_Message *target = g_queue_peek_nth(
+    &(entry->deferred),
+    g_rand_int_range(replay.rand, 0, entry->deferred.length)
+  );
+
+  if ((GNUNET_CHAT_KIND_TEXT != GNUNET_CHAT_message_get_kind(target)) ||
+      (GNUNET_YES != GNUNET_CHAT_message_is_sent(target)) ||
+      (GNUNET_YES == GNUNET_CHAT_message_is_deleted(target)))
+    return NULL;
+
+  return target;
+}
+
+static gboolean
+_replay_burst(UNUSED gpointer user_data)
+{
+  MESSENGER_Application *app = &(replay.app);
+
+  const gint64 start = g_get_monotonic_time();
+  guint count = 0;
+
+  application_chat_lock(app);
+
+  const gint64 locked = g_get_monotonic_time();
+
+  // Targets get picked while locked, commands get posted afterwards
+  for (; (count < replay.burst) &&
+         (replay.posted + count < replay.messages); count++)
+  {
+    BENCH_ReplayPost *post = &(replay.posts[count]);
+
+    post->context = replay.groups->pdata[
+      g_rand_int_range(replay.rand, 0, replay.groups->len)
+    ];
+
+    const gint32 roll = g_rand_int_range(replay.rand, 0, 100);
+
+    post->target = roll >= 80? _replay_pick_target(post->context) : NULL;
+
+    if (!(post->target))
+      post->type = MESSENGER_COMMAND_SEND_TEXT;
+    else if (roll >= 90)
+      post->type = MESSENGER_COMMAND_DELETE_MESSAGE;
+    else
+      post->type = MESSENGER_COMMAND_SEND_TAG;
+  }
+
+  application_chat_unlock(app);
+
+  bench_histogram_add(&(replay.locks), locked - start);
+
+  for (guint i = 0; i < count; i++)
+  {
+    BENCH_ReplayPost *post = &(replay.posts[i]);
+    gchar *text;
+
+    switch (post->type)
+    {
+      case MESSENGER_COMMAND_DELETE_MESSAGE:
+        command_delete_message(
+          app, post->target, 0, _replay_completed, NULL
+        );
+        break;
+      case MESSENGER_COMMAND_SEND_TAG:
+        command_send_tag(
+          app,
+          post->context,
+          post->target,
+          tags[g_rand_int_range(replay.rand, 0, G_N_ELEMENTS(tags))],
+          _replay_completed,
+          NULL
+        );
+        break;
+      default:
+        text = _replay_text();
+        command_send_text(app, post->context, text, _replay_completed, NULL);
+        g_free(text);
+        break;
+    }
+  }
+
+  replay.posted += count;
+
+  const gint64 end = g_get_monotonic_time();
+
+  bench_histogram_add(&(replay.bursts), end - start);
+
+  if (replay.posted < replay.messages)
+    return TRUE;
+
+  replay.finished = end;
+  replay.last_change = end;
+
+  g_timeout_add(BENCH_REPLAY_POLL, _replay_idle, NULL);
+  return FALSE;
+}
+
+static enum GNUNET_GenericReturnValue
+_replay_iterate_groups(UNUSED void *cls,
+                       UNUSED struct GNUNET_CHAT_Handle *handle,
+                       struct GNUNET_CHAT_Group *group)
+{
+  const char *name = GNUNET_CHAT_group_get_name(group);
+
+  // Groups of previous runs get reused
+  if ((name) && (g_str_has_prefix(name, BENCH_REPLAY_GROUP " ")) &&
+      (replay.groups->len < replay.contexts))
+    g_ptr_array_add(replay.groups, GNUNET_CHAT_group_get_context(group));
+
+  return GNUNET_YES;
+}
+
+static void
+_replay_start(void)
+{
+  MESSENGER_Application *app = &(replay.app);
+  struct GNUNET_CHAT_Handle *handle = app->chat.messenger.handle;
+
+  application_chat_lock(app);
+
+  GNUNET_CHAT_iterate_groups(handle, _replay_iterate_groups, NULL);
+
+  while (replay.groups->len < replay.contexts)
+  {
+    struct GNUNET_CHAT_Group *group = GNUNET_CHAT_group_create(handle, NULL);
+
+    if (!group)
+      break;
+
+    gchar *name = g_strdup_printf(
+      "%s %u", BENCH_REPLAY_GROUP, replay.groups->len
+    );
+
+    GNUNET_CHAT_group_set_name(group, name);
+    g_free(name);
+
+    g_ptr_array_add(replay.groups, GNUNET_CHAT_group_get_context(group));
+  }
+
+  application_chat_unlock(app);
+
+  if (!(replay.groups->len))
+  {
+    g_printerr("replay: no groups could be created\n");
+    _replay_finish(EXIT_FAILURE);
+    return;
+  }
+
+  // Frames keep getting requested to measure their intervals under load
+  replay.tick = gtk_widget_add_tick_callback(
+    GTK_WIDGET(app->ui.messenger.main_window),
+    _replay_tick,
+    NULL,
+    NULL
+  );
+
+  replay.start = g_get_monotonic_time();
+  replay.start_calls = app->ui.schedule.queue.stats.calls;
+  replay.calls = replay.start_calls;
+
+  g_timeout_add(BENCH_REPLAY_INTERVAL, _replay_burst, NULL);
+}
+
+static gboolean
+_replay_connect(UNUSED gpointer user_data)
+{
+  MESSENGER_Application *app = &(replay.app);
+  struct GNUNET_CHAT_Handle *handle = app->chat.messenger.handle;
+
+  if ((!handle) || (!(app->ui.messenger.main_window)))
+    return TRUE;
+
+  if (g_get_monotonic_time() - replay.wait > BENCH_REPLAY_TIMEOUT)
+  {
+    g_printerr("replay: skipped without a login to the messenger service\n");
+    _replay_finish(77);
+    return FALSE;
+  }
+
+  application_chat_lock(app);
+
+  const gboolean connected = (NULL != GNUNET_CHAT_get_connected(handle));
+
+  // A created account gets connected by the application
+  if ((!connected) && (!(replay.requested)))
+  {
+    struct GNUNET_CHAT_Account *account = GNUNET_CHAT_find_account(
+      handle, BENCH_REPLAY_ACCOUNT
+    );
+
+    if (!account)
+      GNUNET_CHAT_account_create(handle, BENCH_REPLAY_ACCOUNT);
+    else if (!(app->chat.identity))
+      GNUNET_CHAT_connect(handle, account);
+
+    replay.requested = TRUE;
+  }
+
+  application_chat_unlock(app);
+
+  if (!connected)
+    return TRUE;
+
+  _replay_start();
+  return FALSE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+  // The application needs a display and the service a running peer
+  if ((!g_getenv("DISPLAY")) && (!g_getenv("WAYLAND_DISPLAY")))
+  {
+    g_printerr("replay: skipped without a display\n");
+    return 77;
+  }
+
+  memset(&replay, 0, sizeof(replay));
+
+  application_init(&(replay.app), argc, argv);
+
+  replay.rand = g_rand_new_with_seed(
+    _replay_env("MESSENGER_REPLAY_SEED", BENCH_REPLAY_SEED)
+  );
+
+  replay.messages = _replay_env(
+    "MESSENGER_REPLAY_MESSAGES", BENCH_REPLAY_MESSAGES
+  );
+
+  replay.contexts = _replay_env(
+    "MESSENGER_REPLAY_CONTEXTS", BENCH_REPLAY_CONTEXTS
+  );
+
+  replay.burst = _replay_env(
+    "MESSENGER_REPLAY_BURST", BENCH_REPLAY_BURST
+  );
+
+  replay.groups = g_ptr_array_new();
+  replay.posts = g_new0(BENCH_ReplayPost, replay.burst);
+
+  bench_histogram_init(&(replay.frames));
+  bench_histogram_init(&(replay.locks));
+  bench_histogram_init(&(replay.bursts));
+
+  replay.wait = g_get_monotonic_time();
+
+  g_timeout_add(100, _replay_connect, NULL);
+
+  application_run(&(replay.app));
+
+  const int status = replay.status? replay.status : (
+    application_status(&(replay.app))
+  );
+
+  g_ptr_array_free(replay.groups, TRUE);
+  g_free(replay.posts);
+  g_rand_free(replay.rand);
+
+  return status;
+}
@@ -0,0 +1,379 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file bench/schedule.c
+ */
+
+#include "bench.h"
+
+#include "../src/application.h"
+
+#define BENCH_SCHEDULE_SYNC_CALLS 20000
+#define BENCH_SCHEDULE_ASYNC_CALLS 200000
+#define BENCH_SCHEDULE_ASYNC_BURST 256
+#define BENCH_SCHEDULE_EVENTS 200000
+
+typedef struct BENCH_Schedule
+{
+  MESSENGER_Application app;
+  GMainLoop *loop;
+  pthread_t tid;
+
+  MESSENGER_SchedulePriority priority;
+  gint64 *stamps;
+  guint pushed;
+  guint done;
+  gint finished;
+
+  gint64 start;
+  gint64 end;
+
+  BENCH_Histogram sync;
+  BENCH_Histogram async [MESSENGER_SCHEDULE_PRIORITY_COUNT];
+  gint64 duration [MESSENGER_SCHEDULE_PRIORITY_COUNT];
+
+  guint events;
+  guint handled;
+  gint contending;
+  guint commands;
+
+  gint64 contention_start;
+  gint64 contention_end;
+
+  BENCH_Histogram locks;
+  BENCH_Histogram delays;
+} BENCH_Schedule;
+
+static BENCH_Schedule bench;
+
+static gboolean
+_bench_sync_call(UNUSED gpointer user_data)
+{
+  return TRUE;
+}
+
+static gboolean
+_bench_async_call(gpointer user_data)
+{
+  const gint64 *stamp = (const gint64*) user_data;
+  const gint64 now = g_get_monotonic_time();
+
+  // Runs in the main loop, so the histogram is not shared
+  bench_histogram_add(&(bench.async[bench.priority]), now - *stamp);
+
+  if (++(bench.done) < BENCH_SCHEDULE_ASYNC_CALLS)
+    return FALSE;
+
+  bench.end = now;
+  g_atomic_int_set(&(bench.finished), TRUE);
+
+  return FALSE;
+}
+
+static void
+_bench_event(UNUSED MESSENGER_Application *app)
+{
+  if (++(bench.handled) < BENCH_SCHEDULE_EVENTS)
+    return;
+
+  bench.contention_end = g_get_monotonic_time();
+  g_atomic_int_set(&(bench.finished), TRUE);
+}
+
+static gboolean
+_bench_command(gpointer user_data)
+{
+  gint64 *stamp = (gint64*) user_data;
+
+  // Runs in the thread of the GNUnet scheduler, which owns this histogram
+  bench_histogram_add(&(bench.delays), g_get_monotonic_time() - *stamp);
+
+  g_free(stamp);
+  return FALSE;
+}
+
+static gboolean
+_bench_stop_chat(UNUSED gpointer user_data)
+{
+  GNUNET_SCHEDULER_shutdown();
+  return FALSE;
+}
+
+static gboolean
+_bench_contend(UNUSED gpointer user_data)
+{
+  if (g_atomic_int_get(&(bench.finished)))
+  {
+    // Same order as exiting the application
+    schedule_sync_run(&(bench.app.chat.schedule), _bench_stop_chat, NULL);
+
+    g_main_loop_quit(bench.loop);
+    return FALSE;
+  }
+
+  // Handlers of the UI lock the chat while events keep arriving
+  const gint64 start = g_get_monotonic_time();
+
+  application_chat_lock(&(bench.app));
+  application_chat_unlock(&(bench.app));
+
+  const gint64 end = g_get_monotonic_time();
+
+  bench_histogram_add(&(bench.locks), end - start);
+
+  gint64 *stamp = g_new(gint64, 1);
+  *stamp = end;
+
+  // Commands get posted to the detached queue like from the UI
+  schedule_async_run(
+    &(bench.app.chat.schedule),
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    _bench_command,
+    stamp
+  );
+
+  bench.commands++;
+  return TRUE;
+}
+
+static gboolean
+_bench_start_contention(UNUSED gpointer user_data)
+{
+  g_idle_add(_bench_contend, NULL);
+  return FALSE;
+}
+
+static void
+_bench_push_events(void *cls)
+{
+  // Mix of events as forwarded by the messenger thread
+  for (guint i = 0; i < BENCH_SCHEDULE_ASYNC_BURST; i++)
+  {
+    if (bench.events >= BENCH_SCHEDULE_EVENTS)
+      return;
+
+    application_call_event(
+      &(bench.app),
+      (bench.events % 4)? MESSENGER_SCHEDULE_PRIORITY_BULK : (
+        MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE
+      ),
+      _bench_event
+    );
+
+    bench.events++;
+  }
+
+  GNUNET_SCHEDULER_add_now(_bench_push_events, cls);
+}
+
+static void
+_bench_contention_phase(void *cls)
+{
+  bench.events = 0;
+  bench.handled = 0;
+  bench.finished = FALSE;
+  bench.contention_start = g_get_monotonic_time();
+
+  g_idle_add(_bench_start_contention, NULL);
+
+  _bench_push_events(cls);
+}
+
+static void
+_bench_next_phase(void *cls);
+
+static void
+_bench_wait_phase(void *cls)
+{
+  if (!g_atomic_int_get(&(bench.finished)))
+  {
+    GNUNET_SCHEDULER_add_delayed(
+      GNUNET_TIME_UNIT_MILLISECONDS,
+      _bench_wait_phase,
+      cls
+    );
+    return;
+  }
+
+  bench.duration[bench.priority] = bench.end - bench.start;
+  bench.priority++;
+
+  GNUNET_SCHEDULER_add_now(_bench_next_phase, cls);
+}
+
+static void
+_bench_push_burst(void *cls)
+{
+  // Every burst gets flushed once the current task returns
+  for (guint i = 0; i < BENCH_SCHEDULE_ASYNC_BURST; i++)
+  {
+    if (bench.pushed >= BENCH_SCHEDULE_ASYNC_CALLS)
+      break;
+
+    gint64 *stamp = &(bench.stamps[bench.pushed++]);
+    *stamp = g_get_monotonic_time();
+
+    schedule_async_run(
+      &(bench.app.ui.schedule),
+      bench.priority,
+      _bench_async_call,
+      stamp
+    );
+  }
+
+  if (bench.pushed < BENCH_SCHEDULE_ASYNC_CALLS)
+    GNUNET_SCHEDULER_add_now(_bench_push_burst, cls);
+  else
+    _bench_wait_phase(cls);
+}
+
+static void
+_bench_next_phase(void *cls)
+{
+  if (bench.priority >= MESSENGER_SCHEDULE_PRIORITY_COUNT)
+  {
+    _bench_contention_phase(cls);
+    return;
+  }
+
+  bench.pushed = 0;
+  bench.done = 0;
+  bench.finished = FALSE;
+  bench.start = g_get_monotonic_time();
+
+  _bench_push_burst(cls);
+}
+
+static void
+_bench_run(void *cls)
+{
+  schedule_load_gnunet(&(bench.app.chat.schedule));
+
+  // Each sync run blocks this thread until the main loop handled it
+  for (guint i = 0; i < BENCH_SCHEDULE_SYNC_CALLS; i++)
+  {
+    const gint64 start = g_get_monotonic_time();
+
+    schedule_sync_run(&(bench.app.ui.schedule), _bench_sync_call, NULL);
+
+    bench_histogram_add(&(bench.sync), g_get_monotonic_time() - start);
+  }
+
+  bench.priority = MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE;
+
+  _bench_next_phase(cls);
+}
+
+static void*
+_bench_thread(UNUSED void *args)
+{
+  GNUNET_SCHEDULER_run(_bench_run, NULL);
+  return NULL;
+}
+
+int
+main(UNUSED int argc,
+     UNUSED char **argv)
+{
+  const gchar *lanes [MESSENGER_SCHEDULE_PRIORITY_COUNT] = {
+    "async interactive", "async media", "async bulk"
+  };
+
+  memset(&bench, 0, sizeof(bench));
+
+  bench_histogram_init(&(bench.sync));
+
+  for (guint i = 0; i < MESSENGER_SCHEDULE_PRIORITY_COUNT; i++)
+    bench_histogram_init(&(bench.async[i]));
+
+  bench_histogram_init(&(bench.locks));
+  bench_histogram_init(&(bench.delays));
+
+  bench.stamps = g_new0(gint64, BENCH_SCHEDULE_ASYNC_CALLS);
+
+  // Same setup as the application: the UI schedule gets handled by
+  // the main loop and the detached chat schedule by the thread
+  // running the GNUnet scheduler
+  schedule_init(&(bench.app.chat.schedule));
+  schedule_init(&(bench.app.ui.schedule));
+
+  schedule_detach_queue(&(bench.app.chat.schedule));
+  schedule_load_glib(&(bench.app.ui.schedule));
+
+  bench.loop = g_main_loop_new(NULL, FALSE);
+
+  const gint64 start = g_get_monotonic_time();
+
+  g_assert(0 == pthread_create(&(bench.tid), NULL, _bench_thread, NULL));
+  g_main_loop_run(bench.loop);
+  g_assert(0 == pthread_join(bench.tid, NULL));
+
+  const gint64 end = g_get_monotonic_time();
+
+  g_print(
+    "schedule (spin limit %d, %s)\n",
+    MESSENGER_SEMAPHORE_SPIN_LIMIT,
+#ifdef MESSENGER_APPLICATION_NO_EVENT_FD
+    "pipe"
+#else
+    "eventfd"
+#endif
+  );
+
+  bench_histogram_print(&(bench.sync), "sync latency", "us");
+
+  for (guint i = 0; i < MESSENGER_SCHEDULE_PRIORITY_COUNT; i++)
+  {
+    bench_histogram_print(&(bench.async[i]), lanes[i], "us");
+    bench_print_rate(lanes[i], BENCH_SCHEDULE_ASYNC_CALLS, bench.duration[i]);
+  }
+
+  bench_print_rate(
+    "events under contention",
+    BENCH_SCHEDULE_EVENTS,
+    bench.contention_end - bench.contention_start
+  );
+
+  bench_histogram_print(&(bench.locks), "chat lock under contention", "us");
+  bench_histogram_print(&(bench.delays), "command delay", "us");
+
+  g_print("commands: %u\n", bench.commands);
+
+  const MESSENGER_ScheduleStats *stats = &(bench.app.ui.schedule.queue.stats);
+
+  bench_print_rate("total", stats->calls, end - start);
+
+  g_print(
+    "batches: %" G_GUINT64_FORMAT ", longest batch %" G_GINT64_FORMAT
+    " us, longest delay until idle %" G_GINT64_FORMAT " us\n",
+    stats->batches,
+    stats->longest_batch,
+    stats->longest_idle_delay
+  );
+
+  g_main_loop_unref(bench.loop);
+
+  schedule_cleanup(&(bench.app.chat.schedule));
+  schedule_cleanup(&(bench.app.ui.schedule));
+
+  g_free(bench.stamps);
+  return 0;
+}
@@ -23,6 +23,7 @@
  */
 
 #include "application.h"
+#include "event.h"
 #include "request.h"
 #include "resources.h"
 
@@ -190,6 +191,17 @@ _application_open(GApplication* application,
   g_application_release(application);
 }
 
+static void
+_application_read_receipt(gpointer cls,
+                          struct GNUNET_CHAT_Message *message)
+{
+  g_assert((cls) && (message));
+
+  MESSENGER_Application *app = (MESSENGER_Application*) cls;
+
+  event_update_read_receipt(app, message);
+}
+
 void
 application_init(MESSENGER_Application *app,
                  int argc,
@@ -241,6 +253,19 @@ application_init(MESSENGER_Application *app,
   schedule_init(&(app->chat.schedule));
   schedule_init(&(app->ui.schedule));
 
+  // Commands from the UI should not wait for the messenger service
+  schedule_detach_queue(&(app->chat.schedule));
+
+  snapshot_init(
+    &(app->chat.snapshot),
+    &(app->ui.schedule),
+    _application_read_receipt,
+    app
+  );
+
+  index_init(&(app->ui.index));
+  roster_init(&(app->ui.roster));
+
   app->chat.status = EXIT_FAILURE;
   app->chat.tid = 0;
 
@@ -526,6 +551,7 @@ _application_event_call(gpointer user_data)
 
 void
 application_call_event(MESSENGER_Application *app,
+                       MESSENGER_SchedulePriority priority,
                        MESSENGER_ApplicationEvent event)
 {
   g_assert((app) && (event));
@@ -539,8 +565,9 @@ application_call_event(MESSENGER_Application *app,
   call->app = app;
   call->event = event;
 
-  schedule_sync_run(
+  schedule_async_run(
     &(app->ui.schedule),
+    priority,
     G_SOURCE_FUNC(_application_event_call),
     call
   );
@@ -609,6 +636,7 @@ _application_message_event_call(gpointer user_data)
 
 void
 application_call_message_event(MESSENGER_Application *app,
+                               MESSENGER_SchedulePriority priority,
                                MESSENGER_ApplicationMessageEvent event,
                                struct GNUNET_CHAT_Context *context,
                                struct GNUNET_CHAT_Message *message)
@@ -627,6 +655,34 @@ application_call_message_event(MESSENGER_Application *app,
   call->context = context;
   call->message = message;
 
+  schedule_async_run(
+    &(app->ui.schedule),
+    priority,
+    G_SOURCE_FUNC(_application_message_event_call),
+    call
+  );
+}
+
+void
+application_call_sync_message_event(MESSENGER_Application *app,
+                                    MESSENGER_ApplicationMessageEvent event,
+                                    struct GNUNET_CHAT_Context *context,
+                                    struct GNUNET_CHAT_Message *message)
+{
+  g_assert((app) && (event) && (message));
+
+  MESSENGER_ApplicationMessageEventCall *call;
+
+  call = (MESSENGER_ApplicationMessageEventCall*) GNUNET_malloc(
+    sizeof(MESSENGER_ApplicationMessageEventCall)
+  );
+
+  call->app = app;
+  call->event = event;
+
+  call->context = context;
+  call->message = message;
+
   schedule_sync_run(
     &(app->ui.schedule),
     G_SOURCE_FUNC(_application_message_event_call),
@@ -639,7 +695,9 @@ application_chat_lock(MESSENGER_Application *app)
 {
   g_assert(app);
 
-  if (app->ui.schedule.function)
+  // The messenger thread is blocked already while it waits for the UI
+  if ((app->ui.schedule.function) ||
+      (g_atomic_int_get(&(app->ui.schedule.waiting))))
   {
     g_assert(!(app->chat.schedule.locked));
     return;
@@ -653,7 +711,8 @@ application_chat_unlock(MESSENGER_Application *app)
 {
   g_assert(app);
 
-  if (app->ui.schedule.function)
+  if ((app->ui.schedule.function) ||
+      (g_atomic_int_get(&(app->ui.schedule.waiting))))
   {
     g_assert(!(app->chat.schedule.locked));
     return;
@@ -687,9 +746,17 @@ application_exit(MESSENGER_Application *app,
     app
   );
 
+  schedule_log_stats(&(app->chat.schedule), "chat");
+  schedule_log_stats(&(app->ui.schedule), "ui");
+  util_scheduler_log_stats();
+
   schedule_cleanup(&(app->chat.schedule));
   schedule_cleanup(&(app->ui.schedule));
 
+  snapshot_cleanup(&(app->chat.snapshot));
+  index_cleanup(&(app->ui.index));
+  roster_cleanup(&(app->ui.roster));
+
   util_scheduler_cleanup();
 
   media_pw_cleanup(&(app->media.camera));
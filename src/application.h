@@ -55,8 +55,11 @@
 #include "ui/send_file.h"
 #include "ui/settings.h"
 
+#include "index.h"
 #include "media.h"
+#include "roster.h"
 #include "schedule.h"
+#include "snapshot.h"
 #include "util.h"
 
 #define MESSENGER_APPLICATION_APPNAME "GNUnet Messenger"
@@ -122,6 +125,7 @@ typedef struct MESSENGER_Application
     CHAT_MESSENGER_Handle messenger;
 
     MESSENGER_Schedule schedule;
+    MESSENGER_Snapshot snapshot;
   } chat;
 
   struct {
@@ -151,6 +155,8 @@ typedef struct MESSENGER_Application
     UI_SETTINGS_Handle settings;
 
     MESSENGER_Schedule schedule;
+    MESSENGER_Index index;
+    MESSENGER_Roster roster;
   } ui;
 
   struct {
@@ -283,13 +289,17 @@ typedef void (*MESSENGER_ApplicationMessageEvent) (
 
 /**
  * Calls a given event with the messenger application
- * asyncronously but explicitly synchronized via mutex.
+ * asyncronously. The event gets queued and handled
+ * as part of a batch while the GNUnet scheduler waits
+ * for the whole batch to complete.
  *
  * @param app Messenger application
+ * @param priority Schedule priority
  * @param event Event
  */
 void
 application_call_event(MESSENGER_Application *app,
+                       MESSENGER_SchedulePriority priority,
                        MESSENGER_ApplicationEvent event);
 
 /**
@@ -305,20 +315,39 @@ application_call_sync_event(MESSENGER_Application *app,
 
 /**
  * Calls a given message event with the messenger
- * application asyncronously but explicitly synchronized
- * via mutex.
+ * application asyncronously. The event gets queued
+ * and handled as part of a batch while the GNUnet
+ * scheduler waits for the whole batch to complete.
  *
  * @param app Messenger application
+ * @param priority Schedule priority
  * @param event Message event
  * @param context Chat context
  * @param message Message
  */
 void
 application_call_message_event(MESSENGER_Application *app,
+                               MESSENGER_SchedulePriority priority,
                                MESSENGER_ApplicationMessageEvent event,
                                struct GNUNET_CHAT_Context *context,
                                struct GNUNET_CHAT_Message *message);
 
+/**
+ * Calls a given message event with the messenger
+ * application syncronously after all previously
+ * queued events.
+ *
+ * @param app Messenger application
+ * @param event Message event
+ * @param context Chat context
+ * @param message Message
+ */
+void
+application_call_sync_message_event(MESSENGER_Application *app,
+                                    MESSENGER_ApplicationMessageEvent event,
+                                    struct GNUNET_CHAT_Context *context,
+                                    struct GNUNET_CHAT_Message *message);
+
 /**
  * Lock the thread of the GNUnet scheduler
  * until it gets unlocked again.
@@ -24,9 +24,332 @@
 
 #include "messenger.h"
 
+#include "../command.h"
 #include "../event.h"
 #include <gnunet/gnunet_chat_lib.h>
 
+typedef struct CHAT_MESSENGER_CoalesceEvent
+{
+  enum GNUNET_CHAT_MessageKind kind;
+  struct GNUNET_CHAT_Context *context;
+  struct GNUNET_CHAT_Contact *contact;
+
+  MESSENGER_ApplicationMessageEvent event;
+  struct GNUNET_CHAT_Message *message;
+} CHAT_MESSENGER_CoalesceEvent;
+
+static guint
+_coalesce_event_hash(gconstpointer key)
+{
+  const CHAT_MESSENGER_CoalesceEvent *coalesce = key;
+
+  guint hash = g_direct_hash(coalesce->context);
+  hash = (hash * 31) + g_direct_hash(coalesce->contact);
+  hash = (hash * 31) + (guint) coalesce->kind;
+
+  return hash;
+}
+
+static gboolean
+_coalesce_event_equal(gconstpointer a,
+                      gconstpointer b)
+{
+  const CHAT_MESSENGER_CoalesceEvent *coalesce_a = a;
+  const CHAT_MESSENGER_CoalesceEvent *coalesce_b = b;
+
+  return (
+    (coalesce_a->kind == coalesce_b->kind) &&
+    (coalesce_a->context == coalesce_b->context) &&
+    (coalesce_a->contact == coalesce_b->contact)
+  );
+}
+
+typedef struct CHAT_MESSENGER_BulkRelease
+{
+  MESSENGER_Application *app;
+  struct GNUNET_CHAT_Context *context;
+} CHAT_MESSENGER_BulkRelease;
+
+static gboolean
+_chat_messenger_release_bulk(gpointer user_data)
+{
+  g_assert(user_data);
+
+  CHAT_MESSENGER_BulkRelease *release = user_data;
+  CHAT_MESSENGER_Handle *chat = &(release->app->chat.messenger);
+
+  if (!(chat->bulk_pending))
+    goto skip_release;
+
+  const guint count = GPOINTER_TO_UINT(
+    g_hash_table_lookup(chat->bulk_pending, release->context)
+  );
+
+  if (count > 1)
+    g_hash_table_insert(
+      chat->bulk_pending,
+      release->context,
+      GUINT_TO_POINTER(count - 1)
+    );
+  else
+    g_hash_table_remove(chat->bulk_pending, release->context);
+
+skip_release:
+  g_free(release);
+  return FALSE;
+}
+
+static gboolean
+_chat_messenger_release_bulk_later(gpointer user_data)
+{
+  g_assert(user_data);
+
+  CHAT_MESSENGER_BulkRelease *release = user_data;
+
+  // All bulk events of the context before got handled by now
+  schedule_async_run(
+    &(release->app->chat.schedule),
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    _chat_messenger_release_bulk,
+    release
+  );
+
+  return FALSE;
+}
+
+static void
+_chat_messenger_call_event(MESSENGER_Application *app,
+                           MESSENGER_SchedulePriority priority,
+                           MESSENGER_ApplicationMessageEvent event,
+                           struct GNUNET_CHAT_Context *context,
+                           struct GNUNET_CHAT_Message *message)
+{
+  g_assert((app) && (event) && (message));
+
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  const guint count = context? GPOINTER_TO_UINT(
+    g_hash_table_lookup(chat->bulk_pending, context)
+  ) : 0;
+
+  // Events must not overtake earlier events of the same context
+  if (count)
+    priority = MESSENGER_SCHEDULE_PRIORITY_BULK;
+
+  application_call_message_event(app, priority, event, context, message);
+
+  if ((!context) || (MESSENGER_SCHEDULE_PRIORITY_BULK != priority))
+    return;
+
+  g_hash_table_insert(
+    chat->bulk_pending,
+    context,
+    GUINT_TO_POINTER(count + 1)
+  );
+
+  CHAT_MESSENGER_BulkRelease *release = g_new(CHAT_MESSENGER_BulkRelease, 1);
+
+  release->app = app;
+  release->context = context;
+
+  schedule_async_run(
+    &(app->ui.schedule),
+    MESSENGER_SCHEDULE_PRIORITY_BULK,
+    _chat_messenger_release_bulk_later,
+    release
+  );
+}
+
+static void
+_chat_messenger_forward_coalesced(MESSENGER_Application *app,
+                                  MESSENGER_SchedulePriority priority,
+                                  struct GNUNET_CHAT_Context *context)
+{
+  g_assert(app);
+
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+  GList *link = chat->coalesce_queue.head;
+
+  while (link)
+  {
+    CHAT_MESSENGER_CoalesceEvent *coalesce = link->data;
+    GList *next = link->next;
+
+    if ((context) && (coalesce->context != context))
+      goto skip_event;
+
+    _chat_messenger_call_event(
+      app,
+      priority,
+      coalesce->event,
+      coalesce->context,
+      coalesce->message
+    );
+
+    g_hash_table_remove(chat->coalesce_map, coalesce);
+    g_queue_delete_link(&(chat->coalesce_queue), link);
+
+    g_free(coalesce);
+
+  skip_event:
+    link = next;
+  }
+}
+
+static void
+_chat_messenger_coalesce_task(void *cls)
+{
+  g_assert(cls);
+
+  MESSENGER_Application *app = (MESSENGER_Application*) cls;
+
+  app->chat.messenger.coalesce_task = NULL;
+
+  _chat_messenger_forward_coalesced(
+    app,
+    MESSENGER_SCHEDULE_PRIORITY_BULK,
+    NULL
+  );
+}
+
+static void
+_chat_messenger_coalesce_event(MESSENGER_Application *app,
+                               MESSENGER_ApplicationMessageEvent event,
+                               enum GNUNET_CHAT_MessageKind kind,
+                               struct GNUNET_CHAT_Context *context,
+                               struct GNUNET_CHAT_Message *message)
+{
+  g_assert((app) && (event) && (message));
+
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+  CHAT_MESSENGER_CoalesceEvent key;
+
+  key.kind = kind;
+  key.context = context;
+  key.contact = GNUNET_CHAT_message_get_sender(message);
+
+  CHAT_MESSENGER_CoalesceEvent *coalesce = g_hash_table_lookup(
+    chat->coalesce_map, &key
+  );
+
+  // Only the latest message of a pending event needs to be handled
+  if (coalesce)
+  {
+    coalesce->event = event;
+    coalesce->message = message;
+    return;
+  }
+
+  coalesce = g_new(CHAT_MESSENGER_CoalesceEvent, 1);
+
+  *coalesce = key;
+  coalesce->event = event;
+  coalesce->message = message;
+
+  g_hash_table_add(chat->coalesce_map, coalesce);
+  g_queue_push_tail(&(chat->coalesce_queue), coalesce);
+
+  if (chat->coalesce_task)
+    return;
+
+  chat->coalesce_task = GNUNET_SCHEDULER_add_delayed(
+    GNUNET_TIME_relative_multiply(
+      GNUNET_TIME_UNIT_MILLISECONDS,
+      CHAT_MESSENGER_COALESCE_DELAY
+    ),
+    _chat_messenger_coalesce_task,
+    app
+  );
+}
+
+static void
+_chat_messenger_add_entry(MESSENGER_Application *app,
+                          struct GNUNET_CHAT_Context *context)
+{
+  g_assert(app);
+
+  // Same condition as for creating chat entries when loading the profile
+  if ((!context) || (GNUNET_SYSERR == GNUNET_CHAT_context_get_status(context)))
+    return;
+
+  g_hash_table_add(app->chat.messenger.entries, context);
+}
+
+static int
+_chat_messenger_iterate_contacts(void *cls,
+                                 UNUSED struct GNUNET_CHAT_Handle *handle,
+                                 struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((cls) && (contact));
+
+  MESSENGER_Application *app = (MESSENGER_Application*) cls;
+
+  // Blocked states need to be published before the profile gets loaded
+  snapshot_mark_contact(&(app->chat.snapshot), contact);
+
+  _chat_messenger_add_entry(app, GNUNET_CHAT_contact_get_context(contact));
+  return GNUNET_YES;
+}
+
+static int
+_chat_messenger_iterate_groups(void *cls,
+                               UNUSED struct GNUNET_CHAT_Handle *handle,
+                               struct GNUNET_CHAT_Group *group)
+{
+  g_assert((cls) && (group));
+
+  MESSENGER_Application *app = (MESSENGER_Application*) cls;
+  struct GNUNET_CHAT_Context *context = GNUNET_CHAT_group_get_context(group);
+
+  // Member counts need to be published before the profile gets loaded
+  if (context)
+    snapshot_mark_context(&(app->chat.snapshot), context);
+
+  _chat_messenger_add_entry(app, context);
+  return GNUNET_YES;
+}
+
+static void
+_chat_messenger_filtered_event(MESSENGER_Application *app,
+                               MESSENGER_ApplicationMessageEvent event,
+                               struct GNUNET_CHAT_Context *context,
+                               struct GNUNET_CHAT_Message *message)
+{
+  g_assert((app) && (event) && (message));
+
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  // Events of contexts without any chat entry would be dropped anyway
+  if ((context) && (!g_hash_table_contains(chat->entries, context)))
+    return;
+
+  _chat_messenger_call_event(
+    app,
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    event,
+    context,
+    message
+  );
+}
+
+static void
+_chat_messenger_destructive_event(MESSENGER_Application *app,
+                                  MESSENGER_ApplicationMessageEvent event,
+                                  struct GNUNET_CHAT_Context *context,
+                                  struct GNUNET_CHAT_Message *message)
+{
+  g_assert((app) && (event) && (message));
+
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  if ((context) && (!g_hash_table_contains(chat->entries, context)))
+    return;
+
+  // Queued events may still refer to the target, so all of them
+  // need to be handled before the chat library may release it
+  application_call_sync_message_event(app, event, context, message);
+}
+
 static int
 _chat_messenger_message(void *cls,
                         struct GNUNET_CHAT_Context *context,
@@ -35,25 +358,60 @@ _chat_messenger_message(void *cls,
   g_assert((cls) && (message));
 
   MESSENGER_Application *app = (MESSENGER_Application*) cls;
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+  MESSENGER_Snapshot *snapshot = &(app->chat.snapshot);
+
+  const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(
+    message
+  );
+
+  const enum GNUNET_GenericReturnValue deleted = (
+    GNUNET_CHAT_message_is_deleted(message)
+  );
+
+  // Changes need to be marked before any of their events get enqueued
+  if (context)
+    snapshot_mark_context(snapshot, context);
+
+  // Any message from another member may update its read receipts
+  if ((context) && (GNUNET_YES != GNUNET_CHAT_message_is_sent(message)))
+    snapshot_mark_receipts(snapshot, context);
 
-  if (GNUNET_YES == GNUNET_CHAT_message_is_deleted(message))
+  // Keep the order of events regarding the same context
+  if ((context) && ((GNUNET_YES == deleted) || (
+      (GNUNET_CHAT_KIND_UPDATE_CONTEXT != kind) &&
+      (GNUNET_CHAT_KIND_JOIN != kind) &&
+      (GNUNET_CHAT_KIND_LEAVE != kind) &&
+      (GNUNET_CHAT_KIND_CONTACT != kind) &&
+      (GNUNET_CHAT_KIND_SHARED_ATTRIBUTES != kind))))
+    _chat_messenger_forward_coalesced(
+        app,
+        MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+        context
+    );
+
+  if (GNUNET_YES == deleted)
   {
-    application_call_message_event(
+    snapshot_drop_message(snapshot, context, message);
+
+    _chat_messenger_destructive_event(
         app,
         event_delete_message,
         context,
         message
     );
 
+    command_drop_target(app, message);
     goto skip_message_handling;
   }
 
   // Handle each kind of message as proper event regarding context
-  switch (GNUNET_CHAT_message_get_kind(message))
+  switch (kind)
   {
     case GNUNET_CHAT_KIND_WARNING:
-      application_call_message_event(
+      _chat_messenger_call_event(
       	  app,
+      	  MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
       	  event_handle_warning,
       	  context,
       	  message
@@ -61,24 +419,59 @@ _chat_messenger_message(void *cls,
       break;
     case GNUNET_CHAT_KIND_REFRESH:
     {
-      application_call_event(app, event_refresh_accounts);
+      application_call_event(
+          app,
+          MESSENGER_SCHEDULE_PRIORITY_BULK,
+          event_refresh_accounts
+      );
       break;
     }
     case GNUNET_CHAT_KIND_LOGIN:
     {
-      application_call_event(app, event_update_profile);
+      // Chat entries need to exist before filtering further events
+      _chat_messenger_forward_coalesced(
+          app,
+          MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+          NULL
+      );
+
+      GNUNET_CHAT_iterate_contacts(
+          chat->handle,
+          _chat_messenger_iterate_contacts,
+          app
+      );
+
+      GNUNET_CHAT_iterate_groups(
+          chat->handle,
+          _chat_messenger_iterate_groups,
+          app
+      );
+
+      application_call_sync_event(app, event_update_profile);
       break;
     }
     case GNUNET_CHAT_KIND_LOGOUT:
     {
+      _chat_messenger_forward_coalesced(
+          app,
+          MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+          NULL
+      );
+
       application_call_sync_event(app, event_cleanup_profile);
+
+      g_hash_table_remove_all(chat->entries);
+
+      // All objects of the account get dropped after logout
+      command_drop_target(app, NULL);
       break;
     }
     case GNUNET_CHAT_KIND_CREATED_ACCOUNT:
     case GNUNET_CHAT_KIND_UPDATE_ACCOUNT:
     {
-      application_call_message_event(
+      _chat_messenger_call_event(
           app,
+          MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
           event_select_profile,
           context,
           message
@@ -87,9 +480,10 @@ _chat_messenger_message(void *cls,
     }
     case GNUNET_CHAT_KIND_UPDATE_CONTEXT:
     {
-      application_call_message_event(
+      _chat_messenger_coalesce_event(
           app,
           event_update_chats,
+          kind,
           context,
           message
       );
@@ -98,31 +492,72 @@ _chat_messenger_message(void *cls,
     case GNUNET_CHAT_KIND_JOIN:
     case GNUNET_CHAT_KIND_LEAVE:
     {
-      application_call_message_event(
-      	  app,
-      	  (GNUNET_YES == GNUNET_CHAT_message_is_sent(message)?
-      	      event_update_chats :
-      	      event_presence_contact
-      	  ),
-      	  context,
-      	  message
+      snapshot_mark_contact(snapshot, GNUNET_CHAT_message_get_sender(message));
+
+      if (GNUNET_YES != GNUNET_CHAT_message_is_sent(message))
+      {
+        // Only the latest presence of a contact gets displayed
+        _chat_messenger_coalesce_event(
+            app,
+            event_presence_contact,
+            GNUNET_CHAT_KIND_JOIN,
+            context,
+            message
+        );
+        break;
+      }
+
+      _chat_messenger_forward_coalesced(
+          app,
+          MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+          context
       );
+
+      if ((context) && (GNUNET_CHAT_KIND_JOIN == kind))
+        g_hash_table_add(chat->entries, context);
+
+      // Joining creates a chat entry, leaving drops the context afterwards
+      application_call_sync_message_event(
+          app,
+          event_update_chats,
+          context,
+          message
+      );
+
+      if ((!context) || (GNUNET_CHAT_KIND_LEAVE != kind))
+        break;
+
+      g_hash_table_remove(chat->entries, context);
+
+      struct GNUNET_CHAT_Contact *contact;
+      contact = GNUNET_CHAT_context_get_contact(context);
+
+      // Leaving the chat with a contact may delete the contact
+      if (contact)
+        command_drop_target(app, contact);
+
+      command_drop_target(app, context);
       break;
     }
     case GNUNET_CHAT_KIND_CONTACT:
     case GNUNET_CHAT_KIND_SHARED_ATTRIBUTES:
     {
-      application_call_message_event(
-      	  app,
-      	  event_update_contacts,
-      	  context,
-      	  message
+      snapshot_mark_contact(snapshot, GNUNET_CHAT_message_get_sender(message));
+
+      _chat_messenger_coalesce_event(
+          app,
+          event_update_contacts,
+          kind,
+          context,
+          message
       );
       break;
     }
     case GNUNET_CHAT_KIND_INVITATION:
     {
-      application_call_message_event(
+      snapshot_mark_message(snapshot, context, message);
+
+      _chat_messenger_filtered_event(
           app,
           event_invitation,
           context,
@@ -133,7 +568,9 @@ _chat_messenger_message(void *cls,
     case GNUNET_CHAT_KIND_TEXT:
     case GNUNET_CHAT_KIND_FILE:
     {
-      application_call_message_event(
+      snapshot_mark_message(snapshot, context, message);
+
+      _chat_messenger_filtered_event(
           app,
           event_receive_message,
           context,
@@ -146,19 +583,26 @@ _chat_messenger_message(void *cls,
       struct GNUNET_CHAT_Message *target;
       target = GNUNET_CHAT_message_get_target(message);
 
-      if (target) 
-        application_call_message_event(
-            app,
-            event_delete_message,
-            context,
-            target
-        );
+      if (!target)
+        break;
+
+      snapshot_drop_message(snapshot, context, target);
+
+      _chat_messenger_destructive_event(
+          app,
+          event_delete_message,
+          context,
+          target
+      );
+
+      command_drop_target(app, target);
       break;
     }
     case GNUNET_CHAT_KIND_TAG:
     {
-      application_call_message_event(
+      _chat_messenger_call_event(
       	  app,
+      	  MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
       	  event_tag_message,
       	  context,
       	  message
@@ -167,13 +611,18 @@ _chat_messenger_message(void *cls,
     }
     case GNUNET_CHAT_KIND_ATTRIBUTES:
     {
-      application_call_event(app, event_update_attributes);
+      application_call_event(
+          app,
+          MESSENGER_SCHEDULE_PRIORITY_BULK,
+          event_update_attributes
+      );
       break;
     }
     case GNUNET_CHAT_KIND_DISCOURSE:
     {
-      application_call_message_event(
+      _chat_messenger_call_event(
           app,
+          MESSENGER_SCHEDULE_PRIORITY_MEDIA,
           event_discourse,
           context,
           message
@@ -182,8 +631,9 @@ _chat_messenger_message(void *cls,
     }
     case GNUNET_CHAT_KIND_DATA:
     {
-      application_call_message_event(
+      _chat_messenger_call_event(
           app,
+          MESSENGER_SCHEDULE_PRIORITY_MEDIA,
           event_discourse_data,
           context,
           message
@@ -198,6 +648,31 @@ skip_message_handling:
   return GNUNET_YES;
 }
 
+static void
+_chat_messenger_shutdown(void *cls)
+{
+  g_assert(cls);
+
+  MESSENGER_Application *app = (MESSENGER_Application*) cls;
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  if (chat->coalesce_task)
+    GNUNET_SCHEDULER_cancel(chat->coalesce_task);
+
+  chat->coalesce_task = NULL;
+
+  g_queue_clear_full(&(chat->coalesce_queue), g_free);
+  g_hash_table_destroy(chat->coalesce_map);
+  g_hash_table_destroy(chat->bulk_pending);
+  g_hash_table_destroy(chat->entries);
+  g_hash_table_destroy(chat->dropped);
+
+  chat->coalesce_map = NULL;
+  chat->bulk_pending = NULL;
+  chat->entries = NULL;
+  chat->dropped = NULL;
+}
+
 void
 chat_messenger_run(void *cls,
                    UNUSED char *const *args,
@@ -207,6 +682,24 @@ chat_messenger_run(void *cls,
   g_assert((cls) && (cfg));
 
   MESSENGER_Application *app = (MESSENGER_Application*) cls;
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  chat->coalesce_map = g_hash_table_new(
+    _coalesce_event_hash,
+    _coalesce_event_equal
+  );
+
+  g_queue_init(&(chat->coalesce_queue));
+  chat->coalesce_task = NULL;
+
+  chat->bulk_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  chat->entries = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  chat->dropped = g_hash_table_new(g_direct_hash, g_direct_equal);
+  chat->dropped_all = 0;
+
+  GNUNET_SCHEDULER_add_shutdown(_chat_messenger_shutdown, app);
 
   schedule_load_gnunet(&(app->chat.schedule));
 
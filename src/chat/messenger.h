@@ -25,13 +25,31 @@
 #ifndef CHAT_MESSENGER_H_
 #define CHAT_MESSENGER_H_
 
+#include <glib-2.0/glib.h>
 #include <gnunet/gnunet_chat_lib.h>
 
+#define CHAT_MESSENGER_COALESCE_DELAY 50 // in milliseconds
+
 typedef struct MESSENGER_Application MESSENGER_Application;
 
 typedef struct CHAT_MESSENGER_Handle
 {
   struct GNUNET_CHAT_Handle *handle;
+
+  GHashTable *coalesce_map;
+  GQueue coalesce_queue;
+
+  struct GNUNET_SCHEDULER_Task *coalesce_task;
+
+  // Contexts with events still pending in the bulk lane
+  GHashTable *bulk_pending;
+
+  // Contexts which may have a chat entry in the UI
+  GHashTable *entries;
+
+  // Targets of pending commands which got dropped
+  GHashTable *dropped;
+  guint dropped_all;
 } CHAT_MESSENGER_Handle;
 
 /**
@@ -0,0 +1,376 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file command.c
+ */
+
+#include "command.h"
+
+static MESSENGER_Command*
+_command_new(MESSENGER_Application *application,
+             MESSENGER_CommandType type,
+             MESSENGER_CommandCallback callback,
+             gpointer user_data)
+{
+  g_assert(application);
+
+  MESSENGER_Command *command = g_new0(MESSENGER_Command, 1);
+
+  command->application = application;
+  command->type = type;
+
+  command->callback = callback;
+  command->user_data = user_data;
+  command->success = FALSE;
+
+  return command;
+}
+
+static void
+_command_delete(MESSENGER_Command *command)
+{
+  g_assert(command);
+
+  if (command->text)
+    g_free(command->text);
+
+  g_free(command);
+}
+
+static gboolean
+_command_complete(gpointer user_data)
+{
+  g_assert(user_data);
+
+  MESSENGER_Command *command = (MESSENGER_Command*) user_data;
+
+  command->callback(
+    command->application,
+    command->success,
+    command->user_data
+  );
+
+  _command_delete(command);
+  return FALSE;
+}
+
+typedef struct MESSENGER_CommandRelease
+{
+  MESSENGER_Application *application;
+  gconstpointer target;
+} MESSENGER_CommandRelease;
+
+static gboolean
+_command_release(gpointer user_data)
+{
+  g_assert(user_data);
+
+  MESSENGER_CommandRelease *release = (MESSENGER_CommandRelease*) user_data;
+  CHAT_MESSENGER_Handle *chat = &(release->application->chat.messenger);
+
+  if (!(chat->dropped))
+    goto skip_release;
+
+  if (!(release->target))
+  {
+    chat->dropped_all--;
+    goto skip_release;
+  }
+
+  const guint count = GPOINTER_TO_UINT(
+    g_hash_table_lookup(chat->dropped, release->target)
+  );
+
+  if (count > 1)
+    g_hash_table_insert(
+      chat->dropped,
+      (gpointer) release->target,
+      GUINT_TO_POINTER(count - 1)
+    );
+  else
+    g_hash_table_remove(chat->dropped, release->target);
+
+skip_release:
+  g_free(release);
+  return FALSE;
+}
+
+static gboolean
+_command_is_dropped(const CHAT_MESSENGER_Handle *chat,
+                    gconstpointer target)
+{
+  g_assert(chat);
+
+  if ((!target) || (!(chat->dropped)))
+    return FALSE;
+
+  if (chat->dropped_all)
+    return TRUE;
+
+  return g_hash_table_contains(chat->dropped, target);
+}
+
+static gboolean
+_command_execute(gpointer user_data)
+{
+  g_assert(user_data);
+
+  MESSENGER_Command *command = (MESSENGER_Command*) user_data;
+  MESSENGER_Application *app = command->application;
+  CHAT_MESSENGER_Handle *chat = &(app->chat.messenger);
+
+  enum GNUNET_GenericReturnValue result = GNUNET_OK;
+
+  // Targets may have been dropped since the command got posted
+  if ((_command_is_dropped(chat, command->context)) ||
+      (_command_is_dropped(chat, command->contact)) ||
+      (_command_is_dropped(chat, command->message)))
+  {
+    result = GNUNET_SYSERR;
+    goto skip_execution;
+  }
+
+  switch (command->type)
+  {
+    case MESSENGER_COMMAND_SEND_TEXT:
+      result = GNUNET_CHAT_context_send_text(
+        command->context,
+        command->text
+      );
+      break;
+    case MESSENGER_COMMAND_SEND_TAG:
+      result = GNUNET_CHAT_context_send_tag(
+        command->context,
+        command->message,
+        command->text
+      );
+      break;
+    case MESSENGER_COMMAND_DELETE_MESSAGE:
+      result = GNUNET_CHAT_message_delete(
+        command->message,
+        command->delay
+      );
+      break;
+    case MESSENGER_COMMAND_BLOCK_CONTACT:
+      GNUNET_CHAT_contact_set_blocked(command->contact, GNUNET_YES);
+      snapshot_mark_contact(&(app->chat.snapshot), command->contact);
+      break;
+    case MESSENGER_COMMAND_UNBLOCK_CONTACT:
+      GNUNET_CHAT_contact_set_blocked(command->contact, GNUNET_NO);
+      snapshot_mark_contact(&(app->chat.snapshot), command->contact);
+      break;
+    case MESSENGER_COMMAND_ACCEPT_INVITATION:
+      GNUNET_CHAT_invitation_accept(
+        GNUNET_CHAT_message_get_invitation(command->message)
+      );
+      break;
+    case MESSENGER_COMMAND_REJECT_INVITATION:
+      GNUNET_CHAT_invitation_reject(
+        GNUNET_CHAT_message_get_invitation(command->message)
+      );
+      break;
+    default:
+      result = GNUNET_SYSERR;
+      break;
+  }
+
+skip_execution:
+  command->success = (GNUNET_OK == result);
+
+  // Completion gets delivered back to the main loop of the UI
+  if (command->callback)
+    schedule_async_run(
+      &(app->ui.schedule),
+      MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+      _command_complete,
+      command
+    );
+  else
+    _command_delete(command);
+
+  return FALSE;
+}
+
+static void
+_command_post(MESSENGER_Command *command)
+{
+  g_assert(command);
+
+  MESSENGER_Application *app = command->application;
+
+  schedule_async_run(
+    &(app->chat.schedule),
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    _command_execute,
+    command
+  );
+}
+
+void
+command_drop_target(MESSENGER_Application *application,
+                    gconstpointer target)
+{
+  g_assert(application);
+
+  CHAT_MESSENGER_Handle *chat = &(application->chat.messenger);
+
+  if (!target)
+    chat->dropped_all++;
+  else
+    g_hash_table_insert(
+      chat->dropped,
+      (gpointer) target,
+      GUINT_TO_POINTER(GPOINTER_TO_UINT(
+        g_hash_table_lookup(chat->dropped, target)
+      ) + 1)
+    );
+
+  MESSENGER_CommandRelease *release = g_new(MESSENGER_CommandRelease, 1);
+
+  release->application = application;
+  release->target = target;
+
+  // The UI handled the event notifying it already, so any command
+  // posted before it noticed the drop is queued in front of this
+  schedule_async_run(
+    &(application->chat.schedule),
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    _command_release,
+    release
+  );
+}
+
+void
+command_send_text(MESSENGER_Application *application,
+                  struct GNUNET_CHAT_Context *context,
+                  const gchar *text,
+                  MESSENGER_CommandCallback callback,
+                  gpointer user_data)
+{
+  g_assert((application) && (context) && (text));
+
+  MESSENGER_Command *command = _command_new(
+    application,
+    MESSENGER_COMMAND_SEND_TEXT,
+    callback,
+    user_data
+  );
+
+  command->context = context;
+  command->text = g_strdup(text);
+
+  _command_post(command);
+}
+
+void
+command_send_tag(MESSENGER_Application *application,
+                 struct GNUNET_CHAT_Context *context,
+                 struct GNUNET_CHAT_Message *message,
+                 const gchar *tag,
+                 MESSENGER_CommandCallback callback,
+                 gpointer user_data)
+{
+  g_assert((application) && (context) && (message) && (tag));
+
+  MESSENGER_Command *command = _command_new(
+    application,
+    MESSENGER_COMMAND_SEND_TAG,
+    callback,
+    user_data
+  );
+
+  command->context = context;
+  command->message = message;
+  command->text = g_strdup(tag);
+
+  _command_post(command);
+}
+
+void
+command_delete_message(MESSENGER_Application *application,
+                       struct GNUNET_CHAT_Message *message,
+                       gulong delay,
+                       MESSENGER_CommandCallback callback,
+                       gpointer user_data)
+{
+  g_assert((application) && (message));
+
+  MESSENGER_Command *command = _command_new(
+    application,
+    MESSENGER_COMMAND_DELETE_MESSAGE,
+    callback,
+    user_data
+  );
+
+  command->context = GNUNET_CHAT_message_get_context(message);
+  command->message = message;
+  command->delay = delay;
+
+  _command_post(command);
+}
+
+void
+command_set_blocked(MESSENGER_Application *application,
+                    struct GNUNET_CHAT_Contact *contact,
+                    gboolean blocked,
+                    MESSENGER_CommandCallback callback,
+                    gpointer user_data)
+{
+  g_assert((application) && (contact));
+
+  MESSENGER_Command *command = _command_new(
+    application,
+    blocked?
+    MESSENGER_COMMAND_BLOCK_CONTACT :
+    MESSENGER_COMMAND_UNBLOCK_CONTACT,
+    callback,
+    user_data
+  );
+
+  command->contact = contact;
+
+  _command_post(command);
+}
+
+void
+command_handle_invitation(MESSENGER_Application *application,
+                          struct GNUNET_CHAT_Message *message,
+                          gboolean accept,
+                          MESSENGER_CommandCallback callback,
+                          gpointer user_data)
+{
+  g_assert((application) && (message));
+
+  MESSENGER_Command *command = _command_new(
+    application,
+    accept?
+    MESSENGER_COMMAND_ACCEPT_INVITATION :
+    MESSENGER_COMMAND_REJECT_INVITATION,
+    callback,
+    user_data
+  );
+
+  // Messages get dropped with their context as well
+  command->context = GNUNET_CHAT_message_get_context(message);
+  command->message = message;
+
+  _command_post(command);
+}
@@ -0,0 +1,174 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file command.h
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include "application.h"
+
+#include <gnunet/gnunet_chat_lib.h>
+
+typedef enum MESSENGER_CommandType
+{
+  MESSENGER_COMMAND_SEND_TEXT = 1,
+  MESSENGER_COMMAND_SEND_TAG = 2,
+  MESSENGER_COMMAND_DELETE_MESSAGE = 3,
+  MESSENGER_COMMAND_BLOCK_CONTACT = 4,
+  MESSENGER_COMMAND_UNBLOCK_CONTACT = 5,
+  MESSENGER_COMMAND_ACCEPT_INVITATION = 6,
+  MESSENGER_COMMAND_REJECT_INVITATION = 7,
+} MESSENGER_CommandType;
+
+typedef void (*MESSENGER_CommandCallback)(
+  MESSENGER_Application *application,
+  gboolean success,
+  gpointer user_data
+);
+
+typedef struct MESSENGER_Command
+{
+  MESSENGER_Application *application;
+  MESSENGER_CommandType type;
+
+  struct GNUNET_CHAT_Context *context;
+  struct GNUNET_CHAT_Contact *contact;
+  struct GNUNET_CHAT_Message *message;
+
+  gchar *text;
+  gulong delay;
+
+  MESSENGER_CommandCallback callback;
+  gpointer user_data;
+  gboolean success;
+} MESSENGER_Command;
+
+/**
+ * Marks a target of commands as dropped, so that
+ * commands posted before the UI noticed it fail
+ * instead of accessing the target. The mark gets
+ * released once these commands got handled. This
+ * needs to be called from the messenger thread
+ * after the event notifying the UI got handled
+ * synchronously.
+ *
+ * @param application Messenger application
+ * @param target Target of commands or NULL for all targets
+ */
+void
+command_drop_target(MESSENGER_Application *application,
+                    gconstpointer target);
+
+/**
+ * Posts a command to send a text message in a
+ * given chat context without waiting for the
+ * messenger service.
+ *
+ * @param application Messenger application
+ * @param context Chat context
+ * @param text Text
+ * @param callback Callback (optional)
+ * @param user_data User data (optional)
+ */
+void
+command_send_text(MESSENGER_Application *application,
+                  struct GNUNET_CHAT_Context *context,
+                  const gchar *text,
+                  MESSENGER_CommandCallback callback,
+                  gpointer user_data);
+
+/**
+ * Posts a command to tag a given message in a
+ * chat context without waiting for the messenger
+ * service.
+ *
+ * @param application Messenger application
+ * @param context Chat context
+ * @param message Chat message
+ * @param tag Tag
+ * @param callback Callback (optional)
+ * @param user_data User data (optional)
+ */
+void
+command_send_tag(MESSENGER_Application *application,
+                 struct GNUNET_CHAT_Context *context,
+                 struct GNUNET_CHAT_Message *message,
+                 const gchar *tag,
+                 MESSENGER_CommandCallback callback,
+                 gpointer user_data);
+
+/**
+ * Posts a command to delete a given message
+ * after a delay without waiting for the messenger
+ * service.
+ *
+ * @param application Messenger application
+ * @param message Chat message
+ * @param delay Delay
+ * @param callback Callback (optional)
+ * @param user_data User data (optional)
+ */
+void
+command_delete_message(MESSENGER_Application *application,
+                       struct GNUNET_CHAT_Message *message,
+                       gulong delay,
+                       MESSENGER_CommandCallback callback,
+                       gpointer user_data);
+
+/**
+ * Posts a command to block or unblock a given
+ * contact without waiting for the messenger
+ * service.
+ *
+ * @param application Messenger application
+ * @param contact Chat contact
+ * @param blocked TRUE to block, FALSE to unblock
+ * @param callback Callback (optional)
+ * @param user_data User data (optional)
+ */
+void
+command_set_blocked(MESSENGER_Application *application,
+                    struct GNUNET_CHAT_Contact *contact,
+                    gboolean blocked,
+                    MESSENGER_CommandCallback callback,
+                    gpointer user_data);
+
+/**
+ * Posts a command to accept or reject the invitation
+ * of a given message without waiting for the
+ * messenger service.
+ *
+ * @param application Messenger application
+ * @param message Chat message
+ * @param accept TRUE to accept, FALSE to reject
+ * @param callback Callback (optional)
+ * @param user_data User data (optional)
+ */
+void
+command_handle_invitation(MESSENGER_Application *application,
+                          struct GNUNET_CHAT_Message *message,
+                          gboolean accept,
+                          MESSENGER_CommandCallback callback,
+                          gpointer user_data);
+
+#endif /* COMMAND_H_ */
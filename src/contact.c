@@ -292,7 +292,7 @@ skip_comparison:
   info->icon = g_file_icon_new(file_object);
 
   if (!(info->task))
-    info->task = util_idle_add(G_SOURCE_FUNC(_task_update_avatars), info);
+    info->task = util_frame_add(G_SOURCE_FUNC(_task_update_avatars), info);
 }
 
 static enum GNUNET_GenericReturnValue
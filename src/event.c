@@ -26,6 +26,7 @@
 
 #include "account.h"
 #include "application.h"
+#include "command.h"
 #include "contact.h"
 #include "discourse.h"
 #include "file.h"
@@ -183,10 +184,10 @@ _select_chat_to_activate(gpointer user_data)
 
   UI_CHAT_ENTRY_Handle *entry = (UI_CHAT_ENTRY_Handle*) user_data;
 
-  if ((!entry) || (!(entry->chat)) || (!(entry->entry_box)))
+  if ((!entry) || (!(entry->entry_box)))
     return FALSE;
 
-  MESSENGER_Application *app = entry->chat->app;
+  MESSENGER_Application *app = entry->app;
 
   if (!app)
     return FALSE;
@@ -216,11 +217,11 @@ _idle_chat_entry_update(gpointer user_data)
 
   UI_CHAT_ENTRY_Handle *entry = (UI_CHAT_ENTRY_Handle*) user_data;
 
-  if ((!(entry->chat)) || (!(entry->chat->app)) ||
-      (!(entry->chat->send_text_view)))
+  if ((!(entry->app)) ||
+      ((entry->chat) && (!(entry->chat->send_text_view))))
     goto update_exit;
 
-  ui_chat_entry_update(entry, entry->chat->app);
+  ui_chat_entry_update(entry, entry->app);
 
 update_exit:
   entry->update = 0;
@@ -232,10 +233,11 @@ enqueue_chat_entry_update(UI_CHAT_ENTRY_Handle *entry)
 {
   g_assert(entry);
 
+  // Entries only need to be updated once per frame
   if (entry->update)
-    util_source_remove(entry->update);
+    return;
 
-  entry->update = util_idle_add(
+  entry->update = util_frame_add(
     G_SOURCE_FUNC(_idle_chat_entry_update),
     entry
   );
@@ -254,17 +256,7 @@ _add_new_chat_entry(MESSENGER_Application *app,
 
   gtk_container_add(GTK_CONTAINER(ui->chats_listbox), entry->entry_box);
 
-  gtk_container_add(
-    GTK_CONTAINER(ui->chats_stack),
-    entry->chat->chat_box
-  );
-
-  gtk_container_add(
-    GTK_CONTAINER(ui->chat_title_stack),
-    entry->chat->title->chat_title_box
-  );
-
-  ui->chat_entries = g_list_append(ui->chat_entries, entry);
+  ui_messenger_add_chat_entry(ui, entry);
 
   GtkWidget *row = gtk_widget_get_parent(entry->entry_box);
 
@@ -292,6 +284,8 @@ _iterate_profile_contacts(void *cls,
 
   MESSENGER_Application *app = (MESSENGER_Application*) cls;
 
+  roster_update_contact(&(app->ui.roster), contact);
+
   struct GNUNET_CHAT_Context *context = GNUNET_CHAT_contact_get_context(
     contact
   );
@@ -353,6 +347,9 @@ event_update_profile(MESSENGER_Application *app)
 
   ui_label_set_text(ui->profile_key_label, key);
 
+  if (key)
+    index_open(&(app->ui.index), key);
+
   gtk_stack_set_visible_child(ui->chats_stack, ui->no_chat_box);
   
   GList *children = gtk_container_get_children(GTK_CONTAINER(ui->leaflet_chat));
@@ -430,8 +427,13 @@ event_cleanup_profile(MESSENGER_Application *app)
   g_list_foreach(entries, (GFunc) _clear_chat_entry, app);
   g_list_free(entries);
 
+  roster_clear(&(app->ui.roster));
+
   GNUNET_CHAT_iterate_contacts(chat->handle, _cleanup_profile_contacts, NULL);
   GNUNET_CHAT_iterate_files(chat->handle, _cleanup_profile_files, NULL);
+
+  snapshot_clear(&(app->chat.snapshot));
+  index_close(&(app->ui.index));
 }
 
 void
@@ -461,10 +463,17 @@ _delayed_context_drop(gpointer user_data)
   struct GNUNET_CHAT_Group *group = GNUNET_CHAT_context_get_group(context);
   struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_context_get_contact(context);
 
+  UI_CHAT_ENTRY_Handle *entry = GNUNET_CHAT_context_get_user_pointer(context);
+
   if (group)
     GNUNET_CHAT_group_leave(group);
   else if (contact)
+  {
+    if (entry)
+      roster_remove_contact(&(entry->app->ui.roster), contact);
+
     GNUNET_CHAT_contact_delete(contact);
+  }
 
   // TODO: schedule_sync_unlock(&(app->chat.schedule));
 
@@ -484,6 +493,14 @@ event_update_chats(MESSENGER_Application *app,
     msg
   );
 
+  struct GNUNET_CHAT_Contact *context_contact = GNUNET_CHAT_context_get_contact(
+    context
+  );
+
+  // Contacts only leave the roster when they get deleted
+  if (GNUNET_CHAT_KIND_LEAVE != kind)
+    roster_update_contact(&(app->ui.roster), context_contact);
+
   if (GNUNET_CHAT_KIND_JOIN == kind)
   {
     if (!handle)
@@ -532,28 +549,49 @@ _update_contact_context(struct GNUNET_CHAT_Contact *contact)
   enqueue_chat_entry_update(handle);
 }
 
-void
-event_presence_contact(MESSENGER_Application *app,
-                       struct GNUNET_CHAT_Context *context,
-                       struct GNUNET_CHAT_Message *msg)
+static const char*
+_get_presence_text(const struct GNUNET_CHAT_Message *msg)
 {
-  g_assert((app) && (context) && (msg));
+  const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(
+    msg
+  );
 
-  UI_CHAT_ENTRY_Handle *handle = GNUNET_CHAT_context_get_user_pointer(context);
+  return (
+    GNUNET_CHAT_KIND_JOIN == kind? _("joined the chat") : _("left the chat")
+  );
+}
 
-  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_message_get_sender(
+static void
+_set_message_timestamp(UI_MESSAGE_Handle *message,
+                       const struct GNUNET_CHAT_Message *msg)
+{
+  char time [20];
+  time_t timestamp = GNUNET_CHAT_message_get_timestamp(
     msg
   );
 
-  if (!contact)
-    return;
+  strftime(time, 20, "%Y-%m-%d %H:%M:%S", localtime(&timestamp));
 
-  contact_create_info(contact);
+  ui_label_set_text(message->timestamp_label, time);
+}
 
-  if (!handle)
-    return;
+static gboolean
+_render_presence_message(MESSENGER_Application *app,
+                         UI_CHAT_ENTRY_Handle *handle,
+                         struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (handle) && (handle->chat) && (msg));
 
-  struct GNUNET_CHAT_Group *group = GNUNET_CHAT_context_get_group(context);
+  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_message_get_sender(
+    msg
+  );
+
+  if (!contact)
+    return FALSE;
+
+  struct GNUNET_CHAT_Group *group = GNUNET_CHAT_context_get_group(
+    handle->context
+  );
 
   UI_MESSAGE_Handle *message = NULL;
   gboolean previous_presence = FALSE;
@@ -574,21 +612,60 @@ event_presence_contact(MESSENGER_Application *app,
   message = ui_message_new(app, UI_MESSAGE_STATUS);
   ui_message_update(message, app, msg);
 
-  contact_update_attributes(contact, app);
-  _update_contact_context(contact);
-
   ui_message_set_contact(message, contact);
 
-  const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(
+  ui_label_set_text(message->text_label, _get_presence_text(msg));
+  _set_message_timestamp(message, msg);
+
+  ui_chat_add_message(handle->chat, app, message);
+
+  if (group)
+    GNUNET_CHAT_member_set_user_pointer(group, contact, message);
+  else
+    contact_set_last_message_to_info(contact, message);
+
+  return previous_presence;
+}
+
+void
+event_presence_contact(MESSENGER_Application *app,
+                       struct GNUNET_CHAT_Context *context,
+                       struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (context) && (msg));
+
+  UI_CHAT_ENTRY_Handle *handle = GNUNET_CHAT_context_get_user_pointer(context);
+
+  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_message_get_sender(
     msg
   );
 
-  const char *text = (
-    GNUNET_CHAT_KIND_JOIN == kind? _("joined the chat") : _("left the chat")
-  );
+  if (!contact)
+    return;
+
+  contact_create_info(contact);
+  roster_update_contact(&(app->ui.roster), contact);
+
+  if (!handle)
+    return;
+
+  contact_update_attributes(contact, app);
+  _update_contact_context(contact);
+
+  const char *text = _get_presence_text(msg);
+  gboolean previous_presence;
+
+  if (handle->chat)
+    previous_presence = _render_presence_message(app, handle, msg);
+  else
+  {
+    previous_presence = ui_chat_entry_drop_deferred_presence(handle, contact);
+    ui_chat_entry_defer_message(handle, msg, text);
+  }
 
   if ((!ui_messenger_is_context_active(&(app->ui.messenger), context)) &&
-      ((!previous_presence) || (GNUNET_CHAT_KIND_LEAVE == kind)) &&
+      ((!previous_presence) ||
+       (GNUNET_CHAT_KIND_LEAVE == GNUNET_CHAT_message_get_kind(msg))) &&
       (GNUNET_YES == GNUNET_CHAT_message_is_recent(msg)))
     _show_notification(
       app,
@@ -599,28 +676,11 @@ event_presence_contact(MESSENGER_Application *app,
       "presence.online"
     );
 
-  char time [20];
-  time_t timestamp = GNUNET_CHAT_message_get_timestamp(
-    msg
-  );
-
-  strftime(time, 20, "%Y-%m-%d %H:%M:%S", localtime(&timestamp));
-
-  ui_label_set_text(message->text_label, text);
-  ui_label_set_text(message->timestamp_label, time);
-
-  ui_chat_add_message(handle->chat, app, message);
-
-  if (group)
-    GNUNET_CHAT_member_set_user_pointer(group, contact, message);
-  else
-    contact_set_last_message_to_info(contact, message);
-
   enqueue_chat_entry_update(handle);
 }
 
 void
-event_update_contacts(UNUSED MESSENGER_Application *app,
+event_update_contacts(MESSENGER_Application *app,
                       struct GNUNET_CHAT_Context *context,
                       struct GNUNET_CHAT_Message *msg)
 {
@@ -639,6 +699,8 @@ event_update_contacts(UNUSED MESSENGER_Application *app,
   contact_update_info(contact);
   _update_contact_context(contact);
 
+  roster_update_contact(&(app->ui.roster), contact);
+
   if (!context)
     return;
 
@@ -657,18 +719,73 @@ _event_invitation_action(MESSENGER_Application *app,
 {
   g_assert((app) && (user_data));
 
-  struct GNUNET_CHAT_Invitation *invitation = (
-    (struct GNUNET_CHAT_Invitation*) user_data
+  struct GNUNET_CHAT_Message *msg = (
+    (struct GNUNET_CHAT_Message*) user_data
+  );
+
+  command_handle_invitation(app, msg, status, NULL, NULL);
+}
+
+static gchar*
+_get_invitation_text(struct GNUNET_CHAT_Message *msg,
+                     struct GNUNET_CHAT_Invitation *invitation)
+{
+  g_assert((msg) && (invitation));
+
+  struct GNUNET_CHAT_Contact *recipient = GNUNET_CHAT_message_get_recipient(
+    msg
   );
 
-  application_chat_lock(app);
+  const char *invite_message = (
+    GNUNET_YES != GNUNET_CHAT_invitation_is_direct(invitation)
+  )? _("invited %s to a chat") : _("requested %s to chat");
 
-  if (status)
-    GNUNET_CHAT_invitation_accept(invitation);
-  else
-    GNUNET_CHAT_invitation_reject(invitation);
+  const char *recipient_name = (
+    (recipient) && 
+    (GNUNET_YES != GNUNET_CHAT_contact_is_owned(recipient))
+  )? GNUNET_CHAT_contact_get_name(recipient) : _("you");
+
+  GString *message_string = g_string_new(NULL);
+  g_string_printf(message_string, invite_message, recipient_name);
 
-  application_chat_unlock(app);
+  return g_string_free(message_string, FALSE);
+}
+
+static void
+_render_invitation_message(MESSENGER_Application *app,
+                           UI_CHAT_ENTRY_Handle *handle,
+                           struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (handle) && (handle->chat) && (msg));
+
+  struct GNUNET_CHAT_Invitation *invitation;
+  invitation = GNUNET_CHAT_message_get_invitation(msg);
+
+  if (!invitation)
+    return;
+
+  UI_MESSAGE_Handle *message = GNUNET_CHAT_message_get_user_pointer(msg);
+
+  if (message)
+  {
+    ui_message_update(message, app, msg);
+    return;
+  }
+
+  message = ui_message_new(app, UI_MESSAGE_STATUS);
+  ui_message_update(message, app, msg);
+
+  ui_message_set_contact(message, GNUNET_CHAT_message_get_sender(msg));
+
+  gchar *text = _get_invitation_text(msg, invitation);
+  ui_label_set_text(message->text_label, text);
+  g_free(text);
+
+  ui_message_set_status_callback(
+    message, _event_invitation_action, msg
+  );
+
+  ui_chat_add_message(handle->chat, app, message);
 }
 
 void
@@ -689,78 +806,80 @@ event_invitation(MESSENGER_Application *app,
   if (!invitation)
     return;
 
-  UI_MESSAGE_Handle *message = GNUNET_CHAT_message_get_user_pointer(msg);
-  enum GNUNET_GenericReturnValue new_message = GNUNET_NO;
+  if ((GNUNET_CHAT_message_get_user_pointer(msg)) ||
+      ((!(handle->chat)) && (ui_chat_entry_is_deferred(handle, msg))))
+    goto update_message;
 
-  if (!message)
-  {
-    if (app->settings.delete_invitations_delay > 0)
-      GNUNET_CHAT_message_delete(
-        msg,
-        app->settings.delete_invitations_delay
-      );
+  if (app->settings.delete_invitations_delay > 0)
+    GNUNET_CHAT_message_delete(
+      msg,
+      app->settings.delete_invitations_delay
+    );
 
-    const enum GNUNET_GenericReturnValue sent =
-      GNUNET_CHAT_message_is_sent(msg);
+  const enum GNUNET_GenericReturnValue sent =
+    GNUNET_CHAT_message_is_sent(msg);
 
-    if ((GNUNET_YES != sent) && (app->settings.send_read_receipts))
-      GNUNET_CHAT_context_send_read_receipt(context, msg);
+  if ((GNUNET_YES != sent) && (app->settings.send_read_receipts))
+    GNUNET_CHAT_context_send_read_receipt(context, msg);
 
-    message = ui_message_new(app, UI_MESSAGE_STATUS);
-    new_message = GNUNET_YES;
-  }
+  gchar *text = _get_invitation_text(msg, invitation);
 
-  if (!message)
-    return;
+  if ((!ui_messenger_is_context_active(&(app->ui.messenger), context)) &&
+      (GNUNET_YES == GNUNET_CHAT_message_is_recent(msg)))
+    _show_notification(
+      app,
+      context,
+      GNUNET_CHAT_message_get_sender(msg),
+      text,
+      "mail-message-new-symbolic",
+      "im.received"
+    );
 
-  ui_message_update(message, app, msg);
+  if (!(handle->chat))
+    ui_chat_entry_defer_message(handle, msg, text);
 
-  if (GNUNET_YES == new_message)
-  {
-    struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(
-      msg
-    );
+  g_free(text);
 
-    struct GNUNET_CHAT_Contact *recipient = GNUNET_CHAT_message_get_recipient(
-      msg
-    );
+update_message:
+  if (handle->chat)
+    _render_invitation_message(app, handle, msg);
 
-    ui_message_set_contact(message, sender);
-
-    const char *invite_message = (
-      GNUNET_YES != GNUNET_CHAT_invitation_is_direct(invitation)
-    )? _("invited %s to a chat") : _("requested %s to chat");
-
-    const char *recipient_name = (
-      (recipient) && 
-      (GNUNET_YES != GNUNET_CHAT_contact_is_owned(recipient))
-    )? GNUNET_CHAT_contact_get_name(recipient) : _("you");
-
-    GString *message_string = g_string_new(NULL);
-    g_string_printf(message_string, invite_message, recipient_name);
-
-    if ((!ui_messenger_is_context_active(&(app->ui.messenger), context)) &&
-        (GNUNET_YES == GNUNET_CHAT_message_is_recent(msg)))
-      _show_notification(
-        app,
-        context,
-        sender,
-        message_string->str,
-        "mail-message-new-symbolic",
-        "im.received"
-      );
+  enqueue_chat_entry_update(handle);
+}
 
-    ui_label_set_text(message->text_label, message_string->str);
-    g_string_free(message_string, TRUE);
+static void
+_render_received_message(MESSENGER_Application *app,
+                         UI_CHAT_ENTRY_Handle *handle,
+                         struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (handle) && (handle->chat) && (msg));
 
-    ui_message_set_status_callback(
-      message, _event_invitation_action, invitation
-    );
+  const UI_MESSAGE_Type type = (
+    GNUNET_YES == GNUNET_CHAT_message_is_sent(msg)?
+    UI_MESSAGE_SENT : UI_MESSAGE_DEFAULT
+  );
+
+  UI_MESSAGE_Handle *message = ui_message_new(app, type);
 
-    ui_chat_add_message(handle->chat, app, message);
+  struct GNUNET_CHAT_File *file = GNUNET_CHAT_message_get_file(msg);
+
+  if (file)
+  {
+    file_create_info(file);
+    file_add_ui_message_to_info(file, message);
   }
 
-  enqueue_chat_entry_update(handle);
+  ui_message_update(message, app, msg);
+
+  ui_message_set_contact(message, GNUNET_CHAT_message_get_sender(msg));
+
+  gtk_label_set_markup(
+    message->text_label,
+    ui_chat_get_message_markup(handle->chat, msg)
+  );
+  _set_message_timestamp(message, msg);
+
+  ui_chat_add_message(handle->chat, app, message);
 }
 
 void
@@ -791,18 +910,11 @@ event_receive_message(MESSENGER_Application *app,
   if ((GNUNET_YES != sent) && (app->settings.send_read_receipts))
     GNUNET_CHAT_context_send_read_receipt(context, msg);
 
-  const UI_MESSAGE_Type type = (
-    GNUNET_YES == sent? UI_MESSAGE_SENT : UI_MESSAGE_DEFAULT
-  );
-
-  UI_MESSAGE_Handle *message = ui_message_new(app, type);
-
   struct GNUNET_CHAT_File *file = GNUNET_CHAT_message_get_file(msg);
 
   if (file)
   {
     file_create_info(file);
-    file_add_ui_message_to_info(file, message);
 
     if (app->settings.delete_files_delay > 0)
       GNUNET_CHAT_message_delete(
@@ -811,37 +923,28 @@ event_receive_message(MESSENGER_Application *app,
       );
   }
 
-  ui_message_update(message, app, msg);
-
-  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_message_get_sender(
-    msg
-  );
-
-  ui_message_set_contact(message, contact);
-
-  char time [20];
-  time_t timestamp = GNUNET_CHAT_message_get_timestamp(
-    msg
-  );
-
-  strftime(time, 20, "%Y-%m-%d %H:%M:%S", localtime(&timestamp));
-
   if ((!ui_messenger_is_context_active(&(app->ui.messenger), context)) &&
       (GNUNET_YES == GNUNET_CHAT_message_is_recent(msg)) &&
       (GNUNET_YES != sent))
     _show_notification(
       app,
       context,
-      contact,
+      GNUNET_CHAT_message_get_sender(msg),
       text,
       "mail-unread-symbolic",
       "im.received"
     );
 
-  ui_label_set_markup_text(message->text_label, text);
-  ui_label_set_text(message->timestamp_label, time);
+  index_add_message(&(app->ui.index), context, msg);
 
-  ui_chat_add_message(handle->chat, app, message);
+  if (handle->chat)
+    _render_received_message(app, handle, msg);
+  else
+    ui_chat_entry_defer_message(
+      handle,
+      msg,
+      text? text : (file? GNUNET_CHAT_file_get_name(file) : NULL)
+    );
 
 skip_message:
   enqueue_chat_entry_update(handle);
@@ -862,26 +965,7 @@ _find_ui_message_handle(MESSENGER_Application *app,
   UI_MESSAGE_Handle *message = GNUNET_CHAT_message_get_user_pointer(msg);
 
   if (!message)
-  {
-    GList *rows = gtk_container_get_children(
-      GTK_CONTAINER(handle->chat->messages_listbox)
-    );
-
-    for (GList *row = rows; row; row = row->next)
-    {
-      message = (UI_MESSAGE_Handle*) g_object_get_qdata(
-        G_OBJECT(row->data), app->quarks.ui
-      );
-
-      if ((message) && (message->msg == msg))
-        break;
-
-      message = NULL;
-    }
-
-    if (rows)
-      g_list_free(rows);
-  }
+    message = ui_chat_get_message(handle->chat, msg);
 
   return message;
 }
@@ -912,13 +996,19 @@ _event_update_tag_message_state(MESSENGER_Application *app,
 
   UI_MESSAGE_Handle *message = _find_ui_message_handle(app, context, target);
 
+  // Tags of messages without any row only change the search index
   if (!message)
+  {
+    ui_chat_index_history(handle->chat, target);
     return;
+  }
 
   if (GNUNET_YES == GNUNET_CHAT_message_is_deleted(msg))
     ui_message_remove_tag(message, app, msg);
   else
     ui_message_add_tag(message, app, msg);
+
+  ui_chat_index_message(handle->chat, message);
 }
 
 void
@@ -930,20 +1020,49 @@ event_delete_message(MESSENGER_Application *app,
 
   UI_CHAT_ENTRY_Handle *handle = GNUNET_CHAT_context_get_user_pointer(context);
 
-  if ((!handle) || (!(handle->chat)))
+  if (!handle)
     return;
 
+  index_drop_message(&(app->ui.index), context, msg);
+
+  if (!(handle->chat))
+  {
+    ui_chat_entry_drop_deferred(handle, msg);
+    goto update_entry;
+  }
+
   UI_MESSAGE_Handle *message = _find_ui_message_handle(app, context, msg);
 
   if (message)
     ui_chat_remove_message(handle->chat, app, message);
 
+  ui_chat_forget_message(handle->chat, msg);
+
   if (GNUNET_CHAT_KIND_TAG == GNUNET_CHAT_message_get_kind(msg))
     _event_update_tag_message_state(app, context, msg);
 
+update_entry:
   enqueue_chat_entry_update(handle);
 }
 
+static void
+_render_tag_message(MESSENGER_Application *app,
+                    struct GNUNET_CHAT_Context *context,
+                    struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (context) && (msg));
+
+  struct GNUNET_CHAT_Message *target = GNUNET_CHAT_message_get_target(msg);
+
+  if (!target)
+    return;
+
+  UI_MESSAGE_Handle *message = _find_ui_message_handle(app, context, target);
+
+  if (message)
+    ui_message_update(message, app, message->msg);
+}
+
 void
 event_tag_message(MESSENGER_Application *app,
                   struct GNUNET_CHAT_Context *context,
@@ -953,21 +1072,74 @@ event_tag_message(MESSENGER_Application *app,
 
   UI_CHAT_ENTRY_Handle *handle = GNUNET_CHAT_context_get_user_pointer(context);
 
-  struct GNUNET_CHAT_Message *target = GNUNET_CHAT_message_get_target(msg);
-
   _event_update_tag_message_state(app, context, msg);
 
-  if ((!handle) || (!(handle->chat)))
-    return;
+  // Tags of a contact get stored in the chat with the contact
+  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_context_get_contact(
+    context
+  );
 
-  UI_MESSAGE_Handle *message = _find_ui_message_handle(app, context, target);
+  if (contact)
+    roster_update_contact(&(app->ui.roster), contact);
 
-  if (message)
-    ui_message_update(message, app, message->msg);
+  if (!handle)
+    return;
+
+  if (handle->chat)
+    _render_tag_message(app, context, msg);
+  else
+    ui_chat_entry_defer_message(handle, msg, NULL);
 
   enqueue_chat_entry_update(handle);
 }
 
+void
+event_render_message(MESSENGER_Application *app,
+                     struct GNUNET_CHAT_Context *context,
+                     struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (context) && (msg));
+
+  UI_CHAT_ENTRY_Handle *handle = GNUNET_CHAT_context_get_user_pointer(context);
+
+  if ((!handle) || (!(handle->chat)) ||
+      (GNUNET_YES == GNUNET_CHAT_message_is_deleted(msg)))
+    return;
+
+  switch (GNUNET_CHAT_message_get_kind(msg))
+  {
+    case GNUNET_CHAT_KIND_JOIN:
+    case GNUNET_CHAT_KIND_LEAVE:
+      _render_presence_message(app, handle, msg);
+      break;
+    case GNUNET_CHAT_KIND_INVITATION:
+      _render_invitation_message(app, handle, msg);
+      break;
+    case GNUNET_CHAT_KIND_TEXT:
+    case GNUNET_CHAT_KIND_FILE:
+      _render_received_message(app, handle, msg);
+      break;
+    case GNUNET_CHAT_KIND_TAG:
+      _event_update_tag_message_state(app, context, msg);
+      _render_tag_message(app, context, msg);
+      break;
+    default:
+      break;
+  }
+}
+
+void
+event_update_read_receipt(MESSENGER_Application *app,
+                          struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((app) && (msg));
+
+  UI_MESSAGE_Handle *message = GNUNET_CHAT_message_get_user_pointer(msg);
+
+  if (message)
+    ui_message_refresh(message);
+}
+
 static enum GNUNET_GenericReturnValue
 _iterate_contacts_update_own(void *cls,
                              UNUSED struct GNUNET_CHAT_Handle *handle,
@@ -175,6 +175,33 @@ event_tag_message(MESSENGER_Application *app,
                   struct GNUNET_CHAT_Context *context,
                   struct GNUNET_CHAT_Message *msg);
 
+/**
+ * Renders a message into the chat of a given context
+ * which has been deferred before the chat view got
+ * created. Notifications and other side effects of
+ * the message have been handled by its event already.
+ *
+ * @param app Messenger application
+ * @param context Chat context
+ * @param msg Deferred message
+ */
+void
+event_render_message(MESSENGER_Application *app,
+                     struct GNUNET_CHAT_Context *context,
+                     struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Updates the read receipt of a message in the
+ * messenger application after it has been read
+ * by someone or lost all of its read receipts.
+ *
+ * @param app Messenger application
+ * @param msg Chat message
+ */
+void
+event_update_read_receipt(MESSENGER_Application *app,
+                          struct GNUNET_CHAT_Message *msg);
+
 /**
  * Event for the UI to be called whenever an attribute
  * gets changed.
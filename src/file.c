@@ -88,6 +88,21 @@ file_add_ui_message_to_info(const struct GNUNET_CHAT_File *file,
   info->file_messages = g_list_append(info->file_messages, message);
 }
 
+void
+file_remove_ui_message_from_info(const struct GNUNET_CHAT_File *file,
+                                 UI_MESSAGE_Handle *message)
+{
+  g_assert(message);
+
+  MESSENGER_FileInfo* info = GNUNET_CHAT_file_get_user_pointer(file);
+
+  if (!info)
+    return;
+
+  if (info->file_messages)
+    info->file_messages = g_list_remove(info->file_messages, message);
+}
+
 void
 file_add_widget_to_preview(const struct GNUNET_CHAT_File *file,
                            GtkWidget *widget)
@@ -202,7 +217,7 @@ file_update_download_info(const struct GNUNET_CHAT_File *file,
     return;
 
   info->app = app;
-  info->update_task = util_idle_add(file_update_messages, info);
+  info->update_task = util_frame_add(file_update_messages, info);
 }
 
 static void
@@ -72,6 +72,17 @@ void
 file_add_ui_message_to_info(const struct GNUNET_CHAT_File *file,
                             UI_MESSAGE_Handle *message);
 
+/**
+ * Removes a UI message handle from the list of handles
+ * which get updated by state changes.
+ *
+ * @param file Chat file
+ * @param message UI message handle
+ */
+void
+file_remove_ui_message_from_info(const struct GNUNET_CHAT_File *file,
+                                 UI_MESSAGE_Handle *message);
+
 /**
  * Adds a widget to the list of widgets which get
  * redrawn automatically when displaying an animation.
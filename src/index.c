@@ -0,0 +1,1175 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file index.c
+ */
+
+#include "index.h"
+
+#include "util.h"
+
+#include <unistd.h>
+
+#define INDEX_MAGIC "MGSI"
+#define INDEX_VERSION 2
+
+#define INDEX_GROUP_SCOPE "group"
+
+#define INDEX_RECORD_ADD 1
+#define INDEX_RECORD_DROP 2
+#define INDEX_RECORD_ERASED 3
+
+typedef struct MESSENGER_IndexCompactDoc
+{
+  guint64 fingerprint;
+  const gchar *context;
+  guint32 source;
+  MESSENGER_IndexEntry *entry;
+} MESSENGER_IndexCompactDoc;
+
+typedef struct MESSENGER_IndexMessage
+{
+  guint64 fingerprint;
+  gconstpointer context;
+} MESSENGER_IndexMessage;
+
+void
+index_init(MESSENGER_Index *index)
+{
+  g_assert(index);
+
+  memset(index, 0, sizeof(*index));
+}
+
+static gboolean
+_index_validate_base(const MESSENGER_Index *index,
+                     gsize length)
+{
+  const MESSENGER_IndexHeader *header = index->header;
+
+  if ((length < sizeof(*header)) ||
+      (0 != memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic))) ||
+      (INDEX_VERSION != header->version) ||
+      (0 == header->strings))
+    return FALSE;
+
+  const guint64 expected = (
+    sizeof(*header) +
+    (guint64) header->docs * sizeof(MESSENGER_IndexDoc) +
+    (guint64) header->terms * sizeof(MESSENGER_IndexTerm) +
+    (guint64) header->postings * sizeof(guint32) +
+    header->strings
+  );
+
+  if ((expected != length) || ('\0' != index->strings[header->strings - 1]))
+    return FALSE;
+
+  // A broken cache must not lead to reads outside of the mapping
+  for (guint32 i = 0; i < header->docs; i++)
+    if (index->docs[i].context >= header->strings)
+      return FALSE;
+
+  for (guint32 i = 0; i < header->terms; i++)
+  {
+    const MESSENGER_IndexTerm *term = &(index->terms[i]);
+
+    if ((term->token >= header->strings) ||
+        (term->postings > header->postings) ||
+        (term->count > header->postings - term->postings))
+      return FALSE;
+  }
+
+  for (guint32 i = 0; i < header->postings; i++)
+    if (index->postings[i] >= header->docs)
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+_index_map_base(MESSENGER_Index *index)
+{
+  g_assert((index) && (index->base_path));
+
+  index->mapping = g_mapped_file_new(index->base_path, FALSE, NULL);
+
+  if (!(index->mapping))
+    return;
+
+  const gsize length = g_mapped_file_get_length(index->mapping);
+  const gchar *contents = g_mapped_file_get_contents(index->mapping);
+
+  if ((!contents) || (length < sizeof(MESSENGER_IndexHeader)))
+    goto drop_base;
+
+  index->header = (const MESSENGER_IndexHeader*) contents;
+  contents += sizeof(MESSENGER_IndexHeader);
+
+  index->docs = (const MESSENGER_IndexDoc*) contents;
+  contents += (gsize) index->header->docs * sizeof(MESSENGER_IndexDoc);
+
+  index->terms = (const MESSENGER_IndexTerm*) contents;
+  contents += (gsize) index->header->terms * sizeof(MESSENGER_IndexTerm);
+
+  index->postings = (const guint32*) contents;
+  contents += (gsize) index->header->postings * sizeof(guint32);
+
+  index->strings = contents;
+
+  if (_index_validate_base(index, length))
+    return;
+
+drop_base:
+  // Changes logged for an older version can't be replayed either
+  if ((index->header) && (INDEX_VERSION != index->header->version))
+    remove(index->log_path);
+
+  g_mapped_file_unref(index->mapping);
+
+  index->mapping = NULL;
+  index->header = NULL;
+  index->docs = NULL;
+  index->terms = NULL;
+  index->postings = NULL;
+  index->strings = NULL;
+
+  remove(index->base_path);
+}
+
+static guint64*
+_index_copy_fingerprint(guint64 fingerprint)
+{
+  guint64 *copy = g_new(guint64, 1);
+
+  *copy = fingerprint;
+  return copy;
+}
+
+static gboolean
+_index_has_base_doc(const MESSENGER_Index *index,
+                    guint64 fingerprint)
+{
+  if (!(index->header))
+    return FALSE;
+
+  guint32 lower = 0;
+  guint32 upper = index->header->docs;
+
+  while (lower < upper)
+  {
+    const guint32 mid = lower + (upper - lower) / 2;
+    const guint64 value = index->docs[mid].fingerprint;
+
+    if (value == fingerprint)
+      return TRUE;
+    else if (value < fingerprint)
+      lower = mid + 1;
+    else
+      upper = mid;
+  }
+
+  return FALSE;
+}
+
+static gboolean
+_index_insert_entry(MESSENGER_Index *index,
+                    guint64 fingerprint,
+                    const gchar *context,
+                    const gchar *text,
+                    gsize record)
+{
+  if (_index_has_base_doc(index, fingerprint))
+  {
+    // Messages can arrive again after having been dropped
+    g_hash_table_remove(index->tombstones, &fingerprint);
+    return FALSE;
+  }
+
+  if (g_hash_table_contains(index->entries, &fingerprint))
+    return FALSE;
+
+  MESSENGER_IndexEntry *entry = g_new(MESSENGER_IndexEntry, 1);
+
+  entry->fingerprint = fingerprint;
+  entry->context = context;
+  entry->record = record;
+
+  g_hash_table_insert(index->entries, &(entry->fingerprint), entry);
+  search_add_text(&(index->search), entry, text);
+  return TRUE;
+}
+
+static gboolean
+_index_remove_entry(MESSENGER_Index *index,
+                    guint64 fingerprint)
+{
+  MESSENGER_IndexEntry *entry = g_hash_table_lookup(
+    index->entries, &fingerprint
+  );
+
+  if (entry)
+  {
+    search_remove_item(&(index->search), entry);
+    g_hash_table_remove(index->entries, &fingerprint);
+    return TRUE;
+  }
+
+  if ((!_index_has_base_doc(index, fingerprint)) ||
+      (g_hash_table_contains(index->tombstones, &fingerprint)))
+    return FALSE;
+
+  g_hash_table_add(index->tombstones, _index_copy_fingerprint(fingerprint));
+
+  return TRUE;
+}
+
+static void
+_index_replay_log(MESSENGER_Index *index)
+{
+  g_assert((index) && (index->log_path));
+
+  gchar *contents;
+  gsize length;
+
+  if (!g_file_get_contents(index->log_path, &contents, &length, NULL))
+    return;
+
+  gsize offset = 0;
+
+  while (offset + sizeof(MESSENGER_IndexRecord) <= length)
+  {
+    MESSENGER_IndexRecord record;
+    memcpy(&record, contents + offset, sizeof(record));
+
+    const gsize end = offset + sizeof(record) + record.length;
+
+    if ((end < offset) || (end > length))
+      break;
+
+    const gchar *payload = contents + offset + sizeof(record);
+
+    if (INDEX_RECORD_ADD == record.kind)
+    {
+      // Payloads consist of the context and the text of a message
+      const gchar *text = memchr(payload, '\0', record.length);
+
+      if ((!text) || ('\0' != payload[record.length - 1]))
+        break;
+
+      _index_insert_entry(
+        index,
+        record.fingerprint,
+        g_intern_string(payload),
+        text + 1,
+        offset
+      );
+    }
+    else if (INDEX_RECORD_DROP == record.kind)
+      _index_remove_entry(index, record.fingerprint);
+    else if (INDEX_RECORD_ERASED != record.kind)
+      break;
+
+    offset = end;
+  }
+
+  index->log_length = offset;
+
+  // Records written partially get dropped before appending new ones
+  if ((offset < length) && (0 != truncate(index->log_path, (off_t) offset)))
+  {
+    remove(index->log_path);
+    index->log_length = 0;
+  }
+
+  if (offset > 0)
+    index->changed = TRUE;
+
+  g_free(contents);
+}
+
+static void
+_index_join_compaction(MESSENGER_Index *index)
+{
+  if (!(index->compaction))
+    return;
+
+  g_thread_join(index->compaction);
+  g_free(index->compacting);
+
+  index->compaction = NULL;
+  index->compacting = NULL;
+}
+
+gboolean
+index_open(MESSENGER_Index *index,
+           const gchar *key)
+{
+  g_assert((index) && (key));
+
+  if (index->base_path)
+    index_close(index);
+
+  gchar *name = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+  gchar *directory = g_build_filename(
+    g_get_user_cache_dir(), MESSENGER_APPLICATION_ID, "search", name, NULL
+  );
+
+  g_free(name);
+
+  if (0 != g_mkdir_with_parents(directory, 0700))
+  {
+    g_free(directory);
+    return FALSE;
+  }
+
+  index->base_path = g_build_filename(directory, "index", NULL);
+  index->log_path = g_build_filename(directory, "log", NULL);
+
+  g_free(directory);
+
+  // Changes of the previous session need to be compacted first
+  if (0 == g_strcmp0(index->compacting, index->base_path))
+    _index_join_compaction(index);
+
+  search_init(&(index->search));
+
+  index->entries = g_hash_table_new_full(
+    g_int64_hash, g_int64_equal, NULL, g_free
+  );
+
+  index->tombstones = g_hash_table_new_full(
+    g_int64_hash, g_int64_equal, g_free, NULL
+  );
+
+  index->messages = g_hash_table_new_full(
+    g_direct_hash, g_direct_equal, NULL, g_free
+  );
+
+  index->contexts = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  index->owners = g_hash_table_new_full(
+    g_int64_hash, g_int64_equal, g_free, NULL
+  );
+
+  _index_map_base(index);
+  _index_replay_log(index);
+
+  index->log = fopen(index->log_path, "ab");
+  return (index->log? TRUE : FALSE);
+}
+
+static guint32
+_index_pool_string(GString *pool,
+                   GHashTable *offsets,
+                   const gchar *string)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended(offsets, string, NULL, &offset))
+    return GPOINTER_TO_UINT(offset);
+
+  const guint32 value = (guint32) pool->len;
+
+  g_string_append_len(pool, string, strlen(string) + 1);
+  g_hash_table_insert(offsets, (gpointer) string, GUINT_TO_POINTER(value));
+  return value;
+}
+
+static gint
+_index_compare_docs(gconstpointer a,
+                    gconstpointer b)
+{
+  const MESSENGER_IndexCompactDoc *doc_a = a;
+  const MESSENGER_IndexCompactDoc *doc_b = b;
+
+  if (doc_a->fingerprint < doc_b->fingerprint)
+    return -1;
+  else if (doc_a->fingerprint > doc_b->fingerprint)
+    return +1;
+  else
+    return 0;
+}
+
+static GArray*
+_index_collect_docs(const MESSENGER_Index *index)
+{
+  GArray *docs = g_array_new(FALSE, FALSE, sizeof(MESSENGER_IndexCompactDoc));
+  MESSENGER_IndexCompactDoc doc;
+
+  const guint32 base_docs = index->header? index->header->docs : 0;
+
+  for (guint32 i = 0; i < base_docs; i++)
+  {
+    doc.fingerprint = index->docs[i].fingerprint;
+
+    if (g_hash_table_contains(index->tombstones, &(doc.fingerprint)))
+      continue;
+
+    doc.context = index->strings + index->docs[i].context;
+    doc.source = i;
+    doc.entry = NULL;
+
+    g_array_append_val(docs, doc);
+  }
+
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init(&iter, index->entries);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+  {
+    doc.entry = (MESSENGER_IndexEntry*) value;
+    doc.fingerprint = doc.entry->fingerprint;
+    doc.context = doc.entry->context;
+    doc.source = G_MAXUINT32;
+
+    g_array_append_val(docs, doc);
+  }
+
+  g_array_sort(docs, _index_compare_docs);
+  return docs;
+}
+
+static gboolean
+_index_compact(const MESSENGER_Index *index)
+{
+  g_assert(index);
+
+  const guint32 base_docs = index->header? index->header->docs : 0;
+  const guint32 base_terms = index->header? index->header->terms : 0;
+
+  GArray *docs = _index_collect_docs(index);
+
+  GArray *out_docs = g_array_sized_new(
+    FALSE, FALSE, sizeof(MESSENGER_IndexDoc), docs->len
+  );
+
+  GArray *out_terms = g_array_new(FALSE, FALSE, sizeof(MESSENGER_IndexTerm));
+  GArray *out_postings = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+  GString *pool = g_string_new(NULL);
+  GHashTable *offsets = g_hash_table_new(g_str_hash, g_str_equal);
+
+  guint32 *remap = g_new(guint32, MAX(base_docs, 1));
+  GHashTable *entry_ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  for (guint32 i = 0; i < base_docs; i++)
+    remap[i] = G_MAXUINT32;
+
+  for (guint32 i = 0; i < docs->len; i++)
+  {
+    const MESSENGER_IndexCompactDoc *doc = &g_array_index(
+      docs, MESSENGER_IndexCompactDoc, i
+    );
+
+    MESSENGER_IndexDoc out;
+    out.fingerprint = doc->fingerprint;
+    out.context = _index_pool_string(pool, offsets, doc->context);
+    out.reserved = 0;
+
+    g_array_append_val(out_docs, out);
+
+    if (doc->entry)
+      g_hash_table_insert(entry_ids, doc->entry, GUINT_TO_POINTER(i));
+    else
+      remap[doc->source] = i;
+  }
+
+  // Both term lists are sorted, so they can be merged in one pass
+  guint32 t = 0;
+  GSequenceIter *iter = g_sequence_get_begin_iter(index->search.order);
+
+  while ((t < base_terms) || (!g_sequence_iter_is_end(iter)))
+  {
+    const gchar *base_token = t < base_terms?
+      index->strings + index->terms[t].token : NULL;
+    const gchar *token = g_sequence_iter_is_end(iter)?
+      NULL : (const gchar*) g_sequence_get(iter);
+
+    const gint order = (!base_token? +1 : (!token? -1 :
+      strcmp(base_token, token)
+    ));
+
+    const guint32 start = out_postings->len;
+
+    if (order <= 0)
+    {
+      const MESSENGER_IndexTerm *term = &(index->terms[t++]);
+
+      for (guint32 i = 0; i < term->count; i++)
+      {
+        const guint32 id = remap[index->postings[term->postings + i]];
+
+        if (G_MAXUINT32 != id)
+          g_array_append_val(out_postings, id);
+      }
+
+      token = base_token;
+    }
+
+    if (order >= 0)
+    {
+      const MESSENGER_SearchToken *entry = g_hash_table_lookup(
+        index->search.tokens, token
+      );
+
+      GHashTableIter items;
+      gpointer item;
+
+      g_hash_table_iter_init(&items, entry->items);
+      while (g_hash_table_iter_next(&items, &item, NULL))
+      {
+        const guint32 id = GPOINTER_TO_UINT(
+          g_hash_table_lookup(entry_ids, item)
+        );
+
+        g_array_append_val(out_postings, id);
+      }
+
+      iter = g_sequence_iter_next(iter);
+    }
+
+    if (out_postings->len == start)
+      continue;
+
+    MESSENGER_IndexTerm term;
+    term.token = _index_pool_string(pool, offsets, token);
+    term.postings = start;
+    term.count = out_postings->len - start;
+
+    g_array_append_val(out_terms, term);
+  }
+
+  MESSENGER_IndexHeader header;
+  memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+  header.version = INDEX_VERSION;
+  header.docs = out_docs->len;
+  header.terms = out_terms->len;
+  header.postings = out_postings->len;
+  header.strings = (guint32) pool->len;
+
+  gboolean result = TRUE;
+
+  if (0 == header.docs)
+    remove(index->base_path);
+  else
+  {
+    GByteArray *data = g_byte_array_new();
+
+    g_byte_array_append(data, (const guint8*) &header, sizeof(header));
+    g_byte_array_append(
+      data,
+      (const guint8*) out_docs->data,
+      out_docs->len * sizeof(MESSENGER_IndexDoc)
+    );
+    g_byte_array_append(
+      data,
+      (const guint8*) out_terms->data,
+      out_terms->len * sizeof(MESSENGER_IndexTerm)
+    );
+    g_byte_array_append(
+      data,
+      (const guint8*) out_postings->data,
+      out_postings->len * sizeof(guint32)
+    );
+    g_byte_array_append(data, (const guint8*) pool->str, pool->len);
+
+    // The new index replaces the mapped one atomically
+    result = g_file_set_contents(
+      index->base_path, (const gchar*) data->data, data->len, NULL
+    );
+
+    g_byte_array_unref(data);
+  }
+
+  g_hash_table_destroy(entry_ids);
+  g_free(remap);
+
+  g_hash_table_destroy(offsets);
+  g_string_free(pool, TRUE);
+
+  g_array_free(out_postings, TRUE);
+  g_array_free(out_terms, TRUE);
+  g_array_free(out_docs, TRUE);
+  g_array_free(docs, TRUE);
+
+  return result;
+}
+
+static void
+_index_release(MESSENGER_Index *index)
+{
+  g_hash_table_destroy(index->owners);
+  g_hash_table_destroy(index->contexts);
+  g_hash_table_destroy(index->messages);
+  g_hash_table_destroy(index->tombstones);
+  g_hash_table_destroy(index->entries);
+
+  search_cleanup(&(index->search));
+
+  if (index->mapping)
+    g_mapped_file_unref(index->mapping);
+
+  g_free(index->log_path);
+  g_free(index->base_path);
+}
+
+static gpointer
+_index_compact_thread(gpointer data)
+{
+  MESSENGER_Index *index = (MESSENGER_Index*) data;
+
+  if (_index_compact(index))
+    remove(index->log_path);
+
+  _index_release(index);
+
+  g_free(index);
+  return NULL;
+}
+
+void
+index_close(MESSENGER_Index *index)
+{
+  g_assert(index);
+
+  if (!(index->base_path))
+    return;
+
+  if (index->log)
+    fclose(index->log);
+
+  if (index->changed)
+  {
+    // Only one compaction may replace the stored files at a time
+    _index_join_compaction(index);
+
+    MESSENGER_Index *state = g_new(MESSENGER_Index, 1);
+    memcpy(state, index, sizeof(*state));
+
+    // Logging out should not wait for compacting all changes
+    index->compacting = g_strdup(index->base_path);
+    index->compaction = g_thread_new("index", _index_compact_thread, state);
+  }
+  else
+    _index_release(index);
+
+  GThread *compaction = index->compaction;
+  gchar *compacting = index->compacting;
+
+  index_init(index);
+
+  index->compaction = compaction;
+  index->compacting = compacting;
+}
+
+void
+index_cleanup(MESSENGER_Index *index)
+{
+  g_assert(index);
+
+  index_close(index);
+  _index_join_compaction(index);
+}
+
+static void
+_index_write_record(MESSENGER_Index *index,
+                    guint32 kind,
+                    guint64 fingerprint,
+                    const gchar *payload,
+                    gsize length)
+{
+  if (!(index->log))
+    return;
+
+  MESSENGER_IndexRecord record;
+  record.kind = kind;
+  record.length = (guint32) length;
+  record.fingerprint = fingerprint;
+
+  fwrite(&record, sizeof(record), 1, index->log);
+
+  if (length > 0)
+    fwrite(payload, length, 1, index->log);
+
+  index->log_length += sizeof(record) + length;
+  index->changed = TRUE;
+}
+
+static void
+_index_erase_record(MESSENGER_Index *index,
+                    gsize offset)
+{
+  fflush(index->log);
+
+  // The log only gets appended to, so records get erased separately
+  FILE *log = fopen(index->log_path, "r+b");
+
+  if (!log)
+    return;
+
+  MESSENGER_IndexRecord record;
+
+  if ((0 != fseek(log, (long) offset, SEEK_SET)) ||
+      (1 != fread(&record, sizeof(record), 1, log)) ||
+      (INDEX_RECORD_ADD != record.kind) ||
+      (0 != fseek(log, (long) offset, SEEK_SET)))
+    goto close_log;
+
+  gchar *zeros = g_malloc0(record.length);
+
+  record.kind = INDEX_RECORD_ERASED;
+
+  fwrite(&record, sizeof(record), 1, log);
+  fwrite(zeros, record.length, 1, log);
+
+  g_free(zeros);
+
+close_log:
+  fclose(log);
+}
+
+static const gchar*
+_index_get_context(MESSENGER_Index *index,
+                   struct GNUNET_CHAT_Context *context)
+{
+  const gchar *id = g_hash_table_lookup(index->contexts, context);
+
+  if (id)
+    return id;
+
+  struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_context_get_contact(
+    context
+  );
+
+  struct GNUNET_CHAT_Group *group = GNUNET_CHAT_context_get_group(context);
+
+  const char *key = contact? GNUNET_CHAT_contact_get_key(contact) : NULL;
+
+  gchar *value;
+
+  // Groups only get identified within the current session
+  if (key)
+    value = g_strdup_printf("contact:%s", key);
+  else if (group)
+    value = g_strdup_printf("%s:%u", INDEX_GROUP_SCOPE, index->groups++);
+  else
+    return NULL;
+
+  id = g_intern_string(value);
+  g_free(value);
+
+  g_hash_table_insert(index->contexts, context, (gpointer) id);
+  return id;
+}
+
+static const gchar*
+_index_resolve_context(const MESSENGER_Index *index,
+                       guint64 fingerprint,
+                       const gchar *context)
+{
+  if (0 != g_strcmp0(context, INDEX_GROUP_SCOPE))
+    return context;
+
+  // Messages of groups belong to the context they arrived in last
+  return g_hash_table_lookup(index->owners, &fingerprint);
+}
+
+static guint64
+_index_fingerprint(const gchar *context,
+                   const gchar *sender,
+                   gint64 timestamp,
+                   const gchar *text,
+                   const gchar *file)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+  const gchar *fields [] = { context, sender, text, file };
+
+  for (gsize i = 0; i < G_N_ELEMENTS(fields); i++)
+    g_checksum_update(
+      checksum,
+      (const guchar*) (fields[i]? fields[i] : ""),
+      (fields[i]? strlen(fields[i]) : 0) + 1
+    );
+
+  g_checksum_update(checksum, (const guchar*) &timestamp, sizeof(timestamp));
+
+  guint8 digest [32];
+  gsize length = sizeof(digest);
+
+  g_checksum_get_digest(checksum, digest, &length);
+  g_checksum_free(checksum);
+
+  guint64 fingerprint;
+  memcpy(&fingerprint, digest, sizeof(fingerprint));
+  return fingerprint;
+}
+
+static const gchar*
+_index_get_scope(struct GNUNET_CHAT_Context *context,
+                 const gchar *id)
+{
+  // Names of groups can change, so they stay out of stored documents
+  return GNUNET_CHAT_context_get_group(context)? INDEX_GROUP_SCOPE : id;
+}
+
+static guint64
+_index_fingerprint_message(const gchar *scope,
+                           const struct GNUNET_CHAT_Message *msg)
+{
+  struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(msg);
+  struct GNUNET_CHAT_File *file = GNUNET_CHAT_message_get_file(msg);
+
+  // Sender names can change, so only their keys identify messages
+  return _index_fingerprint(
+    scope,
+    sender? GNUNET_CHAT_contact_get_key(sender) : NULL,
+    (gint64) GNUNET_CHAT_message_get_timestamp(msg),
+    GNUNET_CHAT_message_get_text(msg),
+    file? GNUNET_CHAT_file_get_name(file) : NULL
+  );
+}
+
+void
+index_add_message(MESSENGER_Index *index,
+                  struct GNUNET_CHAT_Context *context,
+                  const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((index) && (context) && (msg));
+
+  if (!(index->log))
+    return;
+
+  const gchar *id = _index_get_context(index, context);
+
+  if (!id)
+    return;
+
+  const gchar *scope = _index_get_scope(context, id);
+  const guint64 fingerprint = _index_fingerprint_message(scope, msg);
+
+  struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(msg);
+  struct GNUNET_CHAT_File *file = GNUNET_CHAT_message_get_file(msg);
+
+  const char *text = GNUNET_CHAT_message_get_text(msg);
+  const char *file_name = file? GNUNET_CHAT_file_get_name(file) : NULL;
+
+  MESSENGER_IndexMessage *message = g_new(MESSENGER_IndexMessage, 1);
+
+  message->fingerprint = fingerprint;
+  message->context = context;
+
+  g_hash_table_insert(index->messages, (gpointer) msg, message);
+
+  if (scope != id)
+    g_hash_table_insert(
+      index->owners,
+      _index_copy_fingerprint(fingerprint),
+      (gpointer) id
+    );
+
+  GString *payload = g_string_new(scope);
+  g_string_append_c(payload, '\0');
+
+  const char *fields [] = {
+    sender? GNUNET_CHAT_contact_get_name(sender) : NULL,
+    text,
+    file_name
+  };
+
+  for (gsize i = 0; i < G_N_ELEMENTS(fields); i++)
+    if (fields[i])
+    {
+      g_string_append(payload, fields[i]);
+      g_string_append_c(payload, '\n');
+    }
+
+  const gchar *content = payload->str + strlen(scope) + 1;
+
+  const gchar *context_id = g_intern_string(scope);
+
+  if (_index_insert_entry(
+        index, fingerprint, context_id, content, index->log_length))
+    _index_write_record(
+      index,
+      INDEX_RECORD_ADD,
+      fingerprint,
+      payload->str,
+      payload->len + 1
+    );
+
+  g_string_free(payload, TRUE);
+}
+
+const gchar*
+index_add_context(MESSENGER_Index *index,
+                  struct GNUNET_CHAT_Context *context)
+{
+  g_assert((index) && (context));
+
+  if (!(index->contexts))
+    return NULL;
+
+  return _index_get_context(index, context);
+}
+
+void
+index_drop_message(MESSENGER_Index *index,
+                   struct GNUNET_CHAT_Context *context,
+                   const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((index) && (context) && (msg));
+
+  if (!(index->log))
+    return;
+
+  const MESSENGER_IndexMessage *message = g_hash_table_lookup(
+    index->messages, msg
+  );
+
+  guint64 fingerprint;
+
+  if (message)
+  {
+    fingerprint = message->fingerprint;
+    g_hash_table_remove(index->messages, msg);
+  }
+  else
+  {
+    // Messages deleted while being offline don't get added again
+    const gchar *id = _index_get_context(index, context);
+
+    if (!id)
+      return;
+
+    fingerprint = _index_fingerprint_message(
+      _index_get_scope(context, id), msg
+    );
+  }
+
+  const MESSENGER_IndexEntry *entry = g_hash_table_lookup(
+    index->entries, &fingerprint
+  );
+
+  // The text of deleted messages should not stay in the log until compaction
+  if (entry)
+    _index_erase_record(index, entry->record);
+
+  if (!_index_remove_entry(index, fingerprint))
+    return;
+
+  _index_write_record(index, INDEX_RECORD_DROP, fingerprint, NULL, 0);
+
+  // Deletions should not reappear in search results after a crash
+  fflush(index->log);
+}
+
+static gboolean
+_index_is_message_of_context(UNUSED gpointer key,
+                             gpointer value,
+                             gpointer user_data)
+{
+  const MESSENGER_IndexMessage *message = value;
+
+  return (message->context == user_data);
+}
+
+static gboolean
+_index_is_owned_by(UNUSED gpointer key,
+                   gpointer value,
+                   gpointer user_data)
+{
+  return (value == user_data);
+}
+
+void
+index_drop_context(MESSENGER_Index *index,
+                   const struct GNUNET_CHAT_Context *context)
+{
+  g_assert((index) && (context));
+
+  if (!(index->contexts))
+    return;
+
+  const gchar *id = g_hash_table_lookup(index->contexts, context);
+
+  if (!id)
+    return;
+
+  // Messages of the context get released by the chat library as well
+  g_hash_table_foreach_remove(
+    index->messages,
+    _index_is_message_of_context,
+    (gpointer) context
+  );
+
+  g_hash_table_foreach_remove(
+    index->owners,
+    _index_is_owned_by,
+    (gpointer) id
+  );
+
+  g_hash_table_remove(index->contexts, context);
+}
+
+const gchar*
+index_get_context_id(const MESSENGER_Index *index,
+                     const struct GNUNET_CHAT_Context *context)
+{
+  g_assert((index) && (context));
+
+  if (!(index->contexts))
+    return NULL;
+
+  return (const gchar*) g_hash_table_lookup(index->contexts, context);
+}
+
+static void
+_index_collect_base_word(const MESSENGER_Index *index,
+                         const gchar *word,
+                         guint8 *bitmap)
+{
+  guint32 lower = 0;
+  guint32 upper = index->header->terms;
+
+  while (lower < upper)
+  {
+    const guint32 mid = lower + (upper - lower) / 2;
+
+    if (strcmp(index->strings + index->terms[mid].token, word) < 0)
+      lower = mid + 1;
+    else
+      upper = mid;
+  }
+
+  for (; lower < index->header->terms; lower++)
+  {
+    const MESSENGER_IndexTerm *term = &(index->terms[lower]);
+
+    if (!g_str_has_prefix(index->strings + term->token, word))
+      break;
+
+    for (guint32 i = 0; i < term->count; i++)
+    {
+      const guint32 id = index->postings[term->postings + i];
+      bitmap[id / 8] |= (guint8) (1 << (id % 8));
+    }
+  }
+}
+
+static void
+_index_query_base(const MESSENGER_Index *index,
+                  const gchar* const* words,
+                  GHashTable *contexts)
+{
+  const guint32 docs = index->header->docs;
+  const gsize size = (docs + 7) / 8;
+
+  guint8 *bitmap = g_malloc0(size);
+  guint8 *word_bitmap = g_malloc(size);
+
+  _index_collect_base_word(index, *words, bitmap);
+
+  for (words++; *words; words++)
+  {
+    memset(word_bitmap, 0, size);
+    _index_collect_base_word(index, *words, word_bitmap);
+
+    for (gsize i = 0; i < size; i++)
+      bitmap[i] &= word_bitmap[i];
+  }
+
+  for (guint32 id = 0; id < docs; id++)
+  {
+    if (!(bitmap[id / 8] & (1 << (id % 8))))
+      continue;
+
+    const MESSENGER_IndexDoc *doc = &(index->docs[id]);
+
+    if ((g_hash_table_size(index->tombstones) > 0) &&
+        (g_hash_table_contains(index->tombstones, &(doc->fingerprint))))
+      continue;
+
+    const gchar *context = _index_resolve_context(
+      index,
+      doc->fingerprint,
+      index->strings + doc->context
+    );
+
+    if (context)
+      g_hash_table_add(contexts, (gpointer) g_intern_string(context));
+  }
+
+  g_free(word_bitmap);
+  g_free(bitmap);
+}
+
+GHashTable*
+index_query(const MESSENGER_Index *index,
+            const gchar *filter)
+{
+  g_assert(index);
+
+  if ((!(index->base_path)) || (!filter))
+    return NULL;
+
+  gchar **words = g_str_tokenize_and_fold(filter, NULL, NULL);
+
+  if ((!words) || (!(*words)))
+  {
+    g_strfreev(words);
+    return NULL;
+  }
+
+  GHashTable *contexts = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  if ((index->header) && (index->header->docs > 0))
+    _index_query_base(index, (const gchar* const*) words, contexts);
+
+  g_strfreev(words);
+
+  GHashTable *matches = search_query(&(index->search), filter);
+
+  if (!matches)
+    return contexts;
+
+  GHashTableIter iter;
+  gpointer item;
+
+  g_hash_table_iter_init(&iter, matches);
+  while (g_hash_table_iter_next(&iter, &item, NULL))
+  {
+    const MESSENGER_IndexEntry *entry = (const MESSENGER_IndexEntry*) item;
+
+    const gchar *context = _index_resolve_context(
+      index,
+      entry->fingerprint,
+      entry->context
+    );
+
+    if (context)
+      g_hash_table_add(contexts, (gpointer) context);
+  }
+
+  g_hash_table_destroy(matches);
+  return contexts;
+}
@@ -0,0 +1,229 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file index.h
+ */
+
+#ifndef INDEX_H_
+#define INDEX_H_
+
+#include <glib-2.0/glib.h>
+#include <gnunet/gnunet_chat_lib.h>
+#include <stdio.h>
+
+#include "search.h"
+
+typedef struct MESSENGER_IndexHeader
+{
+  gchar magic [4];
+  guint32 version;
+  guint32 docs;
+  guint32 terms;
+  guint32 postings;
+  guint32 strings;
+} MESSENGER_IndexHeader;
+
+typedef struct MESSENGER_IndexDoc
+{
+  guint64 fingerprint;
+  guint32 context;
+  guint32 reserved;
+} MESSENGER_IndexDoc;
+
+typedef struct MESSENGER_IndexTerm
+{
+  guint32 token;
+  guint32 postings;
+  guint32 count;
+} MESSENGER_IndexTerm;
+
+typedef struct MESSENGER_IndexRecord
+{
+  guint32 kind;
+  guint32 length;
+  guint64 fingerprint;
+} MESSENGER_IndexRecord;
+
+typedef struct MESSENGER_IndexEntry
+{
+  guint64 fingerprint;
+  const gchar *context;
+  gsize record;
+} MESSENGER_IndexEntry;
+
+typedef struct MESSENGER_Index
+{
+  gchar *base_path;
+  gchar *log_path;
+
+  // Compacted index (memory-mapped)
+  GMappedFile *mapping;
+  const MESSENGER_IndexHeader *header;
+  const MESSENGER_IndexDoc *docs;
+  const MESSENGER_IndexTerm *terms;
+  const guint32 *postings;
+  const gchar *strings;
+
+  // Appended changes since the last compaction
+  FILE *log;
+  gsize log_length;
+  gboolean changed;
+
+  MESSENGER_Search search;
+  GHashTable *entries;
+  GHashTable *tombstones;
+
+  GHashTable *messages;
+  GHashTable *contexts;
+  GHashTable *owners;
+  guint groups;
+
+  // Compaction of the previous session
+  GThread *compaction;
+  gchar *compacting;
+} MESSENGER_Index;
+
+/**
+ * Initializes a search index of messages across
+ * all chats which gets stored on disk per account.
+ *
+ * @param index Search index
+ */
+void
+index_init(MESSENGER_Index *index);
+
+/**
+ * Opens the stored search index of an account
+ * from the cache directory of the user. Changes
+ * since its last compaction get replayed from
+ * the log of the index.
+ *
+ * The index stores the words of messages, sender
+ * names and file names unencrypted, only protected
+ * by the permissions of its directory.
+ *
+ * @param index Search index
+ * @param key Public key of the account
+ * @return TRUE on success, otherwise FALSE
+ */
+gboolean
+index_open(MESSENGER_Index *index,
+           const gchar *key);
+
+/**
+ * Closes the search index and compacts its log
+ * of changes into the stored index if necessary.
+ * The compaction runs in a separate thread.
+ *
+ * @param index Search index
+ */
+void
+index_close(MESSENGER_Index *index);
+
+/**
+ * Closes the search index and waits for its
+ * compaction to finish.
+ *
+ * @param index Search index
+ */
+void
+index_cleanup(MESSENGER_Index *index);
+
+/**
+ * Adds a message from a given chat context to the
+ * search index unless it has been stored already.
+ *
+ * @param index Search index
+ * @param context Chat context
+ * @param msg Chat message
+ */
+void
+index_add_message(MESSENGER_Index *index,
+                  struct GNUNET_CHAT_Context *context,
+                  const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Adds a chat context to the search index to look up
+ * its identifier later. This needs to be called while
+ * the chat handle can be accessed.
+ *
+ * @param index Search index
+ * @param context Chat context
+ * @return Interned identifier or NULL
+ */
+const gchar*
+index_add_context(MESSENGER_Index *index,
+                  struct GNUNET_CHAT_Context *context);
+
+/**
+ * Removes a deleted message from a given chat context
+ * from the search index. Its text gets erased from the
+ * log of changes right away.
+ *
+ * @param index Search index
+ * @param context Chat context
+ * @param msg Chat message
+ */
+void
+index_drop_message(MESSENGER_Index *index,
+                   struct GNUNET_CHAT_Context *context,
+                   const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Removes a chat context and all its messages from
+ * the search index before the chat library releases
+ * them. Stored documents of the context stay in the
+ * index.
+ *
+ * @param index Search index
+ * @param context Chat context
+ */
+void
+index_drop_context(MESSENGER_Index *index,
+                   const struct GNUNET_CHAT_Context *context);
+
+/**
+ * Returns the identifier of a chat context used
+ * by the search index or NULL if no message of the
+ * context has been added so far.
+ *
+ * @param index Search index
+ * @param context Chat context
+ * @return Interned identifier or NULL
+ */
+const gchar*
+index_get_context_id(const MESSENGER_Index *index,
+                     const struct GNUNET_CHAT_Context *context);
+
+/**
+ * Looks up all chat contexts with messages matching
+ * a filter. Each word of the filter needs to be the
+ * prefix of a word from the message or its sender.
+ *
+ * @param index Search index
+ * @param filter Filter
+ * @return New set of interned context identifiers or NULL
+ */
+GHashTable*
+index_query(const MESSENGER_Index *index,
+            const gchar *filter);
+
+#endif /* INDEX_H_ */
@@ -0,0 +1,189 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file roster.c
+ */
+
+#include "roster.h"
+
+void
+roster_init(MESSENGER_Roster *roster)
+{
+  g_assert(roster);
+
+  roster->contacts = g_sequence_new(NULL);
+  roster->iters = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  search_init(&(roster->search));
+  roster->views = NULL;
+}
+
+void
+roster_cleanup(MESSENGER_Roster *roster)
+{
+  g_assert(roster);
+
+  roster_clear(roster);
+
+  if (roster->views)
+    g_list_free(roster->views);
+
+  search_cleanup(&(roster->search));
+
+  g_hash_table_destroy(roster->iters);
+  g_sequence_free(roster->contacts);
+
+  memset(roster, 0, sizeof(*roster));
+}
+
+void
+roster_clear(MESSENGER_Roster *roster)
+{
+  g_assert(roster);
+
+  GSequenceIter *iter = g_sequence_get_begin_iter(roster->contacts);
+
+  while (!g_sequence_iter_is_end(iter))
+  {
+    struct GNUNET_CHAT_Contact *contact = g_sequence_get(iter);
+    iter = g_sequence_iter_next(iter);
+
+    roster_remove_contact(roster, contact);
+  }
+}
+
+void
+roster_add_view(MESSENGER_Roster *roster,
+                MESSENGER_RosterView *view)
+{
+  g_assert((roster) && (view));
+
+  roster->views = g_list_append(roster->views, view);
+}
+
+void
+roster_remove_view(MESSENGER_Roster *roster,
+                   MESSENGER_RosterView *view)
+{
+  g_assert((roster) && (view));
+
+  roster->views = g_list_remove(roster->views, view);
+}
+
+static enum GNUNET_GenericReturnValue
+_roster_iterate_tags(void *cls,
+                     struct GNUNET_CHAT_Contact *contact,
+                     const char *tag)
+{
+  g_assert((cls) && (contact) && (tag));
+
+  MESSENGER_Roster *roster = (MESSENGER_Roster*) cls;
+
+  gchar *_tag = g_locale_to_utf8(tag, -1, NULL, NULL, NULL);
+  if (!_tag)
+    return GNUNET_YES;
+
+  search_add_tag(&(roster->search), contact, _tag);
+
+  g_free(_tag);
+  return GNUNET_YES;
+}
+
+void
+roster_update_contact(MESSENGER_Roster *roster,
+                      struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert(roster);
+
+  if ((!contact) || (GNUNET_YES == GNUNET_CHAT_contact_is_owned(contact)))
+    return;
+
+  const gboolean added = !g_hash_table_contains(roster->iters, contact);
+
+  if (added)
+    g_hash_table_insert(
+      roster->iters,
+      contact,
+      g_sequence_append(roster->contacts, contact)
+    );
+  else
+    search_remove_item(&(roster->search), contact);
+
+  search_add_text(
+    &(roster->search),
+    contact,
+    GNUNET_CHAT_contact_get_name(contact)
+  );
+
+  GNUNET_CHAT_contact_iterate_tags(contact, _roster_iterate_tags, roster);
+
+  for (GList *list = roster->views; list; list = list->next)
+  {
+    MESSENGER_RosterView *view = (MESSENGER_RosterView*) list->data;
+    MESSENGER_RosterCallback callback = added? view->add_cb : view->update_cb;
+
+    if (callback)
+      callback(view->cls, contact);
+  }
+}
+
+void
+roster_remove_contact(MESSENGER_Roster *roster,
+                      struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert(roster);
+
+  GSequenceIter *iter = g_hash_table_lookup(roster->iters, contact);
+
+  if (!iter)
+    return;
+
+  // Views may still hold iterators to the contact until notified
+  for (GList *list = roster->views; list; list = list->next)
+  {
+    MESSENGER_RosterView *view = (MESSENGER_RosterView*) list->data;
+
+    if (view->remove_cb)
+      view->remove_cb(view->cls, contact);
+  }
+
+  search_remove_item(&(roster->search), contact);
+
+  g_hash_table_remove(roster->iters, contact);
+  g_sequence_remove(iter);
+}
+
+GSequenceIter*
+roster_get_begin_iter(const MESSENGER_Roster *roster)
+{
+  g_assert(roster);
+
+  return g_sequence_get_begin_iter(roster->contacts);
+}
+
+GHashTable*
+roster_query(const MESSENGER_Roster *roster,
+             const gchar *filter)
+{
+  g_assert(roster);
+
+  return search_query(&(roster->search), filter);
+}
@@ -0,0 +1,147 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file roster.h
+ */
+
+#ifndef ROSTER_H_
+#define ROSTER_H_
+
+#include <glib-2.0/glib.h>
+#include <gnunet/gnunet_chat_lib.h>
+
+#include "search.h"
+
+typedef void (*MESSENGER_RosterCallback)(
+  gpointer cls,
+  struct GNUNET_CHAT_Contact *contact
+);
+
+typedef struct MESSENGER_RosterView
+{
+  MESSENGER_RosterCallback add_cb;
+  MESSENGER_RosterCallback update_cb;
+  MESSENGER_RosterCallback remove_cb;
+  gpointer cls;
+} MESSENGER_RosterView;
+
+typedef struct MESSENGER_Roster
+{
+  GSequence *contacts;
+  GHashTable *iters;
+
+  MESSENGER_Search search;
+  GList *views;
+} MESSENGER_Roster;
+
+/**
+ * Initializes a list of all contacts of the current
+ * account besides the own one. Names and tags of the
+ * contacts get indexed to search them without
+ * accessing the chat handle.
+ *
+ * @param roster Roster
+ */
+void
+roster_init(MESSENGER_Roster *roster);
+
+/**
+ * Cleanup a roster and all of its resources.
+ *
+ * @param roster Roster
+ */
+void
+roster_cleanup(MESSENGER_Roster *roster);
+
+/**
+ * Removes all contacts from a roster.
+ *
+ * @param roster Roster
+ */
+void
+roster_clear(MESSENGER_Roster *roster);
+
+/**
+ * Adds a view to a roster which gets notified when
+ * contacts get added, updated or removed.
+ *
+ * @param roster Roster
+ * @param view Roster view
+ */
+void
+roster_add_view(MESSENGER_Roster *roster,
+                MESSENGER_RosterView *view);
+
+/**
+ * Removes a view from a roster.
+ *
+ * @param roster Roster
+ * @param view Roster view
+ */
+void
+roster_remove_view(MESSENGER_Roster *roster,
+                   MESSENGER_RosterView *view);
+
+/**
+ * Adds a contact to a roster or updates its indexed
+ * name and tags. This needs to be called while the
+ * chat handle can be accessed.
+ *
+ * @param roster Roster
+ * @param contact Chat contact
+ */
+void
+roster_update_contact(MESSENGER_Roster *roster,
+                      struct GNUNET_CHAT_Contact *contact);
+
+/**
+ * Removes a contact from a roster.
+ *
+ * @param roster Roster
+ * @param contact Chat contact
+ */
+void
+roster_remove_contact(MESSENGER_Roster *roster,
+                      struct GNUNET_CHAT_Contact *contact);
+
+/**
+ * Returns an iterator to the first contact of a
+ * roster in the order they got added.
+ *
+ * @param roster Roster
+ * @return Sequence iterator
+ */
+GSequenceIter*
+roster_get_begin_iter(const MESSENGER_Roster *roster);
+
+/**
+ * Looks up all contacts of a roster matching a filter
+ * by their names or tags.
+ *
+ * @param roster Roster
+ * @param filter Filter
+ * @return New set of matching contacts or NULL if all contacts match
+ */
+GHashTable*
+roster_query(const MESSENGER_Roster *roster,
+             const gchar *filter);
+
+#endif /* ROSTER_H_ */
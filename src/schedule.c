@@ -41,7 +41,8 @@ semaphore_init(MESSENGER_Semaphore *semaphore,
   g_assert(0 == pthread_mutex_init(&(semaphore->mutex), NULL));
   g_assert(0 == pthread_cond_init(&(semaphore->condition), NULL));
 
-  semaphore->counter = val;
+  semaphore->counter = (gint) val;
+  semaphore->waiting = 0;
 }
 
 static void
@@ -51,15 +52,46 @@ semaphore_destroy(MESSENGER_Semaphore *semaphore)
   g_assert(0 == pthread_mutex_destroy(&(semaphore->mutex)));
 }
 
+static gboolean
+semaphore_try_down(MESSENGER_Semaphore *semaphore)
+{
+  g_assert(semaphore);
+
+  gint counter = g_atomic_int_get(&(semaphore->counter));
+
+  while (counter > 0)
+  {
+    if (g_atomic_int_compare_and_exchange(
+        &(semaphore->counter), counter, counter - 1))
+      return TRUE;
+
+    counter = g_atomic_int_get(&(semaphore->counter));
+  }
+
+  return FALSE;
+}
+
 static void
 semaphore_down(MESSENGER_Semaphore *semaphore)
 {
   g_assert(semaphore);
 
+  // Most handoffs complete quickly, so spin before blocking
+  for (guint i = 0; i < MESSENGER_SEMAPHORE_SPIN_LIMIT; i++)
+  {
+    if (semaphore_try_down(semaphore))
+      return;
+
+    g_thread_yield();
+  }
+
   g_assert(0 == pthread_mutex_lock(&(semaphore->mutex)));
-  while (0 == semaphore->counter)
+  g_atomic_int_inc(&(semaphore->waiting));
+
+  while (!semaphore_try_down(semaphore))
     pthread_cond_wait(&(semaphore->condition), &(semaphore->mutex));
-  semaphore->counter--;
+
+  g_atomic_int_add(&(semaphore->waiting), -1);
   g_assert(0 == pthread_mutex_unlock(&(semaphore->mutex)));
 }
 
@@ -68,11 +100,15 @@ semaphore_up(MESSENGER_Semaphore *semaphore)
 {
   g_assert(semaphore);
 
-  g_assert(0 == pthread_mutex_lock(&(semaphore->mutex)));
-  semaphore->counter++;
-  g_assert(0 == pthread_mutex_unlock(&(semaphore->mutex)));
+  g_atomic_int_inc(&(semaphore->counter));
+
+  // Only threads blocked on the condition need to be woken up
+  if (0 == g_atomic_int_get(&(semaphore->waiting)))
+    return;
 
+  g_assert(0 == pthread_mutex_lock(&(semaphore->mutex)));
   pthread_cond_signal(&(semaphore->condition));
+  g_assert(0 == pthread_mutex_unlock(&(semaphore->mutex)));
 }
 
 static void
@@ -149,6 +185,161 @@ signal_write(MESSENGER_SignalHandle *handle,
   g_assert(sizeof(data) == write(fd, &data, sizeof(data)));
 }
 
+static void
+queue_init(MESSENGER_ScheduleQueue *queue)
+{
+  g_assert(queue);
+
+  g_assert(0 == pthread_mutex_init(&(queue->mutex), NULL));
+
+  for (guint i = 0; i < MESSENGER_SCHEDULE_PRIORITY_COUNT; i++)
+  {
+    MESSENGER_ScheduleLane *lane = &(queue->lanes[i]);
+
+    lane->calls = g_malloc(
+      sizeof(MESSENGER_ScheduleCall) * MESSENGER_SCHEDULE_QUEUE_CAPACITY
+    );
+
+    lane->head = 0;
+    lane->count = 0;
+  }
+
+  queue->budget = 0;
+}
+
+static void
+queue_destroy(MESSENGER_ScheduleQueue *queue)
+{
+  g_assert(queue);
+
+  for (guint i = 0; i < MESSENGER_SCHEDULE_PRIORITY_COUNT; i++)
+  {
+    g_free(queue->lanes[i].calls);
+    queue->lanes[i].calls = NULL;
+  }
+
+  g_assert(0 == pthread_mutex_destroy(&(queue->mutex)));
+}
+
+static gboolean
+queue_push(MESSENGER_ScheduleQueue *queue,
+           MESSENGER_SchedulePriority priority,
+           GSourceFunc function,
+           gpointer data)
+{
+  g_assert(
+    (queue) &&
+    (priority < MESSENGER_SCHEDULE_PRIORITY_COUNT) &&
+    (function)
+  );
+
+  MESSENGER_ScheduleLane *lane = &(queue->lanes[priority]);
+  gboolean pushed = FALSE;
+
+  g_assert(0 == pthread_mutex_lock(&(queue->mutex)));
+
+  if (lane->count >= MESSENGER_SCHEDULE_QUEUE_CAPACITY)
+    goto unlock_mutex;
+
+  const guint index = (
+    (lane->head + lane->count) % MESSENGER_SCHEDULE_QUEUE_CAPACITY
+  );
+
+  lane->calls[index].function = function;
+  lane->calls[index].data = data;
+  lane->count++;
+
+  if (!(queue->pending_since))
+    queue->pending_since = g_get_monotonic_time();
+
+  pushed = TRUE;
+
+unlock_mutex:
+  g_assert(0 == pthread_mutex_unlock(&(queue->mutex)));
+  return pushed;
+}
+
+static gboolean
+queue_pop(MESSENGER_ScheduleQueue *queue,
+          MESSENGER_ScheduleCall *call,
+          MESSENGER_SchedulePriority *priority,
+          gboolean bulk)
+{
+  g_assert((queue) && (call) && (priority));
+
+  const guint lanes = bulk? MESSENGER_SCHEDULE_PRIORITY_COUNT : (
+    MESSENGER_SCHEDULE_PRIORITY_BULK
+  );
+
+  gboolean popped = FALSE;
+
+  g_assert(0 == pthread_mutex_lock(&(queue->mutex)));
+
+  // Lanes of higher priority always get processed first
+  for (guint i = 0; i < lanes; i++)
+  {
+    MESSENGER_ScheduleLane *lane = &(queue->lanes[i]);
+
+    if (0 == lane->count)
+      continue;
+
+    *call = lane->calls[lane->head];
+    *priority = (MESSENGER_SchedulePriority) i;
+
+    lane->head = (lane->head + 1) % MESSENGER_SCHEDULE_QUEUE_CAPACITY;
+    lane->count--;
+
+    popped = TRUE;
+    break;
+  }
+
+  g_assert(0 == pthread_mutex_unlock(&(queue->mutex)));
+  return popped;
+}
+
+static gboolean
+queue_mark_signaled(MESSENGER_ScheduleQueue *queue,
+                    gboolean signaled)
+{
+  g_assert(queue);
+
+  gboolean changed;
+
+  g_assert(0 == pthread_mutex_lock(&(queue->mutex)));
+  changed = (signaled != queue->signaled);
+  queue->signaled = signaled;
+  g_assert(0 == pthread_mutex_unlock(&(queue->mutex)));
+
+  return changed;
+}
+
+static gboolean
+queue_is_drained(const MESSENGER_ScheduleQueue *queue)
+{
+  g_assert(queue);
+
+  gboolean empty = TRUE;
+
+  for (guint i = 0; i < MESSENGER_SCHEDULE_PRIORITY_COUNT; i++)
+    empty &= (0 == queue->lanes[i].count);
+
+  return empty;
+}
+
+static gboolean
+queue_is_empty(MESSENGER_ScheduleQueue *queue)
+{
+  g_assert(queue);
+
+  gboolean empty;
+
+  g_assert(0 == pthread_mutex_lock(&(queue->mutex)));
+  empty = queue_is_drained(queue);
+  g_assert(0 == pthread_mutex_unlock(&(queue->mutex)));
+
+  return empty;
+}
+
 void
 schedule_init(MESSENGER_Schedule *schedule)
 {
@@ -159,6 +350,73 @@ schedule_init(MESSENGER_Schedule *schedule)
 
   semaphore_init(&(schedule->push_sem), 0);
   semaphore_init(&(schedule->sync_sem), 0);
+
+  queue_init(&(schedule->queue));
+}
+
+static void
+__schedule_flush_handling(MESSENGER_Schedule *schedule,
+                          gboolean synced)
+{
+  g_assert(schedule);
+
+  MESSENGER_ScheduleQueue *queue = &(schedule->queue);
+  MESSENGER_SchedulePriority priority;
+  MESSENGER_ScheduleCall call;
+
+  const gint64 start = g_get_monotonic_time();
+  guint count = 0;
+  guint bulk = 0;
+
+  // Limit bulk calls per batch to keep the thread responsive
+  while (queue_pop(queue, &call, &priority,
+                   (!(queue->budget)) || (bulk < queue->budget)))
+  {
+    if (MESSENGER_SCHEDULE_PRIORITY_BULK == priority)
+      bulk++;
+
+    count++;
+
+    // Posted calls must not touch the state of a concurrent sync run
+    if (!synced)
+    {
+      call.function(call.data);
+      continue;
+    }
+
+    schedule->function = call.function;
+    schedule->data = call.data;
+
+    schedule->function(schedule->data);
+
+    schedule->function = NULL;
+    schedule->data = NULL;
+  }
+
+  if (!count)
+    return;
+
+  const gint64 end = g_get_monotonic_time();
+  MESSENGER_ScheduleStats *stats = &(queue->stats);
+
+  stats->calls += count;
+  stats->batches++;
+  stats->busy_time += (end - start);
+  stats->longest_batch = MAX(stats->longest_batch, end - start);
+
+  g_assert(0 == pthread_mutex_lock(&(queue->mutex)));
+
+  // Track how long it takes until the queue runs idle again
+  if ((queue->pending_since) && (queue_is_drained(queue)))
+  {
+    stats->longest_idle_delay = MAX(
+      stats->longest_idle_delay, end - queue->pending_since
+    );
+
+    queue->pending_since = 0;
+  }
+
+  g_assert(0 == pthread_mutex_unlock(&(queue->mutex)));
 }
 
 static gboolean
@@ -169,6 +427,17 @@ __schedule_pushed_handling(MESSENGER_Schedule *schedule,
 
   gboolean keep;
 
+  if (val & MESSENGER_SCHEDULE_SIGNAL_POST)
+  {
+    queue_mark_signaled(&(schedule->queue), FALSE);
+    __schedule_flush_handling(schedule, FALSE);
+
+    val &= ~MESSENGER_SCHEDULE_SIGNAL_POST;
+
+    if (!val)
+      return TRUE;
+  }
+
   switch (val)
   {
     case MESSENGER_SCHEDULE_SIGNAL_RUN:
@@ -187,6 +456,13 @@ __schedule_pushed_handling(MESSENGER_Schedule *schedule,
       semaphore_up(&(schedule->sync_sem));
       semaphore_down(&(schedule->push_sem));
       break;
+    case MESSENGER_SCHEDULE_SIGNAL_FLUSH:
+      g_assert(!(schedule->function));
+
+      keep = TRUE;
+
+      __schedule_flush_handling(schedule, TRUE);
+      break;
     default:
       return FALSE;
   }
@@ -200,6 +476,10 @@ __schedule_exit_handling(MESSENGER_Schedule *schedule,
 {
   g_assert(schedule);
 
+  // Posted calls are not waited for
+  if (!(val & ~MESSENGER_SCHEDULE_SIGNAL_POST))
+    return;
+
   semaphore_up(&(schedule->sync_sem));
 }
 
@@ -226,28 +506,33 @@ __schedule_pushed_task(void *cls)
 static void
 __schedule_setup_push_task(MESSENGER_Schedule *schedule)
 {
-  struct GNUNET_NETWORK_FDSet *fd = GNUNET_NETWORK_fdset_create ();
-  GNUNET_NETWORK_fdset_set_native(
-    fd,
-    signal_fd(&(schedule->push_signal), 0)
-  );
+  g_assert((schedule) && (schedule->fdset));
 
+  // Requests from the UI should not wait behind background work
   schedule->task = GNUNET_SCHEDULER_add_select(
-    GNUNET_SCHEDULER_PRIORITY_DEFAULT,
+    GNUNET_SCHEDULER_PRIORITY_UI,
     GNUNET_TIME_relative_get_forever_(),
-    fd,
+    schedule->fdset,
     NULL,
     __schedule_pushed_task,
     schedule
   );
-
-  GNUNET_NETWORK_fdset_destroy(fd);
 }
 
 void
 schedule_load_gnunet(MESSENGER_Schedule *schedule)
 {
   g_assert(schedule);
+
+  schedule->loop = MESSENGER_SCHEDULE_LOOP_GNUNET;
+
+  // The set only contains the signal, so it can be reused for each push
+  schedule->fdset = GNUNET_NETWORK_fdset_create();
+  GNUNET_NETWORK_fdset_set_native(
+    schedule->fdset,
+    signal_fd(&(schedule->push_signal), 0)
+  );
+
   __schedule_setup_push_task(schedule);
 }
 
@@ -280,6 +565,8 @@ void
 schedule_load_glib(MESSENGER_Schedule *schedule)
 {
   g_assert(schedule);
+
+  schedule->loop = MESSENGER_SCHEDULE_LOOP_GLIB;
   schedule->poll = g_unix_fd_add(
     signal_fd(&(schedule->push_signal), 0),
     G_IO_IN,
@@ -288,6 +575,42 @@ schedule_load_glib(MESSENGER_Schedule *schedule)
   );
 }
 
+void
+schedule_detach_queue(MESSENGER_Schedule *schedule)
+{
+  g_assert(schedule);
+
+  schedule->queue.detached = TRUE;
+}
+
+void
+schedule_log_stats(const MESSENGER_Schedule *schedule,
+                   const gchar *name)
+{
+  g_assert((schedule) && (name));
+
+  const MESSENGER_ScheduleStats *stats = &(schedule->queue.stats);
+
+  if (!(stats->batches))
+    return;
+
+  const gdouble rate = stats->busy_time > 0? (
+    (gdouble) stats->calls * G_USEC_PER_SEC / stats->busy_time
+  ) : 0.0;
+
+  g_debug(
+    "%s: %" G_GUINT64_FORMAT " calls in %" G_GUINT64_FORMAT " batches"
+    " (%.0f calls/s, longest batch %" G_GINT64_FORMAT " us,"
+    " longest delay until idle %" G_GINT64_FORMAT " us)",
+    name,
+    stats->calls,
+    stats->batches,
+    rate,
+    stats->longest_batch,
+    stats->longest_idle_delay
+  );
+}
+
 void
 schedule_cleanup(MESSENGER_Schedule *schedule)
 {
@@ -295,9 +618,18 @@ schedule_cleanup(MESSENGER_Schedule *schedule)
 
   if (schedule->task)
     GNUNET_SCHEDULER_cancel(schedule->task);
+  if (schedule->fdset)
+    GNUNET_NETWORK_fdset_destroy(schedule->fdset);
   if (schedule->poll)
     g_source_remove(schedule->poll);
 
+  if (schedule->queue.task)
+    GNUNET_SCHEDULER_cancel(schedule->queue.task);
+  if (schedule->queue.idle)
+    g_source_remove(schedule->queue.idle);
+
+  queue_destroy(&(schedule->queue));
+
   semaphore_destroy(&(schedule->push_sem));
   semaphore_destroy(&(schedule->sync_sem));
 
@@ -318,6 +650,9 @@ schedule_sync_run(MESSENGER_Schedule *schedule,
     (function)
   );
 
+  // Previously queued calls need to be processed first
+  schedule_sync_flush(schedule);
+
   schedule->function = function;
   schedule->data = data;
 
@@ -327,6 +662,123 @@ schedule_sync_run(MESSENGER_Schedule *schedule,
   semaphore_down(&(schedule->sync_sem));
 }
 
+static void
+__schedule_budget_flush(MESSENGER_Schedule *schedule)
+{
+  g_assert(schedule);
+
+  schedule->queue.budget = MESSENGER_SCHEDULE_BULK_BUDGET;
+  schedule_sync_flush(schedule);
+  schedule->queue.budget = 0;
+}
+
+static void
+__schedule_flush_task(void *cls)
+{
+  MESSENGER_Schedule *schedule = cls;
+
+  g_assert(schedule);
+  schedule->queue.task = NULL;
+
+  __schedule_budget_flush(schedule);
+
+  // Remaining bulk calls get processed in another batch
+  if (!queue_is_empty(&(schedule->queue)))
+    schedule->queue.task = GNUNET_SCHEDULER_add_now(
+      __schedule_flush_task,
+      schedule
+    );
+}
+
+static gboolean
+__schedule_flush_idle(gpointer user_data)
+{
+  MESSENGER_Schedule *schedule = user_data;
+
+  g_assert(schedule);
+
+  __schedule_budget_flush(schedule);
+
+  // Remaining bulk calls get processed in another batch
+  if (!queue_is_empty(&(schedule->queue)))
+    return TRUE;
+
+  schedule->queue.idle = 0;
+  return FALSE;
+}
+
+void
+schedule_async_run(MESSENGER_Schedule *schedule,
+                   MESSENGER_SchedulePriority priority,
+                   GSourceFunc function,
+                   gpointer data)
+{
+  g_assert((schedule) && (function));
+
+  MESSENGER_ScheduleQueue *queue = &(schedule->queue);
+
+  g_assert((!(schedule->locked)) || (queue->detached));
+
+  // Bounded queue: a full batch gets processed right away
+  while (!queue_push(queue, priority, function, data))
+    schedule_sync_flush(schedule);
+
+  if (queue->detached)
+  {
+    const MESSENGER_ScheduleSignal push = MESSENGER_SCHEDULE_SIGNAL_POST;
+
+    if (queue_mark_signaled(queue, TRUE))
+      signal_write(&(schedule->push_signal), push);
+
+    return;
+  }
+
+  // The flush gets scheduled in the loop of the current thread
+  switch (schedule->loop)
+  {
+    case MESSENGER_SCHEDULE_LOOP_GLIB:
+      if (!(queue->task))
+        queue->task = GNUNET_SCHEDULER_add_now(
+          __schedule_flush_task,
+          schedule
+        );
+      break;
+    case MESSENGER_SCHEDULE_LOOP_GNUNET:
+      if (!(queue->idle))
+        queue->idle = g_idle_add(
+          G_SOURCE_FUNC(__schedule_flush_idle),
+          schedule
+        );
+      break;
+    default:
+      schedule_sync_flush(schedule);
+      break;
+  }
+}
+
+void
+schedule_sync_flush(MESSENGER_Schedule *schedule)
+{
+  g_assert(
+    (schedule) &&
+    (!(schedule->locked)) &&
+    (!(schedule->function))
+  );
+
+  if (queue_is_empty(&(schedule->queue)))
+    return;
+
+  const MESSENGER_ScheduleSignal push = MESSENGER_SCHEDULE_SIGNAL_FLUSH;
+
+  // The other thread may not wait for this one until the flush completed
+  g_atomic_int_set(&(schedule->waiting), TRUE);
+
+  signal_write(&(schedule->push_signal), push);
+  semaphore_down(&(schedule->sync_sem));
+
+  g_atomic_int_set(&(schedule->waiting), FALSE);
+}
+
 void
 schedule_sync_lock(MESSENGER_Schedule *schedule)
 {
@@ -336,6 +788,9 @@ schedule_sync_lock(MESSENGER_Schedule *schedule)
     (!(schedule->function))
   );
 
+  // Previously queued calls need to be processed first
+  schedule_sync_flush(schedule);
+
   const MESSENGER_ScheduleSignal push = MESSENGER_SCHEDULE_SIGNAL_LOCK;
 
   signal_write(&(schedule->push_signal), push);
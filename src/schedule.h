@@ -29,10 +29,15 @@
 #include <gnunet/gnunet_util_lib.h>
 #include <pthread.h>
 
+#ifndef MESSENGER_SEMAPHORE_SPIN_LIMIT
+#define MESSENGER_SEMAPHORE_SPIN_LIMIT 128
+#endif
+
 typedef struct MESSENGER_Semaphore {
   pthread_mutex_t mutex;
   pthread_cond_t condition;
-  unsigned int counter;
+  gint counter;
+  gint waiting;
 } MESSENGER_Semaphore;
 
 typedef struct MESSENGER_SignalHandle {
@@ -46,18 +51,77 @@ typedef struct MESSENGER_SignalHandle {
 typedef enum MESSENGER_ScheduleSignal : unsigned char {
   MESSENGER_SCHEDULE_SIGNAL_RUN = 1,
   MESSENGER_SCHEDULE_SIGNAL_LOCK = 2,
+  MESSENGER_SCHEDULE_SIGNAL_FLUSH = 3,
+  MESSENGER_SCHEDULE_SIGNAL_POST = 4, // may be combined with others
 } MESSENGER_ScheduleSignal;
 
+typedef enum MESSENGER_ScheduleLoop {
+  MESSENGER_SCHEDULE_LOOP_NONE = 0,
+  MESSENGER_SCHEDULE_LOOP_GNUNET = 1,
+  MESSENGER_SCHEDULE_LOOP_GLIB = 2,
+} MESSENGER_ScheduleLoop;
+
+typedef enum MESSENGER_SchedulePriority {
+  MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE = 0,
+  MESSENGER_SCHEDULE_PRIORITY_MEDIA = 1,
+  MESSENGER_SCHEDULE_PRIORITY_BULK = 2,
+} MESSENGER_SchedulePriority;
+
+#define MESSENGER_SCHEDULE_PRIORITY_COUNT 3
+#define MESSENGER_SCHEDULE_QUEUE_CAPACITY 1024
+#define MESSENGER_SCHEDULE_BULK_BUDGET 64
+
+typedef struct MESSENGER_ScheduleCall {
+  GSourceFunc function;
+  gpointer data;
+} MESSENGER_ScheduleCall;
+
+typedef struct MESSENGER_ScheduleLane {
+  MESSENGER_ScheduleCall *calls;
+  guint head;
+  guint count;
+} MESSENGER_ScheduleLane;
+
+typedef struct MESSENGER_ScheduleStats {
+  guint64 calls;
+  guint64 batches;
+
+  gint64 busy_time;
+  gint64 longest_batch;
+  gint64 longest_idle_delay;
+} MESSENGER_ScheduleStats;
+
+typedef struct MESSENGER_ScheduleQueue {
+  pthread_mutex_t mutex;
+
+  MESSENGER_ScheduleLane lanes [MESSENGER_SCHEDULE_PRIORITY_COUNT];
+  guint budget;
+
+  gint64 pending_since;
+  MESSENGER_ScheduleStats stats;
+
+  gboolean detached;
+  gboolean signaled;
+
+  struct GNUNET_SCHEDULER_Task *task;
+  guint idle;
+} MESSENGER_ScheduleQueue;
+
 typedef struct MESSENGER_Schedule {
   MESSENGER_SignalHandle push_signal;
+  MESSENGER_ScheduleLoop loop;
 
   MESSENGER_Semaphore push_sem;
   MESSENGER_Semaphore sync_sem;
   gboolean locked;
+  gint waiting;
 
   GSourceFunc function;
   gpointer data;
 
+  MESSENGER_ScheduleQueue queue;
+
+  struct GNUNET_NETWORK_FDSet *fdset;
   struct GNUNET_SCHEDULER_Task *task;
   guint poll;
 } MESSENGER_Schedule;
@@ -83,6 +147,22 @@ schedule_load_gnunet(MESSENGER_Schedule *schedule);
 void
 schedule_load_glib(MESSENGER_Schedule *schedule);
 
+/**
+ * Detaches the queue of a given schedule, so that
+ * queued calls get processed by its thread without
+ * the current thread waiting for their completion.
+ */
+void
+schedule_detach_queue(MESSENGER_Schedule *schedule);
+
+/**
+ * Prints statistics about the calls processed via
+ * the queue of a given schedule for debugging.
+ */
+void
+schedule_log_stats(const MESSENGER_Schedule *schedule,
+                   const gchar *name);
+
 /**
  * Cleanup a schedule and all of its resources for
  * its synchronization.
@@ -100,6 +180,36 @@ schedule_sync_run(MESSENGER_Schedule *schedule,
                   GSourceFunc function,
                   gpointer data);
 
+/**
+ * Enqueues a given function to be called from the
+ * thread of a given schedule without waiting for its
+ * completion. All queued calls get processed as one
+ * batch once the current thread returns to its own
+ * scheduler, so that it only waits once per batch.
+ * If the queue is detached, the current thread does
+ * not wait at all.
+ *
+ * Calls of a higher priority get processed before any
+ * queued calls of lower priority. Bulk calls only get
+ * processed in limited amounts per batch, unless the
+ * queue gets flushed explicitly.
+ *
+ * The return value of the function gets ignored.
+ */
+void
+schedule_async_run(MESSENGER_Schedule *schedule,
+                   MESSENGER_SchedulePriority priority,
+                   GSourceFunc function,
+                   gpointer data);
+
+/**
+ * Processes all calls queued to a given schedule
+ * from its thread and waits for their completion
+ * in the current thread.
+ */
+void
+schedule_sync_flush(MESSENGER_Schedule *schedule);
+
 /**
  * Locks the thread of a given schedule to wait
  * until the schedule gets unlocked again from
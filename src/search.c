@@ -0,0 +1,345 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file search.c
+ */
+
+#include "search.h"
+
+#include "util.h"
+
+#define SEARCH_TAG_PREFIX '#'
+
+static void
+_search_token_free(gpointer data)
+{
+  MESSENGER_SearchToken *entry = (MESSENGER_SearchToken*) data;
+
+  g_hash_table_destroy(entry->items);
+  g_free(entry->token);
+  g_free(entry);
+}
+
+static gint
+_search_compare_tokens(gconstpointer a,
+                       gconstpointer b,
+                       UNUSED gpointer user_data)
+{
+  return g_strcmp0((const gchar*) a, (const gchar*) b);
+}
+
+static gint
+_search_compare_lower_bound(gconstpointer a,
+                            gconstpointer b,
+                            UNUSED gpointer user_data)
+{
+  // Equal tokens count as bigger to find the first of them
+  return g_strcmp0((const gchar*) a, (const gchar*) b) >= 0? 1 : -1;
+}
+
+void
+search_init(MESSENGER_Search *search)
+{
+  g_assert(search);
+
+  search->tokens = g_hash_table_new_full(
+    g_str_hash, g_str_equal, NULL, _search_token_free
+  );
+
+  search->order = g_sequence_new(NULL);
+
+  search->items = g_hash_table_new_full(
+    g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_ptr_array_unref
+  );
+}
+
+void
+search_cleanup(MESSENGER_Search *search)
+{
+  g_assert(search);
+
+  g_hash_table_destroy(search->items);
+  g_sequence_free(search->order);
+  g_hash_table_destroy(search->tokens);
+
+  search->items = NULL;
+  search->order = NULL;
+  search->tokens = NULL;
+}
+
+static void
+_search_add_token(MESSENGER_Search *search,
+                  gpointer item,
+                  const gchar *token)
+{
+  g_assert((search) && (token));
+
+  if (!*token)
+    return;
+
+  MESSENGER_SearchToken *entry = g_hash_table_lookup(search->tokens, token);
+
+  if (!entry)
+  {
+    entry = g_new(MESSENGER_SearchToken, 1);
+
+    entry->token = g_strdup(token);
+    entry->items = g_hash_table_new(g_direct_hash, g_direct_equal);
+    entry->iter = g_sequence_insert_sorted(
+      search->order, entry->token, _search_compare_tokens, NULL
+    );
+
+    g_hash_table_insert(search->tokens, entry->token, entry);
+  }
+  else if (g_hash_table_contains(entry->items, item))
+    return;
+
+  g_hash_table_add(entry->items, item);
+
+  GPtrArray *entries = g_hash_table_lookup(search->items, item);
+
+  if (!entries)
+  {
+    entries = g_ptr_array_new();
+    g_hash_table_insert(search->items, item, entries);
+  }
+
+  g_ptr_array_add(entries, entry);
+}
+
+void
+search_add_text(MESSENGER_Search *search,
+                gpointer item,
+                const gchar *text)
+{
+  g_assert(search);
+
+  if ((!text) || (!*text))
+    return;
+
+  gchar **alternates = NULL;
+  gchar **tokens = g_str_tokenize_and_fold(text, NULL, &alternates);
+
+  for (gchar **token = tokens; (token) && (*token); token++)
+    _search_add_token(search, item, *token);
+
+  for (gchar **token = alternates; (token) && (*token); token++)
+    _search_add_token(search, item, *token);
+
+  g_strfreev(alternates);
+  g_strfreev(tokens);
+}
+
+static gchar*
+_search_fold_tag(const gchar *tag)
+{
+  gchar *folded = g_utf8_casefold(tag, -1);
+  gchar *normalized = g_utf8_normalize(folded, -1, G_NORMALIZE_ALL);
+
+  g_free(folded);
+  return normalized;
+}
+
+void
+search_add_tag(MESSENGER_Search *search,
+               gpointer item,
+               const gchar *tag)
+{
+  g_assert(search);
+
+  if ((!tag) || (!*tag))
+    return;
+
+  gchar *folded = _search_fold_tag(tag);
+
+  if (!folded)
+    return;
+
+  gchar *token = g_strdup_printf("%c%s", SEARCH_TAG_PREFIX, folded);
+  _search_add_token(search, item, token);
+
+  g_free(token);
+  g_free(folded);
+}
+
+void
+search_remove_item(MESSENGER_Search *search,
+                   gconstpointer item)
+{
+  g_assert(search);
+
+  GPtrArray *entries = g_hash_table_lookup(search->items, item);
+
+  if (!entries)
+    return;
+
+  for (guint i = 0; i < entries->len; i++)
+  {
+    MESSENGER_SearchToken *entry = g_ptr_array_index(entries, i);
+
+    g_hash_table_remove(entry->items, item);
+
+    if (g_hash_table_size(entry->items) > 0)
+      continue;
+
+    g_sequence_remove(entry->iter);
+    g_hash_table_remove(search->tokens, entry->token);
+  }
+
+  g_hash_table_remove(search->items, item);
+}
+
+gboolean
+search_has_item(const MESSENGER_Search *search,
+                gconstpointer item)
+{
+  g_assert(search);
+
+  return g_hash_table_contains(search->items, item);
+}
+
+static GSequenceIter*
+_search_find_prefix(const MESSENGER_Search *search,
+                    const gchar *prefix)
+{
+  return g_sequence_search(
+    search->order, (gpointer) prefix, _search_compare_lower_bound, NULL
+  );
+}
+
+static void
+_search_collect_prefix(const MESSENGER_Search *search,
+                       const gchar *prefix,
+                       GHashTable *matches)
+{
+  GSequenceIter *iter = _search_find_prefix(search, prefix);
+
+  for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter))
+  {
+    const gchar *token = g_sequence_get(iter);
+
+    if (!g_str_has_prefix(token, prefix))
+      break;
+
+    const MESSENGER_SearchToken *entry = g_hash_table_lookup(
+      search->tokens, token
+    );
+
+    GHashTableIter items;
+    gpointer item;
+
+    g_hash_table_iter_init(&items, entry->items);
+    while (g_hash_table_iter_next(&items, &item, NULL))
+      g_hash_table_add(matches, item);
+  }
+}
+
+static GHashTable*
+_search_query_words(const MESSENGER_Search *search,
+                    const gchar* const* words)
+{
+  GHashTable *matches = g_hash_table_new(g_direct_hash, g_direct_equal);
+  _search_collect_prefix(search, *words, matches);
+
+  for (words++; (*words) && (g_hash_table_size(matches) > 0); words++)
+  {
+    GHashTable *word_matches = g_hash_table_new(g_direct_hash, g_direct_equal);
+    _search_collect_prefix(search, *words, word_matches);
+
+    GHashTableIter iter;
+    gpointer item;
+
+    g_hash_table_iter_init(&iter, matches);
+    while (g_hash_table_iter_next(&iter, &item, NULL))
+      if (!g_hash_table_contains(word_matches, item))
+        g_hash_table_iter_remove(&iter);
+
+    g_hash_table_destroy(word_matches);
+  }
+
+  return matches;
+}
+
+static void
+_search_collect_tags(const MESSENGER_Search *search,
+                     const gchar *tag,
+                     GHashTable *matches)
+{
+  gchar *folded = _search_fold_tag(tag);
+
+  if (!folded)
+    return;
+
+  const gchar prefix [] = { SEARCH_TAG_PREFIX, '\0' };
+  GSequenceIter *iter = _search_find_prefix(search, prefix);
+
+  for (; !g_sequence_iter_is_end(iter); iter = g_sequence_iter_next(iter))
+  {
+    const gchar *token = g_sequence_get(iter);
+
+    if (SEARCH_TAG_PREFIX != *token)
+      break;
+
+    if (!g_strstr_len(token + 1, -1, folded))
+      continue;
+
+    const MESSENGER_SearchToken *entry = g_hash_table_lookup(
+      search->tokens, token
+    );
+
+    GHashTableIter items;
+    gpointer item;
+
+    g_hash_table_iter_init(&items, entry->items);
+    while (g_hash_table_iter_next(&items, &item, NULL))
+      g_hash_table_add(matches, item);
+  }
+
+  g_free(folded);
+}
+
+GHashTable*
+search_query(const MESSENGER_Search *search,
+             const gchar *filter)
+{
+  g_assert(search);
+
+  if (!filter)
+    return NULL;
+
+  gchar **words = g_str_tokenize_and_fold(filter, NULL, NULL);
+  GHashTable *matches = NULL;
+
+  if ((words) && (*words))
+    matches = _search_query_words(search, (const gchar* const*) words);
+
+  g_strfreev(words);
+
+  if (SEARCH_TAG_PREFIX != *filter)
+    return matches;
+
+  if (!matches)
+    matches = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  // Tags match by any substring instead of word prefixes
+  _search_collect_tags(search, filter + 1, matches);
+  return matches;
+}
@@ -0,0 +1,123 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file search.h
+ */
+
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+#include <glib-2.0/glib.h>
+
+typedef struct MESSENGER_SearchToken
+{
+  gchar *token;
+  GSequenceIter *iter;
+  GHashTable *items;
+} MESSENGER_SearchToken;
+
+typedef struct MESSENGER_Search
+{
+  GHashTable *tokens;
+  GSequence *order;
+  GHashTable *items;
+} MESSENGER_Search;
+
+/**
+ * Initializes an inverted index to search items
+ * by the words of their texts and by their tags.
+ *
+ * @param search Search index
+ */
+void
+search_init(MESSENGER_Search *search);
+
+/**
+ * Cleanup a search index and all of its resources.
+ *
+ * @param search Search index
+ */
+void
+search_cleanup(MESSENGER_Search *search);
+
+/**
+ * Adds the words of a given text to the index
+ * entries of an item. The words get folded the
+ * same way as `g_str_match_string()` does.
+ *
+ * @param search Search index
+ * @param item Item
+ * @param text Text or NULL
+ */
+void
+search_add_text(MESSENGER_Search *search,
+                gpointer item,
+                const gchar *text);
+
+/**
+ * Adds a tag to the index entries of an item.
+ *
+ * @param search Search index
+ * @param item Item
+ * @param tag Tag or NULL
+ */
+void
+search_add_tag(MESSENGER_Search *search,
+               gpointer item,
+               const gchar *tag);
+
+/**
+ * Removes all index entries of an item.
+ *
+ * @param search Search index
+ * @param item Item
+ */
+void
+search_remove_item(MESSENGER_Search *search,
+                   gconstpointer item);
+
+/**
+ * Returns whether an item has any index entries.
+ *
+ * @param search Search index
+ * @param item Item
+ * @return TRUE if the item is indexed, otherwise FALSE
+ */
+gboolean
+search_has_item(const MESSENGER_Search *search,
+                gconstpointer item);
+
+/**
+ * Looks up all items matching a filter. Each word
+ * of the filter needs to be the prefix of a word
+ * from the item. A filter starting with '#' also
+ * matches items with a tag containing the rest of
+ * the filter.
+ *
+ * @param search Search index
+ * @param filter Filter
+ * @return New set of matching items or NULL if all items match
+ */
+GHashTable*
+search_query(const MESSENGER_Search *search,
+             const gchar *filter);
+
+#endif /* SEARCH_H_ */
@@ -0,0 +1,426 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file snapshot.c
+ */
+
+#include "snapshot.h"
+
+#include "util.h"
+
+#define SNAPSHOT_MESSAGE_UPDATE GUINT_TO_POINTER(1)
+#define SNAPSHOT_MESSAGE_DROP GUINT_TO_POINTER(2)
+
+void
+snapshot_init(MESSENGER_Snapshot *snapshot,
+              MESSENGER_Schedule *schedule,
+              MESSENGER_SnapshotReceiptCallback receipt_cb,
+              gpointer receipt_cls)
+{
+  g_assert((snapshot) && (schedule));
+
+  snapshot->schedule = schedule;
+
+  snapshot->receipt_cb = receipt_cb;
+  snapshot->receipt_cls = receipt_cls;
+
+  snapshot->contacts = g_hash_table_new_full(
+    g_direct_hash, g_direct_equal, NULL, g_free
+  );
+
+  snapshot->groups = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  snapshot->messages = g_hash_table_new_full(
+    g_direct_hash, g_direct_equal, NULL, g_free
+  );
+
+  snapshot->dirty_contacts = g_hash_table_new(g_direct_hash, g_direct_equal);
+  snapshot->dirty_groups = g_hash_table_new(g_direct_hash, g_direct_equal);
+  snapshot->dirty_contexts = g_hash_table_new(g_direct_hash, g_direct_equal);
+  snapshot->dirty_messages = g_hash_table_new(g_direct_hash, g_direct_equal);
+  snapshot->dirty_receipts = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  snapshot->unread_messages = g_hash_table_new_full(
+    g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) g_hash_table_destroy
+  );
+
+  snapshot->queued = FALSE;
+}
+
+void
+snapshot_clear(MESSENGER_Snapshot *snapshot)
+{
+  g_assert(snapshot);
+
+  g_hash_table_remove_all(snapshot->contacts);
+  g_hash_table_remove_all(snapshot->groups);
+  g_hash_table_remove_all(snapshot->messages);
+
+  g_hash_table_remove_all(snapshot->dirty_contacts);
+  g_hash_table_remove_all(snapshot->dirty_groups);
+  g_hash_table_remove_all(snapshot->dirty_contexts);
+  g_hash_table_remove_all(snapshot->dirty_messages);
+  g_hash_table_remove_all(snapshot->dirty_receipts);
+  g_hash_table_remove_all(snapshot->unread_messages);
+}
+
+void
+snapshot_cleanup(MESSENGER_Snapshot *snapshot)
+{
+  g_assert(snapshot);
+
+  g_hash_table_destroy(snapshot->contacts);
+  g_hash_table_destroy(snapshot->groups);
+  g_hash_table_destroy(snapshot->messages);
+
+  g_hash_table_destroy(snapshot->dirty_contacts);
+  g_hash_table_destroy(snapshot->dirty_groups);
+  g_hash_table_destroy(snapshot->dirty_contexts);
+  g_hash_table_destroy(snapshot->dirty_messages);
+  g_hash_table_destroy(snapshot->dirty_receipts);
+  g_hash_table_destroy(snapshot->unread_messages);
+}
+
+static void
+_snapshot_update_contact(MESSENGER_Snapshot *snapshot,
+                         struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((snapshot) && (contact));
+
+  MESSENGER_SnapshotContact *entry = g_new(MESSENGER_SnapshotContact, 1);
+
+  entry->blocked = (GNUNET_YES == GNUNET_CHAT_contact_is_blocked(contact));
+
+  g_hash_table_insert(snapshot->contacts, contact, entry);
+}
+
+static void
+_snapshot_update_group(MESSENGER_Snapshot *snapshot,
+                       struct GNUNET_CHAT_Group *group)
+{
+  g_assert((snapshot) && (group));
+
+  const int count = GNUNET_CHAT_group_iterate_contacts(group, NULL, NULL);
+
+  g_hash_table_insert(
+    snapshot->groups,
+    group,
+    GUINT_TO_POINTER(count > 0? (guint) count : 0)
+  );
+}
+
+static int
+_snapshot_iterate_read_receipts(void *cls,
+                                UNUSED struct GNUNET_CHAT_Message *message,
+                                struct GNUNET_CHAT_Contact *contact,
+                                int read_receipt)
+{
+  g_assert((cls) && (contact));
+
+  guint *count = (guint*) cls;
+
+  if ((GNUNET_YES == read_receipt) &&
+      (GNUNET_NO == GNUNET_CHAT_contact_is_owned(contact)))
+    (*count)++;
+
+  return GNUNET_YES;
+}
+
+static gboolean
+_snapshot_update_message(MESSENGER_Snapshot *snapshot,
+                         struct GNUNET_CHAT_Message *message)
+{
+  g_assert((snapshot) && (message));
+
+  const gboolean was_read = (
+    0 < snapshot_get_read_receipts(snapshot, message)
+  );
+
+  guint count = 0;
+
+  if (GNUNET_YES == GNUNET_CHAT_message_is_sent(message))
+    GNUNET_CHAT_message_get_read_receipt(
+      message,
+      _snapshot_iterate_read_receipts,
+      &count
+    );
+
+  // Messages without any receipts don't need an entry
+  if (0 == count)
+  {
+    g_hash_table_remove(snapshot->messages, message);
+    return was_read;
+  }
+
+  MESSENGER_SnapshotMessage *entry = g_new(MESSENGER_SnapshotMessage, 1);
+
+  entry->read_receipts = count;
+
+  g_hash_table_insert(snapshot->messages, message, entry);
+  return was_read != (0 < count);
+}
+
+static gboolean
+_snapshot_publish(gpointer user_data)
+{
+  g_assert(user_data);
+
+  MESSENGER_Snapshot *snapshot = (MESSENGER_Snapshot*) user_data;
+
+  GHashTableIter iter;
+  gpointer key, value;
+
+  snapshot->queued = FALSE;
+
+  // Expand changed contexts to their contact and group
+  g_hash_table_iter_init(&iter, snapshot->dirty_contexts);
+  while (g_hash_table_iter_next(&iter, &key, NULL))
+  {
+    struct GNUNET_CHAT_Context *context = key;
+
+    struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_context_get_contact(
+      context
+    );
+
+    struct GNUNET_CHAT_Group *group = GNUNET_CHAT_context_get_group(
+      context
+    );
+
+    if (contact)
+      g_hash_table_add(snapshot->dirty_contacts, contact);
+
+    if (group)
+      g_hash_table_add(snapshot->dirty_groups, group);
+  }
+
+  // Only sent messages without any read receipt can change their state
+  g_hash_table_iter_init(&iter, snapshot->dirty_receipts);
+  while (g_hash_table_iter_next(&iter, &key, NULL))
+  {
+    GHashTable *unread = g_hash_table_lookup(snapshot->unread_messages, key);
+
+    if (!unread)
+      continue;
+
+    GHashTableIter unread_iter;
+    g_hash_table_iter_init(&unread_iter, unread);
+
+    while (g_hash_table_iter_next(&unread_iter, &value, NULL))
+      if (!g_hash_table_contains(snapshot->dirty_messages, value))
+        g_hash_table_insert(
+          snapshot->dirty_messages,
+          value,
+          SNAPSHOT_MESSAGE_UPDATE
+        );
+  }
+
+  g_hash_table_iter_init(&iter, snapshot->dirty_contacts);
+  while (g_hash_table_iter_next(&iter, &key, NULL))
+    _snapshot_update_contact(snapshot, key);
+
+  g_hash_table_iter_init(&iter, snapshot->dirty_groups);
+  while (g_hash_table_iter_next(&iter, &key, NULL))
+    _snapshot_update_group(snapshot, key);
+
+  GPtrArray *receipts = g_ptr_array_new();
+
+  g_hash_table_iter_init(&iter, snapshot->dirty_messages);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+  {
+    if (SNAPSHOT_MESSAGE_DROP == value)
+      g_hash_table_remove(snapshot->messages, key);
+    else if (_snapshot_update_message(snapshot, key))
+      g_ptr_array_add(receipts, key);
+  }
+
+  // Read messages don't need to be checked for receipts again
+  g_hash_table_iter_init(&iter, snapshot->dirty_receipts);
+  while (g_hash_table_iter_next(&iter, &key, NULL))
+  {
+    GHashTable *unread = g_hash_table_lookup(snapshot->unread_messages, key);
+
+    if (!unread)
+      continue;
+
+    GHashTableIter unread_iter;
+    g_hash_table_iter_init(&unread_iter, unread);
+
+    while (g_hash_table_iter_next(&unread_iter, &value, NULL))
+      if (0 < snapshot_get_read_receipts(snapshot, value))
+        g_hash_table_iter_remove(&unread_iter);
+  }
+
+  g_hash_table_remove_all(snapshot->dirty_contacts);
+  g_hash_table_remove_all(snapshot->dirty_groups);
+  g_hash_table_remove_all(snapshot->dirty_contexts);
+  g_hash_table_remove_all(snapshot->dirty_messages);
+  g_hash_table_remove_all(snapshot->dirty_receipts);
+
+  if (snapshot->receipt_cb)
+    for (guint i = 0; i < receipts->len; i++)
+      snapshot->receipt_cb(
+        snapshot->receipt_cls,
+        g_ptr_array_index(receipts, i)
+      );
+
+  g_ptr_array_free(receipts, TRUE);
+
+  return FALSE;
+}
+
+static void
+_snapshot_enqueue(MESSENGER_Snapshot *snapshot)
+{
+  g_assert(snapshot);
+
+  if (snapshot->queued)
+    return;
+
+  // Publishing happens as part of the batch, in order with its events
+  snapshot->queued = TRUE;
+  schedule_async_run(
+    snapshot->schedule,
+    MESSENGER_SCHEDULE_PRIORITY_INTERACTIVE,
+    _snapshot_publish,
+    snapshot
+  );
+}
+
+void
+snapshot_mark_context(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context)
+{
+  g_assert((snapshot) && (context));
+
+  g_hash_table_add(snapshot->dirty_contexts, context);
+  _snapshot_enqueue(snapshot);
+}
+
+void
+snapshot_mark_receipts(MESSENGER_Snapshot *snapshot,
+                       struct GNUNET_CHAT_Context *context)
+{
+  g_assert((snapshot) && (context));
+
+  g_hash_table_add(snapshot->dirty_receipts, context);
+  _snapshot_enqueue(snapshot);
+}
+
+void
+snapshot_mark_contact(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert(snapshot);
+
+  if (!contact)
+    return;
+
+  g_hash_table_add(snapshot->dirty_contacts, contact);
+  _snapshot_enqueue(snapshot);
+}
+
+void
+snapshot_mark_message(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context,
+                      struct GNUNET_CHAT_Message *message)
+{
+  g_assert((snapshot) && (message));
+
+  if ((context) && (GNUNET_YES == GNUNET_CHAT_message_is_sent(message)))
+  {
+    GHashTable *unread = g_hash_table_lookup(snapshot->unread_messages, context);
+
+    if (!unread)
+    {
+      unread = g_hash_table_new(g_direct_hash, g_direct_equal);
+      g_hash_table_insert(snapshot->unread_messages, context, unread);
+    }
+
+    // Messages leave this table once their read receipts get checked
+    g_hash_table_add(unread, message);
+  }
+
+  g_hash_table_insert(
+    snapshot->dirty_messages,
+    message,
+    SNAPSHOT_MESSAGE_UPDATE
+  );
+
+  _snapshot_enqueue(snapshot);
+}
+
+void
+snapshot_drop_message(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context,
+                      struct GNUNET_CHAT_Message *message)
+{
+  g_assert((snapshot) && (message));
+
+  GHashTable *unread = context? g_hash_table_lookup(
+    snapshot->unread_messages, context
+  ) : NULL;
+
+  if (unread)
+    g_hash_table_remove(unread, message);
+
+  g_hash_table_insert(
+    snapshot->dirty_messages,
+    message,
+    SNAPSHOT_MESSAGE_DROP
+  );
+
+  _snapshot_enqueue(snapshot);
+}
+
+gboolean
+snapshot_is_contact_blocked(const MESSENGER_Snapshot *snapshot,
+                            const struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert(snapshot);
+
+  const MESSENGER_SnapshotContact *entry = g_hash_table_lookup(
+    snapshot->contacts, contact
+  );
+
+  return entry? entry->blocked : FALSE;
+}
+
+guint
+snapshot_get_member_count(const MESSENGER_Snapshot *snapshot,
+                          const struct GNUNET_CHAT_Group *group)
+{
+  g_assert(snapshot);
+
+  return GPOINTER_TO_UINT(g_hash_table_lookup(snapshot->groups, group));
+}
+
+guint
+snapshot_get_read_receipts(const MESSENGER_Snapshot *snapshot,
+                           const struct GNUNET_CHAT_Message *message)
+{
+  g_assert(snapshot);
+
+  const MESSENGER_SnapshotMessage *entry = g_hash_table_lookup(
+    snapshot->messages, message
+  );
+
+  return entry? entry->read_receipts : 0;
+}
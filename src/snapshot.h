@@ -0,0 +1,212 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file snapshot.h
+ */
+
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <glib-2.0/glib.h>
+#include <gnunet/gnunet_chat_lib.h>
+
+#include "schedule.h"
+
+typedef struct MESSENGER_SnapshotContact
+{
+  gboolean blocked;
+} MESSENGER_SnapshotContact;
+
+typedef struct MESSENGER_SnapshotMessage
+{
+  guint read_receipts;
+} MESSENGER_SnapshotMessage;
+
+typedef void (*MESSENGER_SnapshotReceiptCallback)(
+  gpointer cls,
+  struct GNUNET_CHAT_Message *message
+);
+
+typedef struct MESSENGER_Snapshot
+{
+  MESSENGER_Schedule *schedule;
+
+  MESSENGER_SnapshotReceiptCallback receipt_cb;
+  gpointer receipt_cls;
+
+  // Published state (read by the UI)
+  GHashTable *contacts;
+  GHashTable *groups;
+  GHashTable *messages;
+
+  // Pending changes (written by the messenger service)
+  GHashTable *dirty_contacts;
+  GHashTable *dirty_groups;
+  GHashTable *dirty_contexts;
+  GHashTable *dirty_messages;
+  GHashTable *dirty_receipts;
+  GHashTable *unread_messages;
+
+  gboolean queued;
+} MESSENGER_Snapshot;
+
+/**
+ * Initializes a snapshot of the chat state which
+ * gets published through a given schedule once
+ * per batch of changes.
+ *
+ * The published state is only read from the
+ * thread of the schedule, while changes get
+ * marked from the thread of the messenger service.
+ *
+ * The receipt callback gets called on publishing
+ * for each message which got read by someone or
+ * lost all of its read receipts.
+ *
+ * @param snapshot Snapshot
+ * @param schedule Schedule of the reading thread
+ * @param receipt_cb Receipt callback
+ * @param receipt_cls Closure for the receipt callback
+ */
+void
+snapshot_init(MESSENGER_Snapshot *snapshot,
+              MESSENGER_Schedule *schedule,
+              MESSENGER_SnapshotReceiptCallback receipt_cb,
+              gpointer receipt_cls);
+
+/**
+ * Clears all published state and pending changes
+ * of a snapshot. This needs to be called while
+ * both threads are synchronized.
+ *
+ * @param snapshot Snapshot
+ */
+void
+snapshot_clear(MESSENGER_Snapshot *snapshot);
+
+/**
+ * Cleanup a snapshot and all of its resources.
+ *
+ * @param snapshot Snapshot
+ */
+void
+snapshot_cleanup(MESSENGER_Snapshot *snapshot);
+
+/**
+ * Marks a chat context as changed, so that its
+ * contact and group get updated with the next
+ * batch.
+ *
+ * @param snapshot Snapshot
+ * @param context Chat context
+ */
+void
+snapshot_mark_context(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context);
+
+/**
+ * Marks the read receipts of a chat context as
+ * changed, so that its sent messages without any
+ * read receipt yet get updated with the next batch.
+ *
+ * @param snapshot Snapshot
+ * @param context Chat context
+ */
+void
+snapshot_mark_receipts(MESSENGER_Snapshot *snapshot,
+                       struct GNUNET_CHAT_Context *context);
+
+/**
+ * Marks a chat contact as changed, so that its
+ * blocked state gets updated with the next batch.
+ *
+ * @param snapshot Snapshot
+ * @param contact Chat contact
+ */
+void
+snapshot_mark_contact(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Contact *contact);
+
+/**
+ * Marks a chat message of a given context as
+ * changed, so that its read receipts get updated
+ * with the next batch.
+ *
+ * @param snapshot Snapshot
+ * @param context Chat context
+ * @param message Chat message
+ */
+void
+snapshot_mark_message(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context,
+                      struct GNUNET_CHAT_Message *message);
+
+/**
+ * Marks a chat message of a given context as
+ * deleted, so that it gets dropped from the
+ * snapshot with the next batch.
+ *
+ * @param snapshot Snapshot
+ * @param context Chat context
+ * @param message Chat message
+ */
+void
+snapshot_drop_message(MESSENGER_Snapshot *snapshot,
+                      struct GNUNET_CHAT_Context *context,
+                      struct GNUNET_CHAT_Message *message);
+
+/**
+ * Returns whether a chat contact is published as
+ * blocked.
+ *
+ * @param snapshot Snapshot
+ * @param contact Chat contact
+ * @return TRUE if blocked, otherwise FALSE
+ */
+gboolean
+snapshot_is_contact_blocked(const MESSENGER_Snapshot *snapshot,
+                            const struct GNUNET_CHAT_Contact *contact);
+
+/**
+ * Returns the published amount of members of a
+ * chat group.
+ *
+ * @param snapshot Snapshot
+ * @param group Chat group
+ * @return Amount of members
+ */
+guint
+snapshot_get_member_count(const MESSENGER_Snapshot *snapshot,
+                          const struct GNUNET_CHAT_Group *group);
+
+/**
+ * Returns the published amount of read receipts
+ * from other contacts of a chat message.
+ *
+ * @param snapshot Snapshot
+ * @param message Chat message
+ * @return Amount of read receipts
+ */
+guint
+snapshot_get_read_receipts(const MESSENGER_Snapshot *snapshot,
+                           const struct GNUNET_CHAT_Message *message);
+
+#endif /* SNAPSHOT_H_ */
@@ -45,6 +45,25 @@ ui_builder_from_resource(const char *resource_path)
   return builder;
 }
 
+static const gchar*
+_ui_text_as_utf8(const char *text,
+                 gchar **converted)
+{
+  g_assert((text) && (converted));
+
+  *converted = NULL;
+
+  // Most locales use utf8 already, so conversion can be skipped
+  if (!g_get_charset(NULL))
+    *converted = g_locale_to_utf8(text, -1, NULL, NULL, NULL);
+  else if (!g_utf8_validate(text, -1, NULL))
+    *converted = g_utf8_make_valid(text, -1);
+  else
+    return text;
+
+  return *converted;
+}
+
 void
 ui_label_set_text(GtkLabel *label, const char *text)
 {
@@ -56,78 +75,152 @@ ui_label_set_text(GtkLabel *label, const char *text)
     return;
   }
 
-  gchar *_text = g_locale_to_utf8(text, -1, NULL, NULL, NULL);
+  gchar *converted;
+  const gchar *_text = _ui_text_as_utf8(text, &converted);
+
   gtk_label_set_text(label, _text);
-  g_free(_text);
+
+  if (converted)
+    g_free(converted);
 }
 
-void
-ui_label_set_markup_text(GtkLabel *label,
-                         const char *text)
+static void
+_ui_markup_append_escaped(GString *markup,
+                          const gchar *text,
+                          gsize length)
 {
-  g_assert(label);
+  g_assert((markup) && (text));
 
-  if (!text)
+  const gchar *end = text + length;
+  const gchar *plain = text;
+
+  for (const gchar *c = text; c < end; c++)
   {
-    gtk_label_set_markup(label, "");
-    return;
-  }
+    const guchar byte = (guchar) *c;
+    const gchar *entity = NULL;
 
-  gchar *_text = g_locale_to_utf8(text, -1, NULL, NULL, NULL);
-  gchar *_escaped = g_markup_escape_text(_text, -1);
+    switch (byte)
+    {
+      case '&':
+        entity = "&amp;";
+        break;
+      case '<':
+        entity = "&lt;";
+        break;
+      case '>':
+        entity = "&gt;";
+        break;
+      case '\'':
+        entity = "&#39;";
+        break;
+      case '"':
+        entity = "&quot;";
+        break;
+      default:
+        break;
+    }
 
-  if (_escaped)
-  {
-    g_free(_text);
-    _text = _escaped;
-  }
+    const gboolean control = (
+      ((byte < 0x20) && (byte != '\t') && (byte != '\n') && (byte != '\r')) ||
+      (byte == 0x7f)
+    );
 
-  GError *error = NULL;
-  GRegex *regex = g_regex_new(
-    "https?://(www.)?[-a-z0-9@:%._\\+~#=/&?]+",
-    G_REGEX_MULTILINE | G_REGEX_OPTIMIZE,
-    G_REGEX_MATCH_DEFAULT,
-    &error
-  );
+    if ((!entity) && (!control))
+      continue;
 
-  if (error)
-  {
-    fprintf (stderr, "ERROR: %s (%d)\n", error->message, error->code);
-    g_error_free(error);
-    goto skip_regex;
+    g_string_append_len(markup, plain, c - plain);
+
+    if (entity)
+      g_string_append(markup, entity);
+    else
+      g_string_append_printf(markup, "&#x%x;", byte);
+
+    plain = c + 1;
   }
 
-  if (!regex)
-    goto skip_regex;
-
-  gchar *_replaced = g_regex_replace(
-    regex,
-    _text,
-    -1,
-    0,
-    "<a href=\"\\0\">\\0</a>",
-    G_REGEX_MATCH_DEFAULT,
-    &error
+  g_string_append_len(markup, plain, end - plain);
+}
+
+static gsize
+_ui_markup_match_link(const gchar *text)
+{
+  g_assert(text);
+
+  gsize prefix;
+
+  if (0 == strncmp(text, "https://", 8))
+    prefix = 8;
+  else if (0 == strncmp(text, "http://", 7))
+    prefix = 7;
+  else
+    return 0;
+
+  const gsize length = strspn(
+    text + prefix,
+    "-abcdefghijklmnopqrstuvwxyz0123456789@:%._+~#=/&?"
   );
 
-  if (error)
-  {
-    fprintf (stderr, "%s\n", error->message);
-    g_error_free(error);
-  }
+  return length > 0? prefix + length : 0;
+}
+
+gchar*
+ui_markup_from_text(const char *text)
+{
+  if (!text)
+    return g_strdup("");
+
+  gchar *converted;
+  const gchar *_text = _ui_text_as_utf8(text, &converted);
+
+  if (!_text)
+    return g_strdup("");
+
+  GString *markup = g_string_sized_new(strlen(_text) + 16);
+
+  const gchar *plain = _text;
+  const gchar *c = _text;
 
-  if (_replaced)
+  // Escaping and linking happen in a single pass over the text
+  while (*c)
   {
-    g_free(_text);
-    _text = _replaced;
+    const gsize link = ('h' == *c? _ui_markup_match_link(c) : 0);
+
+    if (!link)
+    {
+      c++;
+      continue;
+    }
+
+    _ui_markup_append_escaped(markup, plain, c - plain);
+
+    g_string_append(markup, "<a href=\"");
+    _ui_markup_append_escaped(markup, c, link);
+    g_string_append(markup, "\">");
+    _ui_markup_append_escaped(markup, c, link);
+    g_string_append(markup, "</a>");
+
+    c += link;
+    plain = c;
   }
 
-skip_regex:
-  if (regex)
-    g_regex_unref(regex);
+  _ui_markup_append_escaped(markup, plain, c - plain);
 
-  gtk_label_set_markup(label, _text);
-  g_free(_text);
+  if (converted)
+    g_free(converted);
+
+  return g_string_free(markup, FALSE);
+}
+
+void
+ui_label_set_markup_text(GtkLabel *label,
+                         const char *text)
+{
+  g_assert(label);
+
+  gchar *markup = ui_markup_from_text(text);
+
+  gtk_label_set_markup(label, markup);
+  g_free(markup);
 }
 
 void
@@ -50,6 +50,17 @@ void
 ui_label_set_text(GtkLabel *label,
                   const char *text);
 
+/**
+ * Returns new markup for a given text applying
+ * automatic utf8 conversion, escaping and links
+ * for supported syntax.
+ *
+ * @param text Non-utf8 text
+ * @return New markup
+ */
+gchar*
+ui_markup_from_text(const char *text);
+
 /**
  * Sets the text of a GtkLabel applying automatic utf8
  * conversion and replaces supported syntax with proper
@@ -39,9 +39,15 @@
 #include "account_entry.h"
 
 #include "../application.h"
+#include "../command.h"
+#include "../event.h"
 #include "../file.h"
 #include "../ui.h"
 
+static void
+_chat_update_details(UI_CHAT_Handle *handle,
+                     MESSENGER_Application *app);
+
 static void
 handle_chat_details_folded(GObject* object,
                            GParamSpec* pspec,
@@ -90,6 +96,9 @@ handle_chat_details_folded(GObject* object,
   );
 
   g_value_unset(&value);
+
+  if ((revealed) && (handle->details_outdated))
+    _chat_update_details(handle, handle->app);
 }
 
 static gboolean
@@ -192,12 +201,141 @@ handle_chat_messages_listbox_size_allocate(UNUSED GtkWidget *widget,
 
   const gdouble edge_value = upper - page_size;
 
-  if (value >= handle->edge_value)
+  if (handle->history_anchor > 0.0)
+  {
+    gtk_adjustment_set_value(adjustment, upper - handle->history_anchor);
+    handle->history_anchor = 0.0;
+  }
+  else if (value >= handle->edge_value)
     gtk_adjustment_set_value(adjustment, edge_value);
 
   handle->edge_value = upper - page_size;
 }
 
+static void
+_chat_trim_messages(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  gint index = 0;
+
+  while (handle->message_rows > UI_CHAT_MESSAGE_WINDOW)
+  {
+    GtkListBoxRow *row = gtk_list_box_get_row_at_index(
+      handle->messages_listbox, index
+    );
+
+    if (!row)
+      break;
+
+    UI_MESSAGE_Handle *message = (UI_MESSAGE_Handle*) g_object_get_qdata(
+      G_OBJECT(row), handle->app->quarks.ui
+    );
+
+    // Status messages stay referenced by members and contacts
+    if ((!message) || (!(message->msg)) ||
+        (UI_MESSAGE_STATUS == message->type) ||
+        (gtk_list_box_row_is_selected(row)))
+    {
+      index++;
+      continue;
+    }
+
+    struct GNUNET_CHAT_Message *msg = message->msg;
+
+    // Messages in the history keep their entries in the search index
+    ui_chat_push_history(handle, msg);
+
+    GNUNET_CHAT_message_set_user_pointer(msg, NULL);
+    ui_chat_remove_message(handle, handle->app, message);
+  }
+}
+
+static enum GNUNET_GenericReturnValue
+_chat_iterate_history_tags(void *cls,
+                           struct GNUNET_CHAT_Message *tag_message)
+{
+  g_assert((cls) && (tag_message));
+
+  UI_MESSAGE_Handle *message = (UI_MESSAGE_Handle*) cls;
+
+  ui_message_add_tag(message, message->app, tag_message);
+  return GNUNET_YES;
+}
+
+static void
+_chat_restore_message(UI_CHAT_Handle *handle,
+                      struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  event_render_message(handle->app, handle->context, msg);
+
+  UI_MESSAGE_Handle *message = GNUNET_CHAT_message_get_user_pointer(msg);
+
+  if (!message)
+    return;
+
+  GNUNET_CHAT_message_iterate_tags(
+    msg,
+    _chat_iterate_history_tags,
+    message
+  );
+
+  ui_chat_index_message(handle, message);
+}
+
+static void
+_chat_load_history(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  if (g_queue_is_empty(&(handle->history)))
+    return;
+
+  GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment(
+      handle->chat_scrolled_window
+  );
+
+  // Keep the visible rows in place while older rows get added above
+  handle->history_anchor = (
+    gtk_adjustment_get_upper(adjustment) -
+    gtk_adjustment_get_value(adjustment)
+  );
+
+  for (guint i = 0; i < UI_CHAT_MESSAGE_PAGE; i++)
+  {
+    struct GNUNET_CHAT_Message *msg = g_queue_pop_tail(&(handle->history));
+
+    if (!msg)
+      break;
+
+    g_hash_table_remove(handle->history_links, msg);
+
+    _chat_restore_message(handle, msg);
+  }
+}
+
+static void
+handle_chat_scrolled_window_edge_reached(UNUSED GtkScrolledWindow *window,
+                                         GtkPositionType pos,
+                                         gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
+
+  // Rows of the history get rendered via the chat library
+  application_chat_lock(handle->app);
+
+  if (GTK_POS_TOP == pos)
+    _chat_load_history(handle);
+  else if (GTK_POS_BOTTOM == pos)
+    _chat_trim_messages(handle);
+
+  application_chat_unlock(handle->app);
+}
+
 static void
 handle_reveal_identity_button_click(GtkButton *button,
                                     gpointer user_data)
@@ -258,9 +396,7 @@ handle_block_button_click(UNUSED GtkButton *button,
   if (!contact)
     return;
 
-  application_chat_lock(handle->app);
-  GNUNET_CHAT_contact_set_blocked(contact, GNUNET_YES);
-  application_chat_unlock(handle->app);
+  command_set_blocked(handle->app, contact, TRUE, NULL, NULL);
 
   gtk_stack_set_visible_child(handle->block_stack, GTK_WIDGET(handle->unblock_button));
 }
@@ -280,9 +416,7 @@ handle_unblock_button_click(UNUSED GtkButton *button,
   if (!contact)
     return;
 
-  application_chat_lock(handle->app);
-  GNUNET_CHAT_contact_set_blocked(contact, GNUNET_NO);
-  application_chat_unlock(handle->app);
+  command_set_blocked(handle->app, contact, FALSE, NULL, NULL);
 
   gtk_stack_set_visible_child(handle->block_stack, GTK_WIDGET(handle->block_button));
 }
@@ -309,7 +443,10 @@ handle_leave_chat_button_click(UNUSED GtkButton *button,
   );
 
   if (contact)
+  {
+    roster_remove_contact(&(handle->app->ui.roster), contact);
     GNUNET_CHAT_contact_delete(contact);
+  }
   else if (group)
     GNUNET_CHAT_group_leave(group);
 
@@ -326,65 +463,125 @@ handle_leave_chat_button_click(UNUSED GtkButton *button,
 }
 
 static gint
-handle_chat_messages_sort(GtkListBoxRow* row0,
-                          GtkListBoxRow* row1,
-                          gpointer user_data)
+_chat_find_message_position(UI_CHAT_Handle *handle,
+                            time_t timestamp)
 {
-  g_assert((row0) && (row1) && (user_data));
+  g_assert(handle);
 
-  MESSENGER_Application *app = (MESSENGER_Application*) user_data;
+  gint lower = 0;
+  gint upper = (gint) handle->message_rows;
 
-  UI_MESSAGE_Handle *message0 = (UI_MESSAGE_Handle*) (
-    g_object_get_qdata(G_OBJECT(row0), app->quarks.ui)
-  );
+  if (upper <= 0)
+    return upper;
 
-  UI_MESSAGE_Handle *message1 = (UI_MESSAGE_Handle*) (
-    g_object_get_qdata(G_OBJECT(row1), app->quarks.ui)
-  );
+  GtkListBoxRow *row;
+  UI_MESSAGE_Handle *message;
 
-  if ((!message0) || (!message1))
-    return 0;
+  // Most messages arrive in order and belong behind the last row
+  row = gtk_list_box_get_row_at_index(handle->messages_listbox, upper - 1);
+  message = row? (UI_MESSAGE_Handle*) g_object_get_qdata(
+    G_OBJECT(row), handle->app->quarks.ui
+  ) : NULL;
+
+  if ((message) && (message->timestamp <= timestamp))
+    return upper;
+
+  while (lower < upper)
+  {
+    const gint index = lower + (upper - lower) / 2;
+
+    row = gtk_list_box_get_row_at_index(handle->messages_listbox, index);
+    message = row? (UI_MESSAGE_Handle*) g_object_get_qdata(
+      G_OBJECT(row), handle->app->quarks.ui
+    ) : NULL;
+
+    if ((!message) || (message->timestamp <= timestamp))
+      lower = index + 1;
+    else
+      upper = index;
+  }
+
+  return lower;
+}
+
+static gconstpointer
+_chat_search_item(const UI_MESSAGE_Handle *message)
+{
+  g_assert(message);
+
+  // Messages stay searchable by their chat message without any row
+  if (message->msg)
+    return message->msg;
 
-  time_t timestamp0 = message0->timestamp;
-  time_t timestamp1 = message1->timestamp;
+  return message;
+}
+
+static gint
+_chat_compare_newest(gconstpointer a,
+                     gconstpointer b)
+{
+  const time_t timestamp_a = GNUNET_CHAT_message_get_timestamp(
+    *((const struct GNUNET_CHAT_Message**) a)
+  );
 
-  const double diff = difftime(timestamp0, timestamp1);
+  const time_t timestamp_b = GNUNET_CHAT_message_get_timestamp(
+    *((const struct GNUNET_CHAT_Message**) b)
+  );
 
-  if (diff < -0.0)
+  if (timestamp_a > timestamp_b)
     return -1;
-  else if (diff > +0.0)
+  else if (timestamp_a < timestamp_b)
     return +1;
   else
     return 0;
 }
 
-struct FilterTags
+static gboolean
+_chat_load_matches(UI_CHAT_Handle *handle)
 {
-  const gchar *filter;
-  gboolean matching;
-};
+  g_assert(handle);
 
-static enum GNUNET_GenericReturnValue
-_iterate_message_tags(void *cls,
-                      struct GNUNET_CHAT_Message *message)
-{
-  g_assert((cls) && (message));
+  if ((!(handle->visible)) ||
+      (handle->loaded_matches >= UI_CHAT_MESSAGE_WINDOW))
+    return FALSE;
 
-  struct FilterTags *filterTags = (struct FilterTags*) cls;
+  GPtrArray *matches = g_ptr_array_new();
 
-  const char *text = GNUNET_CHAT_message_get_text(message);
-  if (!text)
-    return GNUNET_YES;
+  GHashTableIter iter;
+  gpointer item;
 
-  gchar *_text = g_locale_to_utf8(text, -1, NULL, NULL, NULL);
-  if (!_text)
-    return GNUNET_YES;
+  g_hash_table_iter_init(&iter, handle->visible);
+  while (g_hash_table_iter_next(&iter, &item, NULL))
+    if (g_hash_table_contains(handle->history_links, item))
+      g_ptr_array_add(matches, item);
 
-  if (g_strstr_len(_text, -1, filterTags->filter))
-    filterTags->matching = TRUE;
+  g_ptr_array_sort(matches, _chat_compare_newest);
 
-  g_free(_text);
-  return filterTags->matching? GNUNET_NO : GNUNET_YES;
+  // Older matches get restored page by page with the next frames
+  guint count = MIN(matches->len, UI_CHAT_MESSAGE_PAGE);
+
+  count = MIN(count, UI_CHAT_MESSAGE_WINDOW - handle->loaded_matches);
+
+  for (guint i = 0; i < count; i++)
+  {
+    struct GNUNET_CHAT_Message *msg = g_ptr_array_index(matches, i);
+    GList *link = g_hash_table_lookup(handle->history_links, msg);
+
+    g_hash_table_remove(handle->history_links, msg);
+    g_queue_delete_link(&(handle->history), link);
+
+    _chat_restore_message(handle, msg);
+  }
+
+  handle->loaded_matches += count;
+
+  const gboolean remaining = (
+    (matches->len > count) &&
+    (handle->loaded_matches < UI_CHAT_MESSAGE_WINDOW)
+  );
+
+  g_ptr_array_free(matches, TRUE);
+  return remaining;
 }
 
 static gboolean
@@ -404,14 +601,7 @@ handle_chat_messages_filter(GtkListBoxRow *row,
     g_object_get_qdata(G_OBJECT(listbox), app->quarks.ui)
   );
 
-  if (!chat)
-    return TRUE;
-
-  const gchar *filter = gtk_entry_get_text(
-    GTK_ENTRY(chat->chat_search_entry)
-  );
-
-  if (!filter)
+  if ((!chat) || (!(chat->visible)))
     return TRUE;
 
   UI_MESSAGE_Handle *message = (UI_MESSAGE_Handle*) (
@@ -421,37 +611,48 @@ handle_chat_messages_filter(GtkListBoxRow *row,
   if (!message)
     return TRUE;
 
-  const gchar *sender = gtk_label_get_text(message->sender_label);
-  const gchar *text = gtk_label_get_text(message->text_label);
+  return g_hash_table_contains(chat->visible, _chat_search_item(message));
+}
 
-  gboolean result = FALSE;
+static gboolean
+_chat_filter_messages(gpointer user_data)
+{
+  g_assert(user_data);
 
-  if (sender)
-    result |= g_str_match_string(filter, sender, TRUE);
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
 
-  if (text)
-    result |= g_str_match_string(filter, text, TRUE);
+  if (handle->visible)
+    g_hash_table_destroy(handle->visible);
 
-  if (('#' == *filter) && (message->msg))
-  {
-    struct FilterTags filterTags;
-    filterTags.filter = &(filter[1]);
-    filterTags.matching = FALSE;
+  handle->visible = search_query(
+    &(handle->search),
+    gtk_entry_get_text(GTK_ENTRY(handle->chat_search_entry))
+  );
 
-    application_chat_lock(app);
+  // Matches from the history need rows to be shown
+  application_chat_lock(handle->app);
+  const gboolean remaining = _chat_load_matches(handle);
+  application_chat_unlock(handle->app);
 
-    GNUNET_CHAT_message_iterate_tags(
-      message->msg,
-      _iterate_message_tags,
-      &filterTags
-    );
+  gtk_list_box_invalidate_filter(handle->messages_listbox);
 
-    application_chat_unlock(app);
+  if (remaining)
+    return TRUE;
 
-    result |= filterTags.matching;
-  }
+  handle->filter_task = 0;
+  return FALSE;
+}
+
+static void
+_chat_enqueue_filter(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  // The filter only needs to be applied once per frame
+  if (handle->filter_task)
+    return;
 
-  return result;
+  handle->filter_task = util_frame_add(_chat_filter_messages, handle);
 }
 
 static void
@@ -609,120 +810,465 @@ _send_text_from_view(MESSENGER_Application *app,
   }
 
   if (handle->context)
-  {
-    application_chat_lock(app);
-    GNUNET_CHAT_context_send_text(handle->context, text);
-    application_chat_unlock(app);
-  }
+    command_send_text(app, handle->context, text, NULL, NULL);
 
   g_free(text);
   gtk_text_buffer_delete(buffer, &start, &end);
   return TRUE;
 }
 
-static void
-_drop_any_recording(UI_CHAT_Handle *handle)
+static UI_CHAT_Pipelines*
+_chat_get_pipelines(UI_CHAT_Handle *handle)
 {
-  g_assert(handle);
-
-  if ((handle->play_pipeline) && (handle->playing))
-  {
-    gst_element_set_state(handle->play_pipeline, GST_STATE_NULL);
-    handle->playing = FALSE;
-  }
+  g_assert((handle) && (handle->app));
 
-  _update_send_record_symbol(
-    gtk_text_view_get_buffer(handle->send_text_view),
-    handle->send_record_symbol,
-    FALSE
-  );
+  UI_MESSENGER_Handle *messenger = &(handle->app->ui.messenger);
 
-  gtk_stack_set_visible_child(handle->send_stack, handle->send_text_box);
+  if (messenger->pipelines)
+    return messenger->pipelines;
 
-  if (handle->recording_filename[0])
-    remove(handle->recording_filename);
+  messenger->pipelines = g_malloc(sizeof(UI_CHAT_Pipelines));
+  memset(messenger->pipelines, 0, sizeof(*(messenger->pipelines)));
 
-  handle->recording_filename[0] = 0;
-  handle->recorded = FALSE;
+  return messenger->pipelines;
 }
 
-static void
-handle_sending_recording_upload_file(UNUSED void *cls,
-                                     struct GNUNET_CHAT_File *file,
-                                     uint64_t completed,
-                                     uint64_t size)
+static gboolean
+_chat_is_recorder(const UI_CHAT_Handle *handle)
 {
-  g_assert(file);
+  g_assert((handle) && (handle->app));
 
-  UI_FILE_LOAD_ENTRY_Handle *file_load = cls;
+  const UI_CHAT_Pipelines *pipelines = handle->app->ui.messenger.pipelines;
 
-  gtk_progress_bar_set_fraction(
-    file_load->load_progress_bar,
-    1.0 * completed / size
-  );
+  return (pipelines) && (pipelines->recorder == handle);
+}
 
-  file_update_upload_info(file, completed, size);
+static gboolean
+_chat_is_player(const UI_CHAT_Handle *handle)
+{
+  g_assert((handle) && (handle->app));
 
-  if ((completed >= size) && (file_load->chat_title))
-    ui_chat_title_remove_file_load(file_load->chat_title, file_load);
+  const UI_CHAT_Pipelines *pipelines = handle->app->ui.messenger.pipelines;
+
+  return (pipelines) && (pipelines->player == handle);
 }
 
 static void
-handle_send_record_button_click(GtkButton *button,
-                                gpointer user_data)
+_stop_recording(UI_CHAT_Handle *handle)
 {
-  g_assert((button) && (user_data));
+  g_assert(handle);
 
-  MESSENGER_Application *app = (MESSENGER_Application*) user_data;
+  if (!_chat_is_recorder(handle))
+    return;
 
-  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) (
-    g_object_get_qdata(G_OBJECT(button), app->quarks.ui)
-  );
+  UI_CHAT_Pipelines *pipelines = handle->app->ui.messenger.pipelines;
 
-  if ((handle->recorded) && (handle->context) &&
-      (handle->recording_filename[0]) &&
-      (!gtk_revealer_get_child_revealed(handle->picker_revealer)))
-  {
-    UI_FILE_LOAD_ENTRY_Handle *file_load = ui_file_load_entry_new(app);
+  gst_element_set_state(pipelines->record_pipeline, GST_STATE_NULL);
+  pipelines->recorder = NULL;
 
-    ui_label_set_text(file_load->file_label, handle->recording_filename);
-    gtk_progress_bar_set_fraction(file_load->load_progress_bar, 0.0);
+  if ((handle->recorded) || (!(handle->recording_filename[0])))
+    return;
 
-    application_chat_lock(app);
+  gtk_widget_set_sensitive(GTK_WIDGET(handle->recording_play_button), TRUE);
 
-    struct GNUNET_CHAT_File *file = GNUNET_CHAT_context_send_file(
-      handle->context,
-      handle->recording_filename,
-      handle_sending_recording_upload_file,
-      file_load
-    );
+  handle->recorded = TRUE;
 
-    if (file)
-    {
-      file_create_info(file);
+  gtk_image_set_from_icon_name(
+    handle->send_record_symbol,
+    "mail-send-symbolic",
+    GTK_ICON_SIZE_BUTTON
+  );
+}
 
-      ui_chat_title_add_file_load(handle->title, file_load);
-    }
-    else if (file_load)
-      ui_file_load_entry_delete(file_load);
+static void
+_stop_playing_recording(UI_CHAT_Handle *handle,
+                        gboolean reset_bar)
+{
+  g_assert(handle);
 
-    application_chat_unlock(app);
+  if (_chat_is_player(handle))
+  {
+    UI_CHAT_Pipelines *pipelines = handle->app->ui.messenger.pipelines;
 
-    _drop_any_recording(handle);
-    return;
+    gst_element_set_state(pipelines->play_pipeline, GST_STATE_NULL);
+    pipelines->player = NULL;
   }
 
-  if (gtk_stack_get_visible_child(handle->send_stack) != handle->send_text_box)
-    return;
+  handle->playing = FALSE;
 
-  GtkTextView *text_view = GTK_TEXT_VIEW(
-    g_object_get_qdata(G_OBJECT(button), app->quarks.widget)
+  gtk_image_set_from_icon_name(
+    handle->play_pause_symbol,
+    "media-playback-start-symbolic",
+    GTK_ICON_SIZE_BUTTON
   );
 
-  _send_text_from_view(app, handle, text_view, handle->send_pressed_time);
-}
-
-static void
+  gtk_progress_bar_set_fraction(
+    handle->recording_progress_bar,
+    reset_bar? 0.0 : 1.0
+  );
+
+  if (handle->play_timer)
+  {
+    util_source_remove(handle->play_timer);
+    handle->play_timer = 0;
+  }
+}
+
+static gboolean
+_record_timer_func(gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
+
+  GString *time_string = g_string_new(NULL);
+
+  g_string_printf(
+    time_string,
+    "%02u:%02u:%02u",
+    (handle->record_time / 3600),
+    (handle->record_time / 60) % 60,
+    (handle->record_time % 60)
+  );
+
+  gtk_label_set_text(handle->recording_label, time_string->str);
+  g_string_free(time_string, TRUE);
+
+  if (!(handle->recorded))
+  {
+    handle->record_time++;
+    handle->record_timer = util_timeout_add_seconds(
+      1,
+      _record_timer_func,
+      handle
+    );
+  }
+  else
+    handle->record_timer = 0;
+
+  return FALSE;
+}
+
+static gboolean
+_play_timer_func(gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
+  gint64 pos, len;
+
+  handle->play_timer = 0;
+
+  if (!_chat_is_player(handle))
+    return FALSE;
+
+  GstElement *pipeline = handle->app->ui.messenger.pipelines->play_pipeline;
+
+  if (!gst_element_query_position(pipeline, GST_FORMAT_TIME, &pos))
+    return FALSE;
+
+  if (!gst_element_query_duration(pipeline, GST_FORMAT_TIME, &len))
+    return FALSE;
+
+  if (pos < len)
+    gtk_progress_bar_set_fraction(
+      handle->recording_progress_bar,
+      1.0 * pos / len
+    );
+  else
+    gtk_progress_bar_set_fraction(
+      handle->recording_progress_bar,
+      1.0
+    );
+
+  if (handle->playing)
+    handle->play_timer = util_timeout_add(
+      10,
+      _play_timer_func,
+      handle
+    );
+
+  return FALSE;
+}
+
+static gboolean
+handle_record_bus_watch(UNUSED GstBus *bus,
+                        GstMessage *msg,
+                        gpointer data)
+{
+  g_assert((msg) && (data));
+
+  UI_CHAT_Pipelines *pipelines = (UI_CHAT_Pipelines*) data;
+  UI_CHAT_Handle *handle = pipelines->recorder;
+  GstMessageType type = GST_MESSAGE_TYPE(msg);
+
+  if (!handle)
+    return TRUE;
+
+  switch (type)
+  {
+    case GST_MESSAGE_STREAM_START:
+      handle->record_time = 0;
+      handle->record_timer = util_idle_add(
+        _record_timer_func,
+        handle
+      );
+
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+handle_play_bus_watch(UNUSED GstBus *bus,
+                      GstMessage *msg,
+                      gpointer data)
+{
+  g_assert((msg) && (data));
+
+  UI_CHAT_Pipelines *pipelines = (UI_CHAT_Pipelines*) data;
+  UI_CHAT_Handle *handle = pipelines->player;
+  GstMessageType type = GST_MESSAGE_TYPE(msg);
+
+  if (!handle)
+    return TRUE;
+
+  switch (type)
+  {
+    case GST_MESSAGE_STATE_CHANGED:
+    {
+      GstState old_state, new_state, pending_state;
+      gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
+
+      if (GST_STATE_PLAYING == new_state)
+        handle->play_timer = util_idle_add(
+          _play_timer_func,
+          handle
+        );
+      else if (GST_STATE_PLAYING == old_state)
+        _stop_playing_recording(handle, FALSE);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      if (handle->playing)
+	      _stop_playing_recording(handle, FALSE);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static GstElement*
+_acquire_record_pipeline(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  UI_CHAT_Pipelines *pipelines = _chat_get_pipelines(handle);
+
+  if (pipelines->recorder == handle)
+    return pipelines->record_pipeline;
+
+  if (pipelines->recorder)
+    _stop_recording(pipelines->recorder);
+
+  if (pipelines->record_pipeline)
+    goto acquire_pipeline;
+
+  pipelines->record_pipeline = gst_parse_launch(
+    "autoaudiosrc ! audioconvert ! vorbisenc ! oggmux ! filesink name=sink",
+    NULL
+  );
+
+  if (!(pipelines->record_pipeline))
+    return NULL;
+
+  pipelines->record_sink = gst_bin_get_by_name(
+    GST_BIN(pipelines->record_pipeline), "sink"
+  );
+
+  {
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipelines->record_pipeline));
+
+    pipelines->record_watch = gst_bus_add_watch(
+      bus,
+      handle_record_bus_watch,
+      pipelines
+    );
+
+    gst_object_unref(bus);
+  }
+
+acquire_pipeline:
+  if (!(pipelines->record_sink))
+    return NULL;
+
+  pipelines->recorder = handle;
+  return pipelines->record_pipeline;
+}
+
+static GstElement*
+_acquire_play_pipeline(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  UI_CHAT_Pipelines *pipelines = _chat_get_pipelines(handle);
+
+  if (pipelines->player == handle)
+    return pipelines->play_pipeline;
+
+  if (pipelines->player)
+    _stop_playing_recording(pipelines->player, TRUE);
+
+  if (pipelines->play_pipeline)
+    goto acquire_pipeline;
+
+  pipelines->play_pipeline = gst_element_factory_make("playbin", NULL);
+  pipelines->play_sink = gst_element_factory_make("autoaudiosink", "asink");
+
+  if ((!(pipelines->play_pipeline)) || (!(pipelines->play_sink)))
+  {
+    if (pipelines->play_pipeline)
+      gst_object_unref(GST_OBJECT(pipelines->play_pipeline));
+
+    if (pipelines->play_sink)
+      gst_object_unref(GST_OBJECT(pipelines->play_sink));
+
+    pipelines->play_pipeline = NULL;
+    pipelines->play_sink = NULL;
+    return NULL;
+  }
+
+  g_object_set(
+      G_OBJECT(pipelines->play_pipeline),
+      "audio-sink",
+      pipelines->play_sink,
+      NULL
+  );
+
+  {
+    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipelines->play_pipeline));
+
+    pipelines->play_watch = gst_bus_add_watch(
+      bus,
+      handle_play_bus_watch,
+      pipelines
+    );
+
+    gst_object_unref(bus);
+  }
+
+acquire_pipeline:
+  pipelines->player = handle;
+  return pipelines->play_pipeline;
+}
+
+static void
+_drop_any_recording(UI_CHAT_Handle *handle)
+{
+  g_assert(handle);
+
+  if (handle->playing)
+    _stop_playing_recording(handle, TRUE);
+
+  _stop_recording(handle);
+
+  _update_send_record_symbol(
+    gtk_text_view_get_buffer(handle->send_text_view),
+    handle->send_record_symbol,
+    FALSE
+  );
+
+  gtk_stack_set_visible_child(handle->send_stack, handle->send_text_box);
+
+  if (handle->recording_filename[0])
+    remove(handle->recording_filename);
+
+  handle->recording_filename[0] = 0;
+  handle->recorded = FALSE;
+}
+
+static void
+handle_sending_recording_upload_file(UNUSED void *cls,
+                                     struct GNUNET_CHAT_File *file,
+                                     uint64_t completed,
+                                     uint64_t size)
+{
+  g_assert(file);
+
+  UI_FILE_LOAD_ENTRY_Handle *file_load = cls;
+
+  gtk_progress_bar_set_fraction(
+    file_load->load_progress_bar,
+    1.0 * completed / size
+  );
+
+  file_update_upload_info(file, completed, size);
+
+  if ((completed >= size) && (file_load->chat_title))
+    ui_chat_title_remove_file_load(file_load->chat_title, file_load);
+}
+
+static void
+handle_send_record_button_click(GtkButton *button,
+                                gpointer user_data)
+{
+  g_assert((button) && (user_data));
+
+  MESSENGER_Application *app = (MESSENGER_Application*) user_data;
+
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) (
+    g_object_get_qdata(G_OBJECT(button), app->quarks.ui)
+  );
+
+  if ((handle->recorded) && (handle->context) &&
+      (handle->recording_filename[0]) &&
+      (!gtk_revealer_get_child_revealed(handle->picker_revealer)))
+  {
+    UI_FILE_LOAD_ENTRY_Handle *file_load = ui_file_load_entry_new(app);
+
+    ui_label_set_text(file_load->file_label, handle->recording_filename);
+    gtk_progress_bar_set_fraction(file_load->load_progress_bar, 0.0);
+
+    application_chat_lock(app);
+
+    struct GNUNET_CHAT_File *file = GNUNET_CHAT_context_send_file(
+      handle->context,
+      handle->recording_filename,
+      handle_sending_recording_upload_file,
+      file_load
+    );
+
+    if (file)
+    {
+      file_create_info(file);
+
+      ui_chat_title_add_file_load(handle->title, file_load);
+    }
+    else if (file_load)
+      ui_file_load_entry_delete(file_load);
+
+    application_chat_unlock(app);
+
+    _drop_any_recording(handle);
+    return;
+  }
+
+  if (gtk_stack_get_visible_child(handle->send_stack) != handle->send_text_box)
+    return;
+
+  GtkTextView *text_view = GTK_TEXT_VIEW(
+    g_object_get_qdata(G_OBJECT(button), app->quarks.widget)
+  );
+
+  _send_text_from_view(app, handle, text_view, handle->send_pressed_time);
+}
+
+static void
 handle_send_later_button_click(GtkButton *button,
                                gpointer user_data)
 {
@@ -807,26 +1353,31 @@ handle_send_record_button_pressed(GtkWidget *widget,
   if (0 < text_len)
     return FALSE;
 
-  if ((handle->recorded) || (!(handle->record_pipeline)) ||
-      (handle->recording_filename[0]) ||
+  if ((handle->recorded) || (handle->recording_filename[0]) ||
       (gtk_revealer_get_child_revealed(handle->picker_revealer)) ||
       (handle->send_text_box != gtk_stack_get_visible_child(handle->send_stack)))
     return FALSE;
 
+  GstElement *pipeline = _acquire_record_pipeline(handle);
+
+  if (!pipeline)
+    return FALSE;
+
   strcpy(handle->recording_filename, "/tmp/rec_XXXXXX.ogg");
 
   int fd = mkstemps(handle->recording_filename, 4);
 
   if (-1 == fd)
+  {
+    handle->recording_filename[0] = 0;
+    _stop_recording(handle);
     return FALSE;
+  }
   else
     close(fd);
 
-  if ((handle->play_pipeline) && (handle->playing))
-  {
-    gst_element_set_state(handle->play_pipeline, GST_STATE_NULL);
-    handle->playing = FALSE;
-  }
+  if (handle->playing)
+    _stop_playing_recording(handle, TRUE);
 
   gtk_image_set_from_icon_name(
     handle->play_pause_symbol,
@@ -847,13 +1398,13 @@ handle_send_record_button_pressed(GtkWidget *widget,
   gtk_stack_set_visible_child(handle->send_stack, handle->send_recording_box);
 
   g_object_set(
-    G_OBJECT(handle->record_sink),
+    G_OBJECT(handle->app->ui.messenger.pipelines->record_sink),
     "location",
     handle->recording_filename,
     NULL
   );
 
-  gst_element_set_state(handle->record_pipeline, GST_STATE_PLAYING);
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
 
   return TRUE;
 }
@@ -903,24 +1454,14 @@ handle_send_record_button_released(GtkWidget *widget,
   if (0 < text_len)
     return FALSE;
 
-  if ((handle->recorded) || (!(handle->record_pipeline)) ||
+  if ((handle->recorded) || (!_chat_is_recorder(handle)) ||
       (!(handle->recording_filename[0])) ||
       (gtk_revealer_get_child_revealed(handle->picker_revealer)) ||
       (handle->send_recording_box != gtk_stack_get_visible_child(
 	  handle->send_stack)))
     return FALSE;
 
-  gtk_widget_set_sensitive(GTK_WIDGET(handle->recording_play_button), TRUE);
-
-  gst_element_set_state(handle->record_pipeline, GST_STATE_NULL);
-  handle->recorded = TRUE;
-
-  gtk_image_set_from_icon_name(
-    handle->send_record_symbol,
-    "mail-send-symbolic",
-    GTK_ICON_SIZE_BUTTON
-  );
-
+  _stop_recording(handle);
   return TRUE;
 }
 
@@ -956,33 +1497,6 @@ handle_recording_close_button_click(UNUSED GtkButton *button,
   _drop_any_recording(handle);
 }
 
-static void
-_stop_playing_recording(UI_CHAT_Handle *handle,
-                        gboolean reset_bar)
-{
-  g_assert(handle);
-
-  gst_element_set_state(handle->play_pipeline, GST_STATE_NULL);
-  handle->playing = FALSE;
-
-  gtk_image_set_from_icon_name(
-    handle->play_pause_symbol,
-    "media-playback-start-symbolic",
-    GTK_ICON_SIZE_BUTTON
-  );
-
-  gtk_progress_bar_set_fraction(
-    handle->recording_progress_bar,
-    reset_bar? 0.0 : 1.0
-  );
-
-  if (handle->play_timer)
-  {
-    util_source_remove(handle->play_timer);
-    handle->play_timer = 0;
-  }
-}
-
 static void
 handle_recording_play_button_click(UNUSED GtkButton *button,
                                    gpointer user_data)
@@ -991,18 +1505,23 @@ handle_recording_play_button_click(UNUSED GtkButton *button,
 
   UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
 
-  if ((!(handle->recorded)) || (!(handle->play_pipeline)))
+  if (!(handle->recorded))
     return;
 
   if (handle->playing)
     _stop_playing_recording(handle, TRUE);
   else if (handle->recording_filename[0])
   {
+    GstElement *pipeline = _acquire_play_pipeline(handle);
+
+    if (!pipeline)
+      return;
+
     GString* uri = g_string_new("file://");
     g_string_append(uri, handle->recording_filename);
 
     g_object_set(
-      G_OBJECT(handle->play_pipeline),
+      G_OBJECT(pipeline),
       "uri",
       uri->str,
       NULL
@@ -1010,7 +1529,7 @@ handle_recording_play_button_click(UNUSED GtkButton *button,
 
     g_string_free(uri, TRUE);
 
-    gst_element_set_state(handle->play_pipeline, GST_STATE_PLAYING);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
     handle->playing = TRUE;
 
     gtk_image_set_from_icon_name(
@@ -1027,9 +1546,10 @@ handle_search_entry_search_changed(UNUSED GtkSearchEntry* search_entry,
 {
   g_assert(user_data);
 
-  GtkListBox *listbox = GTK_LIST_BOX(user_data);
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
 
-  gtk_list_box_invalidate_filter(listbox);
+  handle->loaded_matches = 0;
+  _chat_enqueue_filter(handle);
 }
 
 static void
@@ -1042,6 +1562,16 @@ handle_picker_button_click(UNUSED GtkButton *button,
 
   gboolean reveal = !gtk_revealer_get_child_revealed(handle->picker_revealer);
 
+  if (reveal)
+  {
+    UI_MESSENGER_Handle *messenger = &(handle->app->ui.messenger);
+
+    if (!(messenger->picker))
+      messenger->picker = ui_picker_new(handle->app);
+
+    ui_picker_attach(messenger->picker, handle);
+  }
+
   gtk_revealer_set_reveal_child(handle->picker_revealer, reveal);
 
   _update_send_record_symbol(
@@ -1051,193 +1581,15 @@ handle_picker_button_click(UNUSED GtkButton *button,
   );
 }
 
-static gboolean
-_record_timer_func(gpointer user_data)
-{
-  g_assert(user_data);
-
-  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
-
-  GString *time_string = g_string_new(NULL);
-
-  g_string_printf(
-    time_string,
-    "%02u:%02u:%02u",
-    (handle->record_time / 3600),
-    (handle->record_time / 60) % 60,
-    (handle->record_time % 60)
-  );
-
-  gtk_label_set_text(handle->recording_label, time_string->str);
-  g_string_free(time_string, TRUE);
-
-  if (!(handle->recorded))
-  {
-    handle->record_time++;
-    handle->record_timer = util_timeout_add_seconds(
-      1,
-      _record_timer_func,
-      handle
-    );
-  }
-  else
-    handle->record_timer = 0;
-
-  return FALSE;
-}
-
-static gboolean
-_play_timer_func(gpointer user_data)
-{
-  g_assert(user_data);
-
-  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) user_data;
-  gint64 pos, len;
-
-  handle->play_timer = 0;
-
-  if (!(handle->play_pipeline))
-    return FALSE;
-
-  if (!gst_element_query_position(handle->play_pipeline, GST_FORMAT_TIME, &pos))
-    return FALSE;
-
-  if (!gst_element_query_duration(handle->play_pipeline, GST_FORMAT_TIME, &len))
-    return FALSE;
-
-  if (pos < len)
-    gtk_progress_bar_set_fraction(
-      handle->recording_progress_bar,
-      1.0 * pos / len
-    );
-  else
-    gtk_progress_bar_set_fraction(
-      handle->recording_progress_bar,
-      1.0
-    );
-
-  if (handle->playing)
-    handle->play_timer = util_timeout_add(
-      10,
-      _play_timer_func,
-      handle
-    );
-
-  return FALSE;
-}
-
-static gboolean
-handle_record_bus_watch(UNUSED GstBus *bus,
-                        GstMessage *msg,
-                        gpointer data)
-{
-  g_assert((msg) && (data));
-
-  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) data;
-  GstMessageType type = GST_MESSAGE_TYPE(msg);
-
-  switch (type)
-  {
-    case GST_MESSAGE_STREAM_START:
-      handle->record_time = 0;
-      handle->record_timer = util_idle_add(
-        _record_timer_func,
-        handle
-      );
-
-      break;
-    default:
-      break;
-  }
-
-  return TRUE;
-}
-
-static gboolean
-handle_play_bus_watch(UNUSED GstBus *bus,
-                      GstMessage *msg,
-                      gpointer data)
-{
-  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) data;
-  GstMessageType type = GST_MESSAGE_TYPE(msg);
-
-  switch (type)
-  {
-    case GST_MESSAGE_STATE_CHANGED:
-    {
-      GstState old_state, new_state, pending_state;
-      gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
-
-      if (GST_STATE_PLAYING == new_state)
-        handle->play_timer = util_idle_add(
-          _play_timer_func,
-          handle
-        );
-      else if (GST_STATE_PLAYING == old_state)
-        _stop_playing_recording(handle, FALSE);
-      break;
-    }
-    case GST_MESSAGE_EOS:
-      if (handle->playing)
-	      _stop_playing_recording(handle, FALSE);
-      break;
-    default:
-      break;
-  }
-
-  return TRUE;
-}
-
 static void
-_setup_gst_pipelines(UI_CHAT_Handle *handle)
+_chat_free_markup(gpointer data)
 {
-  g_assert(handle);
-
-  handle->record_pipeline = gst_parse_launch(
-    "autoaudiosrc ! audioconvert ! vorbisenc ! oggmux ! filesink name=sink",
-    NULL
-  );
+  UI_CHAT_Markup *markup = (UI_CHAT_Markup*) data;
 
-  handle->record_sink = gst_bin_get_by_name(
-    GST_BIN(handle->record_pipeline), "sink"
-  );
-
-  {
-    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(handle->record_pipeline));
-
-    handle->record_watch = gst_bus_add_watch(
-      bus,
-      handle_record_bus_watch,
-      handle
-    );
-
-    gst_object_unref(bus);
-  }
-
-  handle->play_pipeline = gst_element_factory_make("playbin", NULL);
-  handle->play_sink = gst_element_factory_make("autoaudiosink", "asink");
-
-  if ((!(handle->play_pipeline)) || (!(handle->play_sink)))
-    return;
-
-  g_object_set(
-      G_OBJECT(handle->play_pipeline),
-      "audio-sink",
-      handle->play_sink,
-      NULL
-  );
-
-  {
-    GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(handle->play_pipeline));
-
-    handle->play_watch = gst_bus_add_watch(
-      bus,
-      handle_play_bus_watch,
-      handle
-    );
+  if (markup->text)
+    g_free(markup->text);
 
-    gst_object_unref(bus);
-  }
+  g_free(markup);
 }
 
 UI_CHAT_Handle*
@@ -1250,11 +1602,19 @@ ui_chat_new(MESSENGER_Application *app,
 
   memset(handle, 0, sizeof(*handle));
 
-  _setup_gst_pipelines(handle);
-
   handle->app = app;
   handle->context = context;
 
+  handle->messages = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  g_queue_init(&(handle->history));
+  handle->history_links = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  g_queue_init(&(handle->markups));
+  handle->markup_links = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  search_init(&(handle->search));
+
   handle->title = ui_chat_title_new(handle->app, handle);
 
   handle->builder = ui_builder_from_resource(
@@ -1382,6 +1742,13 @@ ui_chat_new(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "chat_scrolled_window")
   );
 
+  g_signal_connect(
+    handle->chat_scrolled_window,
+    "edge-reached",
+    G_CALLBACK(handle_chat_scrolled_window_edge_reached),
+    handle
+  );
+
   handle->chat_contacts_listbox = GTK_LIST_BOX(
     gtk_builder_get_object(handle->builder, "chat_contacts_listbox")
   );
@@ -1401,17 +1768,14 @@ ui_chat_new(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "chat_media_flowbox")
   );
 
+  handle->contact_rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+  handle->file_rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+  handle->media_children = g_hash_table_new(g_direct_hash, g_direct_equal);
+
   handle->messages_listbox = GTK_LIST_BOX(
     gtk_builder_get_object(handle->builder, "messages_listbox")
   );
 
-  gtk_list_box_set_sort_func(
-    handle->messages_listbox,
-    handle_chat_messages_sort,
-    app,
-    NULL
-  );
-
   gtk_list_box_set_filter_func(
     handle->messages_listbox,
     handle_chat_messages_filter,
@@ -1423,7 +1787,7 @@ ui_chat_new(MESSENGER_Application *app,
     handle->chat_search_entry,
     "search-changed",
     G_CALLBACK(handle_search_entry_search_changed),
-    handle->messages_listbox
+    handle
   );
 
   g_signal_connect(
@@ -1636,13 +2000,6 @@ ui_chat_new(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "picker_revealer")
   );
 
-  handle->picker = ui_picker_new(app, handle);
-
-  gtk_container_add(
-    GTK_CONTAINER(handle->picker_revealer),
-    handle->picker->picker_box
-  );
-
   g_signal_connect(
     handle->emoji_button,
     "clicked",
@@ -1656,8 +2013,30 @@ ui_chat_new(MESSENGER_Application *app,
 struct IterateChatClosure {
   MESSENGER_Application *app;
   GtkContainer *container;
+  GHashTable *widgets;
+  GHashTable *current;
 };
 
+static void
+_chat_drop_outdated_widgets(struct IterateChatClosure *closure,
+                            GDestroyNotify drop)
+{
+  g_assert((closure) && (drop));
+
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_hash_table_iter_init(&iter, closure->widgets);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+  {
+    if ((closure->current) && (g_hash_table_contains(closure->current, key)))
+      continue;
+
+    g_hash_table_iter_steal(&iter);
+    drop(value);
+  }
+}
+
 static enum GNUNET_GenericReturnValue
 iterate_ui_chat_update_group_contacts(void *cls,
                                       UNUSED struct GNUNET_CHAT_Group *group,
@@ -1667,6 +2046,11 @@ iterate_ui_chat_update_group_contacts(void *cls,
     (struct IterateChatClosure*) cls
   );
 
+  g_hash_table_add(closure->current, contact);
+
+  if (g_hash_table_contains(closure->widgets, contact))
+    return GNUNET_YES;
+
   GtkListBox *listbox = GTK_LIST_BOX(closure->container);
   UI_ACCOUNT_ENTRY_Handle* entry = ui_account_entry_new(closure->app);
 
@@ -1686,9 +2070,19 @@ iterate_ui_chat_update_group_contacts(void *cls,
     (GDestroyNotify) ui_account_entry_delete
   );
 
+  g_hash_table_insert(closure->widgets, contact, row);
   return GNUNET_YES;
 }
 
+static void
+_chat_drop_list_row(gpointer row)
+{
+  g_assert(row);
+
+  // The row owns its entry handle via qdata
+  gtk_widget_destroy(GTK_WIDGET(row));
+}
+
 static void
 _chat_update_contacts(UI_CHAT_Handle *handle,
                       MESSENGER_Application *app,
@@ -1696,36 +2090,21 @@ _chat_update_contacts(UI_CHAT_Handle *handle,
 {
   g_assert((handle) && (app));
 
-  GList* children = gtk_container_get_children(
-    GTK_CONTAINER(handle->chat_contacts_listbox)
-  );
-
-  GList *item = children;
-  while ((item) && (item->next)) {
-    GtkWidget *widget = GTK_WIDGET(item->data);
-    item = item->next;
-
-    gtk_container_remove(
-      GTK_CONTAINER(handle->chat_contacts_listbox),
-      widget
-    );
-  }
-
-  if (children)
-    g_list_free(children);
+  struct IterateChatClosure closure;
+  closure.app = app;
+  closure.container = GTK_CONTAINER(handle->chat_contacts_listbox);
+  closure.widgets = handle->contact_rows;
+  closure.current = g_hash_table_new(g_direct_hash, g_direct_equal);
 
   if (group)
-  {
-    struct IterateChatClosure closure;
-    closure.app = app;
-    closure.container = GTK_CONTAINER(handle->chat_contacts_listbox);
-
     GNUNET_CHAT_group_iterate_contacts(
 	    group,
       iterate_ui_chat_update_group_contacts,
       &closure
     );
-  }
+
+  _chat_drop_outdated_widgets(&closure, _chat_drop_list_row);
+  g_hash_table_destroy(closure.current);
 
   gtk_widget_set_visible(
     GTK_WIDGET(handle->chat_details_contacts_box),
@@ -1735,13 +2114,18 @@ _chat_update_contacts(UI_CHAT_Handle *handle,
 
 static enum GNUNET_GenericReturnValue
 iterate_ui_chat_update_context_files(void *cls,
-                                     struct GNUNET_CHAT_Context *context,
+                                     UNUSED struct GNUNET_CHAT_Context *context,
                                      struct GNUNET_CHAT_File *file)
 {
   struct IterateChatClosure *closure = (
     (struct IterateChatClosure*) cls
   );
 
+  g_hash_table_add(closure->current, file);
+
+  if (g_hash_table_contains(closure->widgets, file))
+    return GNUNET_YES;
+
   GtkListBox *listbox = GTK_LIST_BOX(closure->container);
   UI_FILE_ENTRY_Handle* entry = ui_file_entry_new(closure->app);
   ui_file_entry_update(entry, file);
@@ -1760,6 +2144,7 @@ iterate_ui_chat_update_context_files(void *cls,
     (GDestroyNotify) ui_file_entry_delete
   );
 
+  g_hash_table_insert(closure->widgets, file, row);
   return GNUNET_YES;
 }
 
@@ -1770,27 +2155,11 @@ _chat_update_files(UI_CHAT_Handle *handle,
 {
   g_assert((handle) && (app));
 
-  GList* children = gtk_container_get_children(
-    GTK_CONTAINER(handle->chat_files_listbox)
-  );
-
-  GList *item = children;
-  while (item) {
-    GtkWidget *widget = GTK_WIDGET(item->data);
-    item = item->next;
-
-    gtk_container_remove(
-      GTK_CONTAINER(handle->chat_files_listbox),
-      widget
-    );
-  }
-
-  if (children)
-    g_list_free(children);
-
   struct IterateChatClosure closure;
   closure.app = app;
   closure.container = GTK_CONTAINER(handle->chat_files_listbox);
+  closure.widgets = handle->file_rows;
+  closure.current = g_hash_table_new(g_direct_hash, g_direct_equal);
 
   const int count = context? GNUNET_CHAT_context_iterate_files(
     context,
@@ -1798,6 +2167,9 @@ _chat_update_files(UI_CHAT_Handle *handle,
     &closure
   ) : 0;
 
+  _chat_drop_outdated_widgets(&closure, _chat_drop_list_row);
+  g_hash_table_destroy(closure.current);
+
   gtk_widget_set_visible(
     GTK_WIDGET(handle->chat_details_files_box),
     count? TRUE : FALSE
@@ -1806,24 +2178,27 @@ _chat_update_files(UI_CHAT_Handle *handle,
 
 static enum GNUNET_GenericReturnValue
 iterate_ui_chat_update_context_media(void *cls,
-                                     struct GNUNET_CHAT_Context *context,
+                                     UNUSED struct GNUNET_CHAT_Context *context,
                                      struct GNUNET_CHAT_File *file)
 {
   struct IterateChatClosure *closure = (
     (struct IterateChatClosure*) cls
   );
 
-  GtkFlowBox *flowbox = GTK_FLOW_BOX(closure->container);
-  UI_MEDIA_PREVIEW_Handle* handle = ui_media_preview_new(closure->app);
-  ui_media_preview_update(handle, file);
+  g_hash_table_add(closure->current, file);
+
+  if (g_hash_table_contains(closure->widgets, file))
+    return GNUNET_YES;
 
+  // Files without preview get checked again on the next update
   GdkPixbuf *image = file_get_current_preview_image(file);
 
   if (!image)
-  {
-    ui_media_preview_delete(handle);
     return GNUNET_YES;
-  }
+
+  GtkFlowBox *flowbox = GTK_FLOW_BOX(closure->container);
+  UI_MEDIA_PREVIEW_Handle* handle = ui_media_preview_new(closure->app);
+  ui_media_preview_update(handle, file);
 
   gtk_flow_box_insert(flowbox, handle->media_box, 0);
 
@@ -1841,9 +2216,23 @@ iterate_ui_chat_update_context_media(void *cls,
   gtk_widget_set_size_request(GTK_WIDGET(child), 80, 80);
 
   gtk_widget_show_all(GTK_WIDGET(child));
+
+  g_hash_table_insert(closure->widgets, file, handle);
   return GNUNET_YES;
 }
 
+static void
+_chat_drop_media_preview(gpointer preview)
+{
+  g_assert(preview);
+
+  UI_MEDIA_PREVIEW_Handle *media = (UI_MEDIA_PREVIEW_Handle*) preview;
+  GtkWidget *child = gtk_widget_get_parent(media->media_box);
+
+  ui_media_preview_delete(media);
+  gtk_widget_destroy(child);
+}
+
 static void
 _chat_update_media(UI_CHAT_Handle *handle,
                    MESSENGER_Application *app,
@@ -1851,34 +2240,11 @@ _chat_update_media(UI_CHAT_Handle *handle,
 {
   g_assert((handle) && (app));
 
-  GList* children = gtk_container_get_children(
-    GTK_CONTAINER(handle->chat_media_flowbox)
-  );
-
-  GList *item = children;
-  while (item) {
-    GtkWidget *widget = GTK_WIDGET(item->data);
-    item = item->next;
-
-    UI_MEDIA_PREVIEW_Handle *media = g_object_get_qdata(
-      G_OBJECT(widget),
-      app->quarks.ui
-    );
-
-    ui_media_preview_delete(media);
-
-    gtk_container_remove(
-      GTK_CONTAINER(handle->chat_media_flowbox),
-      widget
-    );
-  }
-
-  if (children)
-    g_list_free(children);
-
   struct IterateChatClosure closure;
   closure.app = app;
   closure.container = GTK_CONTAINER(handle->chat_media_flowbox);
+  closure.widgets = handle->media_children;
+  closure.current = g_hash_table_new(g_direct_hash, g_direct_equal);
 
   const int count = context? GNUNET_CHAT_context_iterate_files(
     context,
@@ -1886,46 +2252,48 @@ _chat_update_media(UI_CHAT_Handle *handle,
     &closure
   ) : 0;
 
+  _chat_drop_outdated_widgets(&closure, _chat_drop_media_preview);
+  g_hash_table_destroy(closure.current);
+
   gtk_widget_set_visible(
     GTK_WIDGET(handle->chat_details_media_box),
     count? TRUE : FALSE
   );
 }
 
-static const gchar*
-_chat_get_default_subtitle(UI_CHAT_Handle *handle,
-                           MESSENGER_Application *app,
-                           struct GNUNET_CHAT_Group* group)
+static void
+_chat_update_details(UI_CHAT_Handle *handle,
+                     MESSENGER_Application *app)
 {
   g_assert((handle) && (app));
 
-  GList *rows = gtk_container_get_children(
-    GTK_CONTAINER(handle->messages_listbox)
+  struct GNUNET_CHAT_Group* group = GNUNET_CHAT_context_get_group(
+    handle->context
   );
 
-  if (!rows)
-    return NULL;
+  _chat_update_contacts(handle, app, group);
+  _chat_update_files(handle, app, handle->context);
+  _chat_update_media(handle, app, handle->context);
 
-  UI_MESSAGE_Handle *last_message = NULL;
-  for (GList *row = rows; row; row = row->next)
-  {
-    UI_MESSAGE_Handle *message = (UI_MESSAGE_Handle*) g_object_get_qdata(
-      G_OBJECT(row->data), app->quarks.ui
-    );
+  handle->details_outdated = FALSE;
+}
 
-    if (!message)
-      continue;
+static const gchar*
+_chat_get_default_subtitle(UI_CHAT_Handle *handle,
+                           MESSENGER_Application *app,
+                           struct GNUNET_CHAT_Group* group)
+{
+  g_assert((handle) && (app));
 
-    ui_message_refresh(message);
-    last_message = message;
-  }
+  if (group)
+    return NULL;
 
-  g_list_free(rows);
+  const UI_MESSAGE_Handle *last_message = handle->last_message;
 
   if ((!last_message) || (!(last_message->timestamp_label)))
     return NULL;
 
-  return group? NULL : gtk_label_get_text(last_message->timestamp_label);
+  return gtk_label_get_text(last_message->timestamp_label);
 }
 
 void
@@ -1940,9 +2308,11 @@ ui_chat_update(UI_CHAT_Handle *handle,
   contact = GNUNET_CHAT_context_get_contact(handle->context);
   group = GNUNET_CHAT_context_get_group(handle->context);
 
-  _chat_update_contacts(handle, app, group);
-  _chat_update_files(handle, app, handle->context);
-  _chat_update_media(handle, app, handle->context);
+  // Details only get updated while they are visible
+  if (hdy_flap_get_reveal_flap(handle->flap_chat_details))
+    _chat_update_details(handle, app);
+  else
+    handle->details_outdated = TRUE;
 
   const gchar *subtitle = _chat_get_default_subtitle(handle, app, group);
 
@@ -1965,7 +2335,7 @@ ui_chat_update(UI_CHAT_Handle *handle,
     contact
   );
 
-  if (GNUNET_YES == GNUNET_CHAT_contact_is_blocked(contact))
+  if (snapshot_is_contact_blocked(&(app->chat.snapshot), contact))
     gtk_stack_set_visible_child(handle->block_stack, GTK_WIDGET(handle->unblock_button));
   else
     gtk_stack_set_visible_child(handle->block_stack, GTK_WIDGET(handle->block_button));
@@ -2020,26 +2390,49 @@ ui_chat_delete(UI_CHAT_Handle *handle)
   if (message_rows)
     g_list_free(message_rows);
 
-  ui_picker_delete(handle->picker);
+  g_hash_table_destroy(handle->messages);
+
+  g_hash_table_destroy(handle->history_links);
+  g_queue_clear(&(handle->history));
+
+  g_hash_table_destroy(handle->markup_links);
+  g_queue_clear_full(&(handle->markups), _chat_free_markup);
+
+  if (handle->filter_task)
+    util_source_remove(handle->filter_task);
+
+  if (handle->visible)
+    g_hash_table_destroy(handle->visible);
+
+  search_cleanup(&(handle->search));
+
+  if (handle->app->ui.messenger.picker)
+    ui_picker_detach(handle->app->ui.messenger.picker, handle);
 
   _chat_update_contacts(handle, handle->app, NULL);
   _chat_update_media(handle, handle->app, NULL);
   _chat_update_files(handle, handle->app, NULL);
 
+  g_hash_table_destroy(handle->contact_rows);
+  g_hash_table_destroy(handle->file_rows);
+  g_hash_table_destroy(handle->media_children);
+
   ui_chat_title_delete(handle->title);
 
   g_object_unref(handle->builder);
 
-  if (handle->record_pipeline)
+  UI_CHAT_Pipelines *pipelines = handle->app->ui.messenger.pipelines;
+
+  if ((pipelines) && (pipelines->recorder == handle))
   {
-    gst_element_set_state(handle->record_pipeline, GST_STATE_NULL);
-    gst_object_unref(GST_OBJECT(handle->record_pipeline));
+    gst_element_set_state(pipelines->record_pipeline, GST_STATE_NULL);
+    pipelines->recorder = NULL;
   }
 
-  if (handle->play_pipeline)
+  if ((pipelines) && (pipelines->player == handle))
   {
-    gst_element_set_state(handle->play_pipeline, GST_STATE_NULL);
-    gst_object_unref(GST_OBJECT(handle->play_pipeline));
+    gst_element_set_state(pipelines->play_pipeline, GST_STATE_NULL);
+    pipelines->player = NULL;
   }
 
   if (handle->recording_filename[0])
@@ -2054,6 +2447,35 @@ ui_chat_delete(UI_CHAT_Handle *handle)
   g_free(handle);
 }
 
+void
+ui_chat_pipelines_delete(UI_CHAT_Pipelines *pipelines)
+{
+  g_assert(pipelines);
+
+  if (pipelines->record_watch)
+    g_source_remove(pipelines->record_watch);
+
+  if (pipelines->play_watch)
+    g_source_remove(pipelines->play_watch);
+
+  if (pipelines->record_sink)
+    gst_object_unref(GST_OBJECT(pipelines->record_sink));
+
+  if (pipelines->record_pipeline)
+  {
+    gst_element_set_state(pipelines->record_pipeline, GST_STATE_NULL);
+    gst_object_unref(GST_OBJECT(pipelines->record_pipeline));
+  }
+
+  if (pipelines->play_pipeline)
+  {
+    gst_element_set_state(pipelines->play_pipeline, GST_STATE_NULL);
+    gst_object_unref(GST_OBJECT(pipelines->play_pipeline));
+  }
+
+  g_free(pipelines);
+}
+
 void
 ui_chat_add_message(UI_CHAT_Handle *handle,
                     MESSENGER_Application *app,
@@ -2061,15 +2483,40 @@ ui_chat_add_message(UI_CHAT_Handle *handle,
 {
   g_assert((handle) && (message) && (message->message_box));
 
-  gtk_container_add(
-    GTK_CONTAINER(handle->messages_listbox),
-    message->message_box
+  const gint position = _chat_find_message_position(
+    handle, message->timestamp
+  );
+
+  gtk_list_box_insert(
+    handle->messages_listbox,
+    message->message_box,
+    position
   );
 
   GtkWidget *row = gtk_widget_get_parent(message->message_box);
   g_object_set_qdata(G_OBJECT(row), app->quarks.ui, message);
 
-  gtk_list_box_invalidate_sort(handle->messages_listbox);
+  if (message->msg)
+    g_hash_table_insert(handle->messages, message->msg, message);
+
+  ui_chat_index_message(handle, message);
+
+  if (position >= (gint) handle->message_rows)
+    handle->last_message = message;
+
+  handle->message_rows++;
+
+  // Rows of search matches stay until the search gets cleared
+  if ((handle->history_anchor > 0.0) || (handle->visible))
+    return;
+
+  GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment(
+      handle->chat_scrolled_window
+  );
+
+  // Only drop older rows while the chat is followed at its bottom
+  if (gtk_adjustment_get_value(adjustment) >= handle->edge_value)
+    _chat_trim_messages(handle);
 }
 
 void
@@ -2082,10 +2529,258 @@ ui_chat_remove_message(UI_CHAT_Handle *handle,
   GtkWidget *row = gtk_widget_get_parent(message->message_box);
   g_object_set_qdata(G_OBJECT(row), app->quarks.ui, NULL);
 
+  if ((message->msg) &&
+      (message == g_hash_table_lookup(handle->messages, message->msg)))
+    g_hash_table_remove(handle->messages, message->msg);
+
+  gconstpointer item = _chat_search_item(message);
+
+  if (!g_hash_table_contains(handle->history_links, item))
+  {
+    search_remove_item(&(handle->search), item);
+
+    if (handle->visible)
+      g_hash_table_remove(handle->visible, item);
+  }
+
   GtkWidget *parent = gtk_widget_get_parent(row);
 
   if (parent == GTK_WIDGET(handle->messages_listbox))
+  {
     gtk_container_remove(GTK_CONTAINER(handle->messages_listbox), row);
+    handle->message_rows--;
+  }
+
+  if (message == handle->last_message)
+  {
+    GtkListBoxRow *last = handle->message_rows > 0?
+      gtk_list_box_get_row_at_index(
+        handle->messages_listbox,
+        (gint) handle->message_rows - 1
+      ) : NULL;
+
+    handle->last_message = last? (UI_MESSAGE_Handle*) g_object_get_qdata(
+      G_OBJECT(last), app->quarks.ui
+    ) : NULL;
+  }
 
   ui_message_delete(message, app);
 }
+
+void
+ui_chat_index_message(UI_CHAT_Handle *handle,
+                      UI_MESSAGE_Handle *message)
+{
+  g_assert((handle) && (message));
+
+  gpointer item = (gpointer) _chat_search_item(message);
+
+  search_remove_item(&(handle->search), item);
+
+  search_add_text(
+    &(handle->search),
+    item,
+    gtk_label_get_text(message->sender_label)
+  );
+
+  search_add_text(
+    &(handle->search),
+    item,
+    gtk_label_get_text(message->text_label)
+  );
+
+  GHashTableIter iter;
+  gpointer tag_message;
+
+  g_hash_table_iter_init(&iter, message->tags);
+  while (g_hash_table_iter_next(&iter, &tag_message, NULL))
+    search_add_tag(
+      &(handle->search),
+      item,
+      GNUNET_CHAT_message_get_text(tag_message)
+    );
+
+  // Changed messages need to be filtered again while searching
+  if (handle->visible)
+    _chat_enqueue_filter(handle);
+}
+
+static enum GNUNET_GenericReturnValue
+_chat_index_history_tag(void *cls,
+                        struct GNUNET_CHAT_Message *tag_message)
+{
+  g_assert((cls) && (tag_message));
+
+  UI_CHAT_Handle *handle = (UI_CHAT_Handle*) cls;
+
+  if (GNUNET_YES == GNUNET_CHAT_message_is_deleted(tag_message))
+    return GNUNET_YES;
+
+  gchar *tag = g_locale_to_utf8(
+    GNUNET_CHAT_message_get_text(tag_message), -1, NULL, NULL, NULL
+  );
+
+  search_add_tag(
+    &(handle->search),
+    GNUNET_CHAT_message_get_target(tag_message),
+    tag
+  );
+
+  g_free(tag);
+  return GNUNET_YES;
+}
+
+void
+ui_chat_index_history(UI_CHAT_Handle *handle,
+                      const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  if (!g_hash_table_contains(handle->history_links, msg))
+    return;
+
+  search_remove_item(&(handle->search), msg);
+
+  struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(msg);
+  struct GNUNET_CHAT_File *file = GNUNET_CHAT_message_get_file(msg);
+
+  search_add_text(
+    &(handle->search),
+    (gpointer) msg,
+    sender? GNUNET_CHAT_contact_get_name(sender) : NULL
+  );
+
+  const char *text = GNUNET_CHAT_message_get_text(msg);
+  gchar *_text = text? g_locale_to_utf8(text, -1, NULL, NULL, NULL) : NULL;
+
+  search_add_text(&(handle->search), (gpointer) msg, _text);
+  g_free(_text);
+
+  if (file)
+    search_add_text(
+      &(handle->search),
+      (gpointer) msg,
+      GNUNET_CHAT_file_get_name(file)
+    );
+
+  GNUNET_CHAT_message_iterate_tags(
+    (struct GNUNET_CHAT_Message*) msg,
+    _chat_index_history_tag,
+    handle
+  );
+
+  if (handle->visible)
+    _chat_enqueue_filter(handle);
+}
+
+void
+ui_chat_push_history(UI_CHAT_Handle *handle,
+                     struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  const time_t timestamp = GNUNET_CHAT_message_get_timestamp(msg);
+
+  // Newer messages get restored first from the tail of the history
+  GList *sibling = handle->history.tail;
+
+  while ((sibling) &&
+         (GNUNET_CHAT_message_get_timestamp(sibling->data) > timestamp))
+    sibling = sibling->prev;
+
+  if (sibling)
+    g_queue_insert_after(&(handle->history), sibling, msg);
+  else
+    g_queue_push_head(&(handle->history), msg);
+
+  g_hash_table_insert(
+    handle->history_links,
+    msg,
+    sibling? sibling->next : handle->history.head
+  );
+
+  // Messages which never had a row get indexed from the chat message
+  if (!search_has_item(&(handle->search), msg))
+    ui_chat_index_history(handle, msg);
+}
+
+UI_MESSAGE_Handle*
+ui_chat_get_message(UI_CHAT_Handle *handle,
+                    const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  return (UI_MESSAGE_Handle*) g_hash_table_lookup(handle->messages, msg);
+}
+
+const gchar*
+ui_chat_get_message_markup(UI_CHAT_Handle *handle,
+                           const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  GList *link = g_hash_table_lookup(handle->markup_links, msg);
+
+  if (link)
+  {
+    g_queue_unlink(&(handle->markups), link);
+    g_queue_push_tail_link(&(handle->markups), link);
+
+    return ((UI_CHAT_Markup*) link->data)->text;
+  }
+
+  UI_CHAT_Markup *markup = g_malloc(sizeof(UI_CHAT_Markup));
+
+  // Restored history doesn't need to render its text again
+  markup->msg = msg;
+  markup->text = ui_markup_from_text(GNUNET_CHAT_message_get_text(msg));
+
+  g_queue_push_tail(&(handle->markups), markup);
+  g_hash_table_insert(
+    handle->markup_links,
+    (gpointer) msg,
+    handle->markups.tail
+  );
+
+  // Only the rows around the visible window need their markup again
+  while (handle->markups.length > UI_CHAT_MARKUP_CACHE)
+  {
+    UI_CHAT_Markup *oldest = g_queue_pop_head(&(handle->markups));
+
+    g_hash_table_remove(handle->markup_links, oldest->msg);
+    _chat_free_markup(oldest);
+  }
+
+  return markup->text;
+}
+
+gboolean
+ui_chat_forget_message(UI_CHAT_Handle *handle,
+                       const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  GList *markup = g_hash_table_lookup(handle->markup_links, msg);
+
+  if (markup)
+  {
+    _chat_free_markup(markup->data);
+
+    g_hash_table_remove(handle->markup_links, msg);
+    g_queue_delete_link(&(handle->markups), markup);
+  }
+
+  GList *link = g_hash_table_lookup(handle->history_links, msg);
+
+  if (!link)
+    return FALSE;
+
+  search_remove_item(&(handle->search), msg);
+
+  if (handle->visible)
+    g_hash_table_remove(handle->visible, msg);
+
+  g_hash_table_remove(handle->history_links, msg);
+  g_queue_delete_link(&(handle->history), link);
+  return TRUE;
+}
@@ -33,13 +33,25 @@
 
 #include <gnunet/gnunet_chat_lib.h>
 
+#include "../search.h"
+
 #define UI_CHAT_SEND_BUTTON_HOLD_INTERVAL 500000 // in microseconds
 
+#define UI_CHAT_MESSAGE_WINDOW 200 // rows kept while following the chat
+#define UI_CHAT_MESSAGE_PAGE 50 // rows restored per history page
+
+#define UI_CHAT_MARKUP_CACHE (UI_CHAT_MESSAGE_WINDOW + UI_CHAT_MESSAGE_PAGE)
+
 typedef struct MESSENGER_Application MESSENGER_Application;
 typedef struct UI_MESSAGE_Handle UI_MESSAGE_Handle;
-typedef struct UI_PICKER_Handle UI_PICKER_Handle;
 typedef struct UI_CHAT_TITLE_Handle UI_CHAT_TITLE_Handle;
 
+typedef struct UI_CHAT_Markup
+{
+  const struct GNUNET_CHAT_Message *msg;
+  gchar *text;
+} UI_CHAT_Markup;
+
 typedef struct UI_CHAT_Handle
 {
   gint64 send_pressed_time;
@@ -54,20 +66,27 @@ typedef struct UI_CHAT_Handle
 
   guint play_timer;
 
-  GstElement *record_pipeline;
-  GstElement *record_sink;
-
-  GstElement *play_pipeline;
-  GstElement *play_sink;
-
-  guint record_watch;
-  guint play_watch;
-
   MESSENGER_Application *app;
   struct GNUNET_CHAT_Context *context;
 
   UI_CHAT_TITLE_Handle *title;
   gdouble edge_value;
+  gdouble history_anchor;
+
+  guint message_rows;
+  GHashTable *messages;
+  UI_MESSAGE_Handle *last_message;
+
+  GQueue history;
+  GHashTable *history_links;
+
+  GQueue markups;
+  GHashTable *markup_links;
+
+  MESSENGER_Search search;
+  GHashTable *visible;
+  guint loaded_matches;
+  guint filter_task;
 
   GtkBuilder *builder;
   GtkWidget *chat_box;
@@ -99,6 +118,11 @@ typedef struct UI_CHAT_Handle
   GtkListBox *chat_contacts_listbox;
   GtkListBox *chat_files_listbox;
   GtkFlowBox *chat_media_flowbox;
+
+  gboolean details_outdated;
+  GHashTable *contact_rows;
+  GHashTable *file_rows;
+  GHashTable *media_children;
   GtkListBox *messages_listbox;
 
   GtkStack *send_stack;
@@ -122,10 +146,23 @@ typedef struct UI_CHAT_Handle
   GtkProgressBar *recording_progress_bar;
 
   GtkRevealer *picker_revealer;
-
-  UI_PICKER_Handle *picker;
 } UI_CHAT_Handle;
 
+typedef struct UI_CHAT_Pipelines
+{
+  UI_CHAT_Handle *recorder;
+  UI_CHAT_Handle *player;
+
+  GstElement *record_pipeline;
+  GstElement *record_sink;
+
+  GstElement *play_pipeline;
+  GstElement *play_sink;
+
+  guint record_watch;
+  guint play_watch;
+} UI_CHAT_Pipelines;
+
 /**
  * Allocates and creates a new chat handle
  * to manage a chat for a given messenger
@@ -160,6 +197,16 @@ ui_chat_update(UI_CHAT_Handle *handle,
 void
 ui_chat_delete(UI_CHAT_Handle *handle);
 
+/**
+ * Frees the audio pipelines which are shared
+ * between all chat handles to record and play
+ * voice messages.
+ *
+ * @param pipelines Chat pipelines
+ */
+void
+ui_chat_pipelines_delete(UI_CHAT_Pipelines *pipelines);
+
 /**
  * Add a message handle to a given chat handle
  * to get listed by it for a messenger
@@ -188,4 +235,82 @@ ui_chat_remove_message(UI_CHAT_Handle *handle,
                        MESSENGER_Application *app,
                        UI_MESSAGE_Handle *message);
 
+/**
+ * Returns the message handle listed by a given
+ * chat handle for a specific chat message.
+ *
+ * @param handle Chat handle
+ * @param msg Chat message
+ * @return Message handle or NULL
+ */
+UI_MESSAGE_Handle*
+ui_chat_get_message(UI_CHAT_Handle *handle,
+                    const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Updates the search index of a given chat handle
+ * for a listed message handle, so that its sender,
+ * text and tags can be found by the search filter.
+ *
+ * @param handle Chat handle
+ * @param message Message handle
+ */
+void
+ui_chat_index_message(UI_CHAT_Handle *handle,
+                      UI_MESSAGE_Handle *message);
+
+/**
+ * Pushes a message to the history of a given
+ * chat handle without creating a row for it.
+ * Messages of the history get restored from
+ * the newest to the oldest by their timestamps.
+ * They stay in the search index of the chat
+ * handle.
+ *
+ * @param handle Chat handle
+ * @param msg Chat message
+ */
+void
+ui_chat_push_history(UI_CHAT_Handle *handle,
+                     struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Updates the search index of a given chat handle
+ * for a message from its history, for example when
+ * the message got tagged.
+ *
+ * @param handle Chat handle
+ * @param msg Chat message
+ */
+void
+ui_chat_index_history(UI_CHAT_Handle *handle,
+                      const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Returns the rendered markup of the text from a
+ * given message. The chat handle caches the markup
+ * of the messages used most recently until the
+ * message gets forgotten. The returned markup is
+ * only valid until the next call.
+ *
+ * @param handle Chat handle
+ * @param msg Chat message
+ * @return Markup of the message text
+ */
+const gchar*
+ui_chat_get_message_markup(UI_CHAT_Handle *handle,
+                           const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Forgets a deleted message from the history and
+ * cached state of a given chat handle.
+ *
+ * @param handle Chat handle
+ * @param msg Chat message
+ * @return TRUE if the message was in the history, otherwise FALSE
+ */
+gboolean
+ui_chat_forget_message(UI_CHAT_Handle *handle,
+                       const struct GNUNET_CHAT_Message *msg);
+
 #endif /* UI_CHAT_H_ */
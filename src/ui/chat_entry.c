@@ -30,11 +30,24 @@
 #include "../application.h"
 #include "../contact.h"
 #include "../discourse.h"
+#include "../event.h"
 #include "../ui.h"
 
 #include <glib-2.0/glib.h>
 #include <gnunet/gnunet_chat_lib.h>
 
+static void
+handle_title_label_changed(UNUSED GObject *object,
+                           UNUSED GParamSpec *pspec,
+                           gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CHAT_ENTRY_Handle *handle = (UI_CHAT_ENTRY_Handle*) user_data;
+
+  ui_messenger_index_chat_entry(&(handle->app->ui.messenger), handle);
+}
+
 UI_CHAT_ENTRY_Handle*
 ui_chat_entry_new(MESSENGER_Application *app,
                   struct GNUNET_CHAT_Context *context)
@@ -45,10 +58,18 @@ ui_chat_entry_new(MESSENGER_Application *app,
 
   memset(handle, 0, sizeof(*handle));
 
+  handle->app = app;
   handle->timestamp = ((time_t) -1);
   handle->context = context;
 
-  handle->chat = ui_chat_new(app, handle->context);
+  g_queue_init(&(handle->deferred));
+
+  handle->deferred_links = g_hash_table_new(g_direct_hash, g_direct_equal);
+  handle->deferred_presences = g_hash_table_new(
+    g_direct_hash,
+    g_direct_equal
+  );
+
   handle->builder = ui_builder_from_resource(
     application_get_resource_path(app, "ui/chat_entry.ui")
   );
@@ -77,6 +98,13 @@ ui_chat_entry_new(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "read_receipt_image")
   );
 
+  g_signal_connect(
+    handle->title_label,
+    "notify::label",
+    G_CALLBACK(handle_title_label_changed),
+    handle
+  );
+
   GNUNET_CHAT_context_set_user_pointer(
     handle->context,
     handle
@@ -85,6 +113,194 @@ ui_chat_entry_new(MESSENGER_Application *app,
   return handle;
 }
 
+static void
+_chat_entry_set_preview(UI_CHAT_ENTRY_Handle *handle,
+                        struct GNUNET_CHAT_Message *msg,
+                        const gchar *text)
+{
+  g_assert(handle);
+
+  if (handle->preview.text)
+    g_free(handle->preview.text);
+
+  handle->preview.msg = msg;
+  handle->preview.text = text? g_strdup(text) : NULL;
+}
+
+static void
+_chat_entry_clear_deferred(UI_CHAT_ENTRY_Handle *handle)
+{
+  g_assert(handle);
+
+  g_queue_clear(&(handle->deferred));
+
+  g_hash_table_remove_all(handle->deferred_links);
+  g_hash_table_remove_all(handle->deferred_presences);
+
+  _chat_entry_set_preview(handle, NULL, NULL);
+}
+
+UI_CHAT_Handle*
+ui_chat_entry_materialize(UI_CHAT_ENTRY_Handle *handle,
+                          MESSENGER_Application *app)
+{
+  g_assert((handle) && (app));
+
+  if (handle->chat)
+    return handle->chat;
+
+  UI_MESSENGER_Handle *ui = &(app->ui.messenger);
+
+  handle->chat = ui_chat_new(app, handle->context);
+
+  gtk_container_add(
+    GTK_CONTAINER(ui->chats_stack),
+    handle->chat->chat_box
+  );
+
+  gtk_container_add(
+    GTK_CONTAINER(ui->chat_title_stack),
+    handle->chat->title->chat_title_box
+  );
+
+  GQueue deferred = handle->deferred;
+  g_queue_init(&(handle->deferred));
+
+  _chat_entry_clear_deferred(handle);
+
+  struct GNUNET_CHAT_Message *msg;
+  while ((msg = g_queue_pop_head(&deferred)))
+  {
+    const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(
+      msg
+    );
+
+    // Older messages only get rows once the history gets scrolled to
+    if ((deferred.length >= UI_CHAT_MESSAGE_WINDOW) &&
+        ((GNUNET_CHAT_KIND_TEXT == kind) || (GNUNET_CHAT_KIND_FILE == kind)))
+      ui_chat_push_history(handle->chat, msg);
+    else
+      event_render_message(app, handle->context, msg);
+  }
+
+  ui_chat_entry_update(handle, app);
+  return handle->chat;
+}
+
+static gboolean
+_chat_entry_is_presence(const struct GNUNET_CHAT_Message *msg)
+{
+  const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(msg);
+
+  return (GNUNET_CHAT_KIND_JOIN == kind) || (GNUNET_CHAT_KIND_LEAVE == kind);
+}
+
+void
+ui_chat_entry_defer_message(UI_CHAT_ENTRY_Handle *handle,
+                            struct GNUNET_CHAT_Message *msg,
+                            const gchar *preview)
+{
+  g_assert((handle) && (!(handle->chat)) && (msg));
+
+  if (g_hash_table_contains(handle->deferred_links, msg))
+    return;
+
+  g_queue_push_tail(&(handle->deferred), msg);
+  g_hash_table_insert(handle->deferred_links, msg, handle->deferred.tail);
+
+  struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(msg);
+
+  if ((sender) && (_chat_entry_is_presence(msg)))
+    g_hash_table_insert(handle->deferred_presences, sender, msg);
+
+  // Only the latest preview gets shown in the chat entry
+  if (preview)
+    _chat_entry_set_preview(handle, msg, preview);
+}
+
+gboolean
+ui_chat_entry_is_deferred(const UI_CHAT_ENTRY_Handle *handle,
+                          const struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  return g_hash_table_contains(handle->deferred_links, msg);
+}
+
+static void
+_chat_entry_restore_preview(UI_CHAT_ENTRY_Handle *handle)
+{
+  g_assert(handle);
+
+  _chat_entry_set_preview(handle, NULL, NULL);
+
+  // Other kinds of messages are rare enough to be left out of the preview
+  for (GList *link = handle->deferred.tail; link; link = link->prev)
+  {
+    struct GNUNET_CHAT_Message *msg = link->data;
+
+    const enum GNUNET_CHAT_MessageKind kind = GNUNET_CHAT_message_get_kind(
+      msg
+    );
+
+    const gchar *text = NULL;
+
+    if (GNUNET_CHAT_KIND_TEXT == kind)
+      text = GNUNET_CHAT_message_get_text(msg);
+    else if (GNUNET_CHAT_KIND_FILE == kind)
+      text = GNUNET_CHAT_file_get_name(GNUNET_CHAT_message_get_file(msg));
+
+    if ((!text) || (!(*text)))
+      continue;
+
+    _chat_entry_set_preview(handle, msg, text);
+    break;
+  }
+}
+
+gboolean
+ui_chat_entry_drop_deferred(UI_CHAT_ENTRY_Handle *handle,
+                            struct GNUNET_CHAT_Message *msg)
+{
+  g_assert((handle) && (msg));
+
+  GList *link = g_hash_table_lookup(handle->deferred_links, msg);
+
+  if (!link)
+    return FALSE;
+
+  g_hash_table_remove(handle->deferred_links, msg);
+  g_queue_delete_link(&(handle->deferred), link);
+
+  struct GNUNET_CHAT_Contact *sender = GNUNET_CHAT_message_get_sender(msg);
+
+  if ((sender) &&
+      (msg == g_hash_table_lookup(handle->deferred_presences, sender)))
+    g_hash_table_remove(handle->deferred_presences, sender);
+
+  if (msg == handle->preview.msg)
+    _chat_entry_restore_preview(handle);
+
+  return TRUE;
+}
+
+gboolean
+ui_chat_entry_drop_deferred_presence(UI_CHAT_ENTRY_Handle *handle,
+                                     struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((handle) && (contact));
+
+  struct GNUNET_CHAT_Message *msg = g_hash_table_lookup(
+    handle->deferred_presences,
+    contact
+  );
+
+  if (!msg)
+    return FALSE;
+
+  return ui_chat_entry_drop_deferred(handle, msg);
+}
+
 static void
 _chat_entry_update_contact(UI_CHAT_ENTRY_Handle *handle,
                            MESSENGER_Application *app,
@@ -116,6 +332,65 @@ _chat_entry_update_contact(UI_CHAT_ENTRY_Handle *handle,
   );
 }
 
+static void
+_chat_entry_update_summary_time(UI_CHAT_ENTRY_Handle *handle)
+{
+  g_assert(handle);
+
+  const time_t now = time(NULL);
+
+  // The label only changes with the message or once it gets older
+  if ((handle->summary.time) &&
+      (handle->summary.timestamp == handle->timestamp) &&
+      ((handle->summary.expiry < 0) || (now < handle->summary.expiry)))
+    return;
+
+  GDateTime *dt_now = g_date_time_new_now_local();
+  GDateTime *dt_message = g_date_time_new_from_unix_local(
+    (gint64) handle->timestamp
+  );
+
+  GTimeSpan span = g_date_time_difference(dt_now, dt_message);
+  gchar *time = NULL;
+  gint64 valid = -1;
+
+  if (span > 7 * G_TIME_SPAN_DAY)
+    time = g_date_time_format(dt_message, "%F");
+  else if (span > 2 * G_TIME_SPAN_DAY)
+  {
+    time = g_date_time_format(dt_message, "%A");
+    valid = 7 * G_TIME_SPAN_DAY;
+  }
+  else if (span > G_TIME_SPAN_DAY)
+  {
+    time = g_date_time_format(dt_message, _("Yesterday"));
+    valid = 2 * G_TIME_SPAN_DAY;
+  }
+  else
+  {
+    time = g_date_time_format(dt_message, "%R");
+    valid = G_TIME_SPAN_DAY;
+  }
+
+  g_date_time_unref(dt_now);
+  g_date_time_unref(dt_message);
+
+  if (!time)
+    return;
+
+  gtk_label_set_text(handle->timestamp_label, time);
+
+  if (handle->summary.time)
+    g_free(handle->summary.time);
+
+  handle->summary.timestamp = handle->timestamp;
+  handle->summary.expiry = valid < 0? -1 : (
+    handle->timestamp + (time_t) (valid / G_TIME_SPAN_SECOND) + 1
+  );
+
+  handle->summary.time = time;
+}
+
 void
 ui_chat_entry_update(UI_CHAT_ENTRY_Handle *handle,
 		                 MESSENGER_Application *app)
@@ -149,91 +424,75 @@ ui_chat_entry_update(UI_CHAT_ENTRY_Handle *handle,
 
   hdy_avatar_set_icon_name(handle->entry_avatar, icon);
 
-  if (!(handle->chat))
-    return;
+  const gchar *text = NULL;
+  const gchar *sender = NULL;
+  gboolean read = FALSE;
 
-  ui_chat_update(handle->chat, app);
+  const time_t previous_timestamp = handle->timestamp;
 
-  GList *rows = gtk_container_get_children(
-    GTK_CONTAINER(handle->chat->messages_listbox)
-  );
+  if (handle->chat)
+  {
+    ui_chat_update(handle->chat, app);
 
-  if (!rows)
-    return;
+    const UI_MESSAGE_Handle *last_message = handle->chat->last_message;
 
-  UI_MESSAGE_Handle *last_message = NULL;
-  for (GList *row = rows; row; row = row->next)
-  {
-    UI_MESSAGE_Handle *message = (UI_MESSAGE_Handle*) g_object_get_qdata(
-      G_OBJECT(row->data), app->quarks.ui
-    );
+    if (!last_message)
+      return;
 
-    if (!message)
-      continue;
+    handle->timestamp = last_message->timestamp;
 
-    last_message = message;
+    text = gtk_label_get_text(last_message->text_label);
+    sender = gtk_label_get_text(last_message->sender_label);
+    read = last_message->read_receipt_image? gtk_widget_is_visible(
+      GTK_WIDGET(last_message->read_receipt_image)
+    ) : FALSE;
   }
+  else
+  {
+    struct GNUNET_CHAT_Message *msg = handle->preview.msg;
 
-  g_list_free(rows);
-
-  if (!last_message)
-    return;
+    if (!msg)
+      return;
 
-  handle->timestamp = last_message->timestamp;
+    handle->timestamp = GNUNET_CHAT_message_get_timestamp(msg);
 
-  GDateTime *dt_now = g_date_time_new_now_local();
-  GDateTime *dt_message = g_date_time_new_from_unix_local(
-    (gint64) handle->timestamp
-  );
+    struct GNUNET_CHAT_Contact *contact = GNUNET_CHAT_message_get_sender(msg);
 
-  GTimeSpan span = g_date_time_difference(dt_now, dt_message);
-  gchar *time = NULL;
+    text = handle->preview.text;
+    sender = contact? GNUNET_CHAT_contact_get_name(contact) : NULL;
+  }
 
-  if (span > 7 * G_TIME_SPAN_DAY)
-    time = g_date_time_format(dt_message, "%F");
-  else if (span > 2 * G_TIME_SPAN_DAY)
-    time = g_date_time_format(dt_message, "%A");
-  else if (span > G_TIME_SPAN_DAY)
-    time = g_date_time_format(dt_message, _("Yesterday"));
-  else
-    time = g_date_time_format(dt_message, "%R");
+  _chat_entry_update_summary_time(handle);
 
-  g_date_time_unref(dt_now);
-  g_date_time_unref(dt_message);
+  gchar *summary_text;
 
-  const gchar *text = gtk_label_get_text(last_message->text_label);
+  if ((group) && (sender))
+    summary_text = g_strdup_printf("%s: %s", sender, text);
+  else
+    summary_text = g_strdup(text);
 
-  if (group)
+  if (0 != g_strcmp0(summary_text, handle->summary.text))
   {
-    GString *message_text = g_string_new(NULL);
+    gtk_label_set_text(handle->text_label, summary_text);
 
-    g_string_append_printf(
-      message_text,
-      "%s: %s",
-      gtk_label_get_text(last_message->sender_label),
-      text
-    );
+    if (handle->summary.text)
+      g_free(handle->summary.text);
 
-    gtk_label_set_text(handle->text_label, message_text->str);
-    g_string_free(message_text, TRUE);
+    handle->summary.text = summary_text;
   }
   else
-    gtk_label_set_text(handle->text_label, text);
+    g_free(summary_text);
 
-  if (time)
-  {
-    gtk_label_set_text(handle->timestamp_label, time);
-    g_free(time);
-  }
+  gtk_widget_set_visible(GTK_WIDGET(handle->read_receipt_image), read);
 
-  gtk_widget_set_visible(
-    GTK_WIDGET(handle->read_receipt_image),
-    last_message->read_receipt_image? gtk_widget_is_visible(
-      GTK_WIDGET(last_message->read_receipt_image)
-    ) : FALSE
-  );
+  if (handle->timestamp == previous_timestamp)
+    return;
+
+  GtkWidget *row = gtk_widget_get_parent(handle->entry_box);
 
-  gtk_list_box_invalidate_sort(app->ui.messenger.chats_listbox);
+  // Only the changed row moves, others keep their order
+  if (row)
+    gtk_list_box_row_changed(GTK_LIST_BOX_ROW(row));
 }
 
 static enum GNUNET_GenericReturnValue
@@ -255,7 +514,19 @@ ui_chat_entry_delete(UI_CHAT_ENTRY_Handle *handle)
 {
   g_assert(handle);
 
-  ui_chat_delete(handle->chat);
+  if (handle->chat)
+    ui_chat_delete(handle->chat);
+
+  _chat_entry_clear_deferred(handle);
+
+  g_hash_table_destroy(handle->deferred_links);
+  g_hash_table_destroy(handle->deferred_presences);
+
+  if (handle->summary.time)
+    g_free(handle->summary.time);
+
+  if (handle->summary.text)
+    g_free(handle->summary.text);
 
   GNUNET_CHAT_context_iterate_discourses(
     handle->context,
@@ -286,6 +557,9 @@ ui_chat_entry_dispose(UI_CHAT_ENTRY_Handle *handle,
 
   ui->chat_entries = g_list_remove(ui->chat_entries, handle);
 
+  g_signal_handlers_disconnect_by_data(handle->title_label, handle);
+  ui_messenger_drop_chat_entry(ui, handle);
+
   gtk_container_remove(
     GTK_CONTAINER(ui->chats_listbox),
     gtk_widget_get_parent(handle->entry_box)
@@ -293,6 +567,9 @@ ui_chat_entry_dispose(UI_CHAT_ENTRY_Handle *handle,
 
   _chat_entry_update_contact(handle, app, NULL);
 
+  if (!(handle->chat))
+    goto skip_chat;
+
   gtk_container_remove(
     GTK_CONTAINER(ui->chat_title_stack),
     handle->chat->title->chat_title_box
@@ -303,5 +580,6 @@ ui_chat_entry_dispose(UI_CHAT_ENTRY_Handle *handle,
     handle->chat->chat_box
   );
 
+skip_chat:
   ui_chat_entry_delete(handle);
 }
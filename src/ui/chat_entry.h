@@ -29,14 +29,37 @@
 
 #include <gnunet/gnunet_chat_lib.h>
 
+typedef struct UI_CHAT_ENTRY_Preview
+{
+  struct GNUNET_CHAT_Message *msg;
+  gchar *text;
+} UI_CHAT_ENTRY_Preview;
+
+typedef struct UI_CHAT_ENTRY_Summary
+{
+  time_t timestamp;
+  time_t expiry;
+  gchar *time;
+  gchar *text;
+} UI_CHAT_ENTRY_Summary;
+
 typedef struct UI_CHAT_ENTRY_Handle
 {
+  MESSENGER_Application *app;
   guint update;
 
   time_t timestamp;
   struct GNUNET_CHAT_Context *context;
 
   UI_CHAT_Handle *chat;
+
+  GQueue deferred;
+  GHashTable *deferred_links;
+  GHashTable *deferred_presences;
+  UI_CHAT_ENTRY_Preview preview;
+
+  UI_CHAT_ENTRY_Summary summary;
+
   GtkBuilder *builder;
 
   GtkWidget *entry_box;
@@ -63,6 +86,75 @@ UI_CHAT_ENTRY_Handle*
 ui_chat_entry_new(MESSENGER_Application *app,
                   struct GNUNET_CHAT_Context *context);
 
+/**
+ * Returns the chat handle of a given chat entry
+ * handle and creates it on first use. The chat
+ * widgets get added to the stacks of the messenger
+ * window and all messages deferred until then
+ * will be rendered into the chat. The caller needs
+ * to hold the lock of the chat schedule.
+ *
+ * @param handle Chat entry handle
+ * @param app Messenger application
+ * @return Chat handle
+ */
+UI_CHAT_Handle*
+ui_chat_entry_materialize(UI_CHAT_ENTRY_Handle *handle,
+                          MESSENGER_Application *app);
+
+/**
+ * Defers a message of a chat entry handle which
+ * has no chat handle yet, so it can be rendered
+ * once the chat gets materialized. An optional
+ * preview text will be shown in the chat entry
+ * in the meantime.
+ *
+ * @param handle Chat entry handle
+ * @param msg Chat message
+ * @param preview Preview text or NULL
+ */
+void
+ui_chat_entry_defer_message(UI_CHAT_ENTRY_Handle *handle,
+                            struct GNUNET_CHAT_Message *msg,
+                            const gchar *preview);
+
+/**
+ * Returns whether a message is deferred by a
+ * chat entry handle.
+ *
+ * @param handle Chat entry handle
+ * @param msg Chat message
+ * @return TRUE if the message is deferred, otherwise FALSE
+ */
+gboolean
+ui_chat_entry_is_deferred(const UI_CHAT_ENTRY_Handle *handle,
+                          const struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Drops a deferred message from a chat entry
+ * handle, returning whether it was deferred.
+ *
+ * @param handle Chat entry handle
+ * @param msg Chat message
+ * @return TRUE if the message was deferred, otherwise FALSE
+ */
+gboolean
+ui_chat_entry_drop_deferred(UI_CHAT_ENTRY_Handle *handle,
+                            struct GNUNET_CHAT_Message *msg);
+
+/**
+ * Drops the deferred presence message of a given
+ * contact from a chat entry handle, returning
+ * whether there was one.
+ *
+ * @param handle Chat entry handle
+ * @param contact Chat contact
+ * @return TRUE if a presence was deferred, otherwise FALSE
+ */
+gboolean
+ui_chat_entry_drop_deferred_presence(UI_CHAT_ENTRY_Handle *handle,
+                                     struct GNUNET_CHAT_Contact *contact);
+
 /**
  * Updates a given chat entry handle with the
  * current state of a messenger application and
@@ -29,6 +29,7 @@
 #include "delete_messages.h"
 #include "message.h"
 
+#include "../command.h"
 #include "../contact.h"
 #include "../ui.h"
 
@@ -131,16 +132,15 @@ _new_tag_callback(MESSENGER_Application *app,
     if ((!message) || (!(message->msg)))
       goto skip_row;
 
-    application_chat_lock(app);
-
-    GNUNET_CHAT_context_send_tag(
+    command_send_tag(
+      app,
       handle->context,
       message->msg,
-      tag
+      tag,
+      NULL,
+      NULL
     );
 
-    application_chat_unlock(app);
-
   skip_row:
     selected = selected->next;
   }
@@ -197,14 +197,7 @@ _delete_messages_callback(MESSENGER_Application *app,
     if ((!message) || (!(message->msg)))
       goto skip_row;
 
-    application_chat_lock(app);
-
-    GNUNET_CHAT_message_delete(
-    	message->msg,
-    	delay
-    );
-
-    application_chat_unlock(app);
+    command_delete_message(app, message->msg, delay, NULL, NULL);
 
   skip_row:
     selected = selected->next;
@@ -466,7 +459,7 @@ ui_chat_title_update(UI_CHAT_TITLE_Handle *handle,
     g_string_append_printf(
       sub,
       _("%d members"),
-      GNUNET_CHAT_group_iterate_contacts(group, NULL, NULL)
+      (int) snapshot_get_member_count(&(app->chat.snapshot), group)
     );
 
     ui_label_set_text(handle->chat_title, title);
@@ -28,6 +28,7 @@
 
 #include "../account.h"
 #include "../application.h"
+#include "../command.h"
 #include "../contact.h"
 #include "../file.h"
 #include "../ui.h"
@@ -273,9 +274,7 @@ handle_block_button_click(UNUSED GtkButton *button,
   if (!(handle->contact))
     return;
 
-  application_chat_lock(handle->app);
-  GNUNET_CHAT_contact_set_blocked(handle->contact, GNUNET_YES);
-  application_chat_unlock(handle->app);
+  command_set_blocked(handle->app, handle->contact, TRUE, NULL, NULL);
 
   gtk_stack_set_visible_child(
     handle->block_stack,
@@ -294,9 +293,7 @@ handle_unblock_button_click(UNUSED GtkButton *button,
   if (!(handle->contact))
     return;
 
-  application_chat_lock(handle->app);
-  GNUNET_CHAT_contact_set_blocked(handle->contact, GNUNET_NO);
-  application_chat_unlock(handle->app);
+  command_set_blocked(handle->app, handle->contact, FALSE, NULL, NULL);
 
   gtk_stack_set_visible_child(
     handle->block_stack, 
@@ -948,6 +945,7 @@ handle_add_tag_button_click(UNUSED GtkButton *button,
   {
     application_chat_lock(handle->app);
     GNUNET_CHAT_contact_tag(handle->contact, tag);
+    roster_update_contact(&(handle->app->ui.roster), handle->contact);
     application_chat_unlock(handle->app);
 
     gtk_list_store_insert_with_values(
@@ -989,6 +987,7 @@ handle_remove_tag_button_click(UNUSED GtkButton *button,
   {
     application_chat_lock(handle->app);
     GNUNET_CHAT_contact_untag(handle->contact, tag);
+    roster_update_contact(&(handle->app->ui.roster), handle->contact);
     application_chat_unlock(handle->app);
 
     gtk_list_store_remove(
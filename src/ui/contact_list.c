@@ -0,0 +1,301 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file ui/contact_list.c
+ */
+
+#include "contact_list.h"
+
+#include "contact_entry.h"
+#include "../application.h"
+
+#define UI_CONTACT_LIST_FILL_BUDGET (UTIL_FRAME_BUDGET / 2)
+
+static gboolean
+handle_contacts_listbox_filter_func(GtkListBoxRow *row,
+                                    gpointer user_data)
+{
+  g_assert((row) && (user_data));
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) user_data;
+
+  if ((!gtk_list_box_row_get_selectable(row)) || (!(handle->visible)))
+    return TRUE;
+
+  struct GNUNET_CHAT_Contact *contact = (struct GNUNET_CHAT_Contact*) (
+    g_object_get_qdata(G_OBJECT(row), handle->app->quarks.data)
+  );
+
+  return g_hash_table_contains(handle->visible, contact);
+}
+
+static gboolean
+_contact_list_filter(gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) user_data;
+
+  handle->filter_task = 0;
+
+  if (handle->visible)
+    g_hash_table_destroy(handle->visible);
+
+  handle->visible = roster_query(
+    &(handle->app->ui.roster),
+    gtk_entry_get_text(handle->search_entry)
+  );
+
+  gtk_list_box_invalidate_filter(handle->listbox);
+  return FALSE;
+}
+
+static void
+_contact_list_enqueue_filter(UI_CONTACT_LIST_Handle *handle)
+{
+  g_assert(handle);
+
+  // The filter only needs to be applied once per frame
+  if (handle->filter_task)
+    return;
+
+  handle->filter_task = util_frame_add(_contact_list_filter, handle);
+}
+
+static void
+handle_contact_search_entry_search_changed(UNUSED GtkSearchEntry* search_entry,
+                                           gpointer user_data)
+{
+  g_assert(user_data);
+
+  _contact_list_enqueue_filter((UI_CONTACT_LIST_Handle*) user_data);
+}
+
+static void
+_contact_list_add_row(UI_CONTACT_LIST_Handle *handle,
+                      struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((handle) && (contact));
+
+  if (g_hash_table_contains(handle->rows, contact))
+    return;
+
+  MESSENGER_Application *app = handle->app;
+
+  UI_CONTACT_ENTRY_Handle *entry = ui_contact_entry_new(app);
+  ui_contact_entry_set_contact(entry, contact);
+
+  // Rows of contacts stay in front of any other rows
+  gtk_list_box_insert(
+    handle->listbox,
+    entry->entry_box,
+    g_hash_table_size(handle->rows)
+  );
+
+  GtkListBoxRow *row = GTK_LIST_BOX_ROW(
+    gtk_widget_get_parent(entry->entry_box)
+  );
+
+  g_object_set_qdata(G_OBJECT(row), app->quarks.data, contact);
+
+  g_object_set_qdata_full(
+    G_OBJECT(row),
+    app->quarks.ui,
+    entry,
+    (GDestroyNotify) ui_contact_entry_delete
+  );
+
+  g_hash_table_insert(handle->rows, contact, row);
+}
+
+static gboolean
+_contact_list_fill(gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) user_data;
+
+  const gint64 start = g_get_monotonic_time();
+
+  while (!g_sequence_iter_is_end(handle->fill))
+  {
+    // Remaining rows get created with the next frames
+    if (g_get_monotonic_time() - start >= UI_CONTACT_LIST_FILL_BUDGET)
+      return TRUE;
+
+    struct GNUNET_CHAT_Contact *contact = g_sequence_get(handle->fill);
+    handle->fill = g_sequence_iter_next(handle->fill);
+
+    _contact_list_add_row(handle, contact);
+  }
+
+  handle->fill = NULL;
+  handle->fill_task = 0;
+  return FALSE;
+}
+
+static void
+_contact_list_stop_fill(UI_CONTACT_LIST_Handle *handle)
+{
+  g_assert(handle);
+
+  if (handle->fill_task)
+    util_source_remove(handle->fill_task);
+
+  handle->fill = NULL;
+  handle->fill_task = 0;
+}
+
+static void
+_contact_list_add_contact(gpointer cls,
+                          struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((cls) && (contact));
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) cls;
+
+  // Contacts added to the roster get reached by the pending fill anyway
+  if (handle->fill)
+    return;
+
+  _contact_list_add_row(handle, contact);
+
+  if (handle->visible)
+    _contact_list_enqueue_filter(handle);
+}
+
+static void
+_contact_list_update_contact(gpointer cls,
+                             UNUSED struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert(cls);
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) cls;
+
+  if (handle->visible)
+    _contact_list_enqueue_filter(handle);
+}
+
+static void
+_contact_list_remove_contact(gpointer cls,
+                             struct GNUNET_CHAT_Contact *contact)
+{
+  g_assert((cls) && (contact));
+
+  UI_CONTACT_LIST_Handle *handle = (UI_CONTACT_LIST_Handle*) cls;
+
+  if ((handle->fill) && (contact == g_sequence_get(handle->fill)))
+  {
+    handle->fill = g_sequence_iter_next(handle->fill);
+
+    if (g_sequence_iter_is_end(handle->fill))
+      _contact_list_stop_fill(handle);
+  }
+
+  GtkWidget *row = GTK_WIDGET(g_hash_table_lookup(handle->rows, contact));
+
+  if (!row)
+    return;
+
+  g_hash_table_remove(handle->rows, contact);
+  gtk_widget_destroy(row);
+
+  if (handle->visible)
+    g_hash_table_remove(handle->visible, contact);
+}
+
+void
+ui_contact_list_init(MESSENGER_Application *app,
+                     UI_CONTACT_LIST_Handle *handle,
+                     GtkListBox *listbox,
+                     GtkEntry *search_entry)
+{
+  g_assert((app) && (handle) && (listbox) && (search_entry));
+
+  handle->app = app;
+
+  handle->listbox = listbox;
+  handle->search_entry = search_entry;
+
+  handle->rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+  handle->visible = NULL;
+
+  handle->filter_task = 0;
+
+  gtk_list_box_set_filter_func(
+    handle->listbox,
+    handle_contacts_listbox_filter_func,
+    handle,
+    NULL
+  );
+
+  g_signal_connect(
+    handle->search_entry,
+    "search-changed",
+    G_CALLBACK(handle_contact_search_entry_search_changed),
+    handle
+  );
+
+  handle->view.add_cb = _contact_list_add_contact;
+  handle->view.update_cb = _contact_list_update_contact;
+  handle->view.remove_cb = _contact_list_remove_contact;
+  handle->view.cls = handle;
+
+  roster_add_view(&(app->ui.roster), &(handle->view));
+
+  handle->fill = roster_get_begin_iter(&(app->ui.roster));
+
+  if (g_sequence_iter_is_end(handle->fill))
+  {
+    handle->fill = NULL;
+    handle->fill_task = 0;
+  }
+  else
+    handle->fill_task = util_frame_add(_contact_list_fill, handle);
+
+  _contact_list_enqueue_filter(handle);
+}
+
+void
+ui_contact_list_cleanup(UI_CONTACT_LIST_Handle *handle)
+{
+  g_assert(handle);
+
+  if (!(handle->app))
+    return;
+
+  roster_remove_view(&(handle->app->ui.roster), &(handle->view));
+
+  _contact_list_stop_fill(handle);
+
+  if (handle->filter_task)
+    util_source_remove(handle->filter_task);
+
+  gtk_list_box_set_filter_func(handle->listbox, NULL, NULL, NULL);
+  g_signal_handlers_disconnect_by_data(handle->search_entry, handle);
+
+  if (handle->visible)
+    g_hash_table_destroy(handle->visible);
+
+  g_hash_table_destroy(handle->rows);
+
+  memset(handle, 0, sizeof(*handle));
+}
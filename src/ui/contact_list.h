@@ -0,0 +1,77 @@
+/*
+   This file is part of GNUnet.
+   Copyright (C) 2024 GNUnet e.V.
+
+   GNUnet is free software: you can redistribute it and/or modify it
+   under the terms of the GNU Affero General Public License as published
+   by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   GNUnet is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Affero General Public License for more details.
+
+   You should have received a copy of the GNU Affero General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+   SPDX-License-Identifier: AGPL3.0-or-later
+ */
+/*
+ * @author Tobias Frisch
+ * @file ui/contact_list.h
+ */
+
+#ifndef UI_CONTACT_LIST_H_
+#define UI_CONTACT_LIST_H_
+
+#include "messenger.h"
+
+#include "../roster.h"
+
+typedef struct UI_CONTACT_LIST_Handle
+{
+  MESSENGER_Application *app;
+  MESSENGER_RosterView view;
+
+  GtkListBox *listbox;
+  GtkEntry *search_entry;
+
+  GHashTable *rows;
+  GHashTable *visible;
+
+  GSequenceIter *fill;
+  guint fill_task;
+  guint filter_task;
+} UI_CONTACT_LIST_Handle;
+
+/**
+ * Binds a list box and its search entry to the
+ * roster of a given messenger application. Rows
+ * for the contacts get created over the next frames
+ * and follow all changes of the roster afterwards.
+ * Contact rows get inserted in front of all rows
+ * which were part of the list box before.
+ *
+ * @param app Messenger application
+ * @param handle Contact list handle
+ * @param listbox List box
+ * @param search_entry Search entry
+ */
+void
+ui_contact_list_init(MESSENGER_Application *app,
+                     UI_CONTACT_LIST_Handle *handle,
+                     GtkListBox *listbox,
+                     GtkEntry *search_entry);
+
+/**
+ * Unbinds the list box of a given contact list
+ * handle from the roster. This needs to be called
+ * before the list box gets destroyed.
+ *
+ * @param handle Contact list handle
+ */
+void
+ui_contact_list_cleanup(UI_CONTACT_LIST_Handle *handle);
+
+#endif /* UI_CONTACT_LIST_H_ */
@@ -24,7 +24,6 @@
 
 #include "contacts.h"
 
-#include "contact_entry.h"
 #include "../application.h"
 #include "../ui.h"
 
@@ -101,97 +100,6 @@ close_dialog:
   gtk_window_close(GTK_WINDOW(app->ui.contacts.dialog));
 }
 
-struct FilterTags
-{
-  const gchar *filter;
-  gboolean matching;
-};
-
-static enum GNUNET_GenericReturnValue
-_iterate_contact_tags(void *cls,
-                      struct GNUNET_CHAT_Contact *contact,
-                      const char *tag)
-{
-  g_assert((cls) && (contact) && (tag));
-
-  struct FilterTags *filterTags = (struct FilterTags*) cls;
-
-  gchar *_tag = g_locale_to_utf8(tag, -1, NULL, NULL, NULL);
-  if (!_tag)
-    return GNUNET_YES;
-
-  if (g_strstr_len(_tag, -1, filterTags->filter))
-    filterTags->matching = TRUE;
-
-  g_free(_tag);
-  return filterTags->matching? GNUNET_NO : GNUNET_YES;
-}
-
-static gboolean
-handle_contacts_listbox_filter_func(GtkListBoxRow *row,
-                                    gpointer user_data)
-{
-  g_assert((row) && (user_data));
-
-  MESSENGER_Application *app = (MESSENGER_Application*) user_data;
-
-  if (!gtk_list_box_row_get_selectable(row))
-    return TRUE;
-
-  const gchar *filter = gtk_entry_get_text(
-    GTK_ENTRY(app->ui.contacts.contact_search_entry)
-  );
-
-  if (!filter)
-    return TRUE;
-
-  UI_CONTACT_ENTRY_Handle *entry = (UI_CONTACT_ENTRY_Handle*) (
-    g_object_get_qdata(G_OBJECT(row), app->quarks.ui)
-  );
-
-  if (!entry)
-    return FALSE;
-
-  const gchar *name = gtk_label_get_text(entry->title_label);
-
-  gboolean result = FALSE;
-
-  if (name)
-    result |= g_str_match_string(filter, name, TRUE);
-
-  if (('#' == *filter) && (entry->contact))
-  {
-    struct FilterTags filterTags;
-    filterTags.filter = &(filter[1]);
-    filterTags.matching = FALSE;
-
-    application_chat_lock(app);
-
-    GNUNET_CHAT_contact_iterate_tags(
-      entry->contact,
-      _iterate_contact_tags,
-      &filterTags
-    );
-
-    application_chat_unlock(app);
-
-    result |= filterTags.matching;
-  }
-
-  return result;
-}
-
-static void
-handle_contact_search_entry_search_changed(UNUSED GtkSearchEntry* search_entry,
-                                           gpointer user_data)
-{
-  g_assert(user_data);
-
-  GtkListBox *listbox = GTK_LIST_BOX(user_data);
-
-  gtk_list_box_invalidate_filter(listbox);
-}
-
 static void
 handle_dialog_destroy(UNUSED GtkWidget *window,
                       gpointer user_data)
@@ -201,42 +109,6 @@ handle_dialog_destroy(UNUSED GtkWidget *window,
   ui_contacts_dialog_cleanup((UI_CONTACTS_Handle*) user_data);
 }
 
-static enum GNUNET_GenericReturnValue
-_iterate_contacts(void *cls,
-                  UNUSED struct GNUNET_CHAT_Handle *handle,
-                  struct GNUNET_CHAT_Contact *contact)
-{
-  g_assert((cls) && (contact));
-
-  if (GNUNET_YES == GNUNET_CHAT_contact_is_owned(contact))
-    return GNUNET_YES;
-
-  MESSENGER_Application *app = (MESSENGER_Application*) cls;
-
-  UI_CONTACT_ENTRY_Handle *entry = ui_contact_entry_new(app);
-  ui_contact_entry_set_contact(entry, contact);
-
-  gtk_list_box_prepend(
-    app->ui.contacts.contacts_listbox,
-    entry->entry_box
-  );
-
-  GtkListBoxRow *row = GTK_LIST_BOX_ROW(
-    gtk_widget_get_parent(entry->entry_box)
-  );
-
-  g_object_set_qdata(G_OBJECT(row), app->quarks.data, contact);
-
-  g_object_set_qdata_full(
-    G_OBJECT(row),
-    app->quarks.ui,
-    entry,
-    (GDestroyNotify) ui_contact_entry_delete
-  );
-
-  return GNUNET_YES;
-}
-
 void
 ui_contacts_dialog_init(MESSENGER_Application *app,
                         UI_CONTACTS_Handle *handle)
@@ -264,20 +136,6 @@ ui_contacts_dialog_init(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "contacts_listbox")
   );
 
-  gtk_list_box_set_filter_func(
-    handle->contacts_listbox,
-    handle_contacts_listbox_filter_func,
-    app,
-    NULL
-  );
-
-  g_signal_connect(
-    handle->contact_search_entry,
-    "search-changed",
-    G_CALLBACK(handle_contact_search_entry_search_changed),
-    handle->contacts_listbox
-  );
-
   g_signal_connect(
     handle->contacts_listbox,
     "row-activated",
@@ -303,13 +161,12 @@ ui_contacts_dialog_init(MESSENGER_Application *app,
     handle
   );
 
-  GNUNET_CHAT_iterate_contacts(
-    app->chat.messenger.handle,
-    _iterate_contacts,
-    app
+  ui_contact_list_init(
+    app,
+    &(handle->contact_list),
+    handle->contacts_listbox,
+    GTK_ENTRY(handle->contact_search_entry)
   );
-
-  gtk_list_box_invalidate_filter(handle->contacts_listbox);
 }
 
 void
@@ -317,6 +174,8 @@ ui_contacts_dialog_cleanup(UI_CONTACTS_Handle *handle)
 {
   g_assert(handle);
 
+  ui_contact_list_cleanup(&(handle->contact_list));
+
   if (handle->builder)
     g_object_unref(handle->builder);
 
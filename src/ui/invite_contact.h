@@ -26,6 +26,7 @@
 #define UI_INVITE_CONTACT_H_
 
 #include "messenger.h"
+#include "contact_list.h"
 
 typedef struct UI_INVITE_CONTACT_Handle
 {
@@ -35,6 +36,7 @@ typedef struct UI_INVITE_CONTACT_Handle
   GtkSearchEntry *contact_search_entry;
 
   GtkListBox *contacts_listbox;
+  UI_CONTACT_LIST_Handle contact_list;
 
   GtkButton *close_button;
 } UI_INVITE_CONTACT_Handle;
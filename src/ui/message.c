@@ -320,42 +320,49 @@ ui_message_new(MESSENGER_Application *app,
       break;
   }
 
-  handle->builder[0] = ui_builder_from_resource(
+  // Rows only keep their widgets, the builder gets dropped afterwards
+  GtkBuilder *builder = ui_builder_from_resource(
     application_get_resource_path(app, ui_builder_file)
   );
 
+  gtk_builder_add_from_resource(
+    builder,
+    application_get_resource_path(app, "ui/message_content.ui"),
+    NULL
+  );
+
   handle->message_box = GTK_WIDGET(
-    gtk_builder_get_object(handle->builder[0], "message_box")
+    gtk_builder_get_object(builder, "message_box")
   );
 
   handle->sender_avatar = HDY_AVATAR(
-    gtk_builder_get_object(handle->builder[0], "sender_avatar")
+    gtk_builder_get_object(builder, "sender_avatar")
   );
 
   handle->sender_label = GTK_LABEL(
-    gtk_builder_get_object(handle->builder[0], "sender_label")
+    gtk_builder_get_object(builder, "sender_label")
   );
 
   handle->private_image = GTK_IMAGE(
-    gtk_builder_get_object(handle->builder[0], "private_image")
+    gtk_builder_get_object(builder, "private_image")
   );
 
   if (UI_MESSAGE_STATUS == handle->type)
   {
     handle->deny_revealer = GTK_REVEALER(
-	    gtk_builder_get_object(handle->builder[0], "deny_revealer")
+	    gtk_builder_get_object(builder, "deny_revealer")
     );
 
     handle->accept_revealer = GTK_REVEALER(
-    	gtk_builder_get_object(handle->builder[0], "accept_revealer")
+    	gtk_builder_get_object(builder, "accept_revealer")
     );
 
     handle->deny_button = GTK_BUTTON(
-	    gtk_builder_get_object(handle->builder[0], "deny_button")
+	    gtk_builder_get_object(builder, "deny_button")
     );
 
     handle->accept_button = GTK_BUTTON(
-	    gtk_builder_get_object(handle->builder[0], "accept_button")
+	    gtk_builder_get_object(builder, "accept_button")
     );
 
     g_object_set_qdata(G_OBJECT(handle->accept_button), app->quarks.ui, handle);
@@ -385,47 +392,45 @@ ui_message_new(MESSENGER_Application *app,
   }
 
   GtkContainer *content_box = GTK_CONTAINER(
-    gtk_builder_get_object(handle->builder[0], "content_box")
+    gtk_builder_get_object(builder, "content_box")
   );
 
   handle->tag_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder[0], "tag_flow_box")
+    gtk_builder_get_object(builder, "tag_flow_box")
   );
 
-  handle->builder[1] = ui_builder_from_resource(
-    application_get_resource_path(app, "ui/message_content.ui")
-  );
+  handle->tags = g_hash_table_new(g_direct_hash, g_direct_equal);
 
   handle->timestamp_label = GTK_LABEL(
-    gtk_builder_get_object(handle->builder[1], "timestamp_label")
+    gtk_builder_get_object(builder, "timestamp_label")
   );
 
   handle->read_receipt_image = GTK_IMAGE(
-    gtk_builder_get_object(handle->builder[1], "read_receipt_image")
+    gtk_builder_get_object(builder, "read_receipt_image")
   );
 
   handle->content_stack = GTK_STACK(
-    gtk_builder_get_object(handle->builder[1], "content_stack")
+    gtk_builder_get_object(builder, "content_stack")
   );
 
   handle->text_label = GTK_LABEL(
-    gtk_builder_get_object(handle->builder[1], "text_label")
+    gtk_builder_get_object(builder, "text_label")
   );
 
   handle->file_revealer = GTK_REVEALER(
-    gtk_builder_get_object(handle->builder[1], "file_revealer")
+    gtk_builder_get_object(builder, "file_revealer")
   );
 
   handle->filename_label = GTK_LABEL(
-    gtk_builder_get_object(handle->builder[1], "filename_label")
+    gtk_builder_get_object(builder, "filename_label")
   );
 
   handle->file_progress_bar = GTK_PROGRESS_BAR(
-    gtk_builder_get_object(handle->builder[1], "file_progress_bar")
+    gtk_builder_get_object(builder, "file_progress_bar")
   );
 
   handle->file_button = GTK_BUTTON(
-    gtk_builder_get_object(handle->builder[1], "file_button")
+    gtk_builder_get_object(builder, "file_button")
   );
 
   g_signal_connect(
@@ -436,13 +441,13 @@ ui_message_new(MESSENGER_Application *app,
   );
 
   handle->file_status_image = GTK_IMAGE(
-    gtk_builder_get_object(handle->builder[1], "file_status_image")
+    gtk_builder_get_object(builder, "file_status_image")
   );
 
   g_object_set_qdata(G_OBJECT(handle->file_button), app->quarks.ui, handle);
 
   handle->preview_drawing_area = GTK_DRAWING_AREA(
-    gtk_builder_get_object(handle->builder[1], "preview_drawing_area")
+    gtk_builder_get_object(builder, "preview_drawing_area")
   );
 
   g_signal_connect(
@@ -453,23 +458,23 @@ ui_message_new(MESSENGER_Application *app,
   );
 
   handle->media_revealer = GTK_REVEALER(
-    gtk_builder_get_object(handle->builder[1], "media_revealer")
+    gtk_builder_get_object(builder, "media_revealer")
   );
 
   handle->media_type_image = GTK_IMAGE(
-    gtk_builder_get_object(handle->builder[1], "media_type_image")
+    gtk_builder_get_object(builder, "media_type_image")
   );
 
   handle->media_label = GTK_LABEL(
-    gtk_builder_get_object(handle->builder[1], "media_label")
+    gtk_builder_get_object(builder, "media_label")
   );
 
   handle->media_progress_bar = GTK_PROGRESS_BAR(
-    gtk_builder_get_object(handle->builder[1], "media_progress_bar")
+    gtk_builder_get_object(builder, "media_progress_bar")
   );
 
   handle->media_button = GTK_BUTTON(
-    gtk_builder_get_object(handle->builder[1], "media_button")
+    gtk_builder_get_object(builder, "media_button")
   );
 
   handle->app = app;
@@ -493,27 +498,13 @@ ui_message_new(MESSENGER_Application *app,
   }
 
   gtk_container_add(content_box, GTK_WIDGET(
-    gtk_builder_get_object(handle->builder[1], "message_content_box")
+    gtk_builder_get_object(builder, "message_content_box")
   ));
 
-  return handle;
-}
+  g_object_ref(handle->message_box);
+  g_object_unref(builder);
 
-static int
-_iterate_read_receipts(void *cls,
-                       UNUSED struct GNUNET_CHAT_Message *message,
-                       struct GNUNET_CHAT_Contact *contact,
-                       int read_receipt)
-{
-  g_assert((cls) && (message) && (contact));
-
-  int *count_read_receipts = (int*) cls;
-
-  if ((GNUNET_YES == read_receipt) &&
-      (GNUNET_NO == GNUNET_CHAT_contact_is_owned(contact)))
-    (*count_read_receipts)++;
-
-  return GNUNET_YES;
+  return handle;
 }
 
 void
@@ -528,9 +519,12 @@ ui_message_refresh(UI_MESSAGE_Handle *handle)
   if (!(handle->read_receipt_image))
     return;
 
-  int count = 0;
-  if ((0 < GNUNET_CHAT_message_get_read_receipt(handle->msg, _iterate_read_receipts, &count)) &&
-      (0 < count))
+  const guint count = snapshot_get_read_receipts(
+    &(handle->app->chat.snapshot),
+    handle->msg
+  );
+
+  if (0 < count)
     gtk_widget_show(GTK_WIDGET(handle->read_receipt_image));
   else
     gtk_widget_hide(GTK_WIDGET(handle->read_receipt_image));
@@ -610,7 +604,7 @@ _update_message_with_file(UI_MESSAGE_Handle *handle,
   );
 
   if (prev)
-    file_remove_widget_from_preview(file, GTK_WIDGET(handle->preview_drawing_area));
+    file_remove_widget_from_preview(prev, GTK_WIDGET(handle->preview_drawing_area));
   if (file)
     file_add_widget_to_preview(file, GTK_WIDGET(handle->preview_drawing_area));
 
@@ -832,7 +826,8 @@ ui_message_add_tag(UI_MESSAGE_Handle *handle,
   g_assert((handle) && (app) && (tag_message));
 
   if ((GNUNET_CHAT_KIND_TAG != GNUNET_CHAT_message_get_kind(tag_message)) ||
-      (GNUNET_CHAT_message_get_target(tag_message) != handle->msg))
+      (GNUNET_CHAT_message_get_target(tag_message) != handle->msg) ||
+      (g_hash_table_contains(handle->tags, tag_message)))
     return;
 
   const char *tag_value = GNUNET_CHAT_message_get_text(tag_message);
@@ -845,6 +840,12 @@ ui_message_add_tag(UI_MESSAGE_Handle *handle,
 
   gtk_container_add(GTK_CONTAINER(handle->tag_flow_box), GTK_WIDGET(tag->tag_label));
   gtk_widget_show_all(GTK_WIDGET(tag->tag_label));
+
+  g_hash_table_insert(
+    handle->tags,
+    tag_message,
+    gtk_widget_get_parent(GTK_WIDGET(tag->tag_label))
+  );
 }
 
 static void
@@ -886,46 +887,12 @@ ui_message_remove_tag(UI_MESSAGE_Handle *handle,
       (GNUNET_CHAT_message_get_target(tag_message) != handle->msg))
     return;
   
-  GList *children = gtk_container_get_children(GTK_CONTAINER(handle->tag_flow_box));
-
-  if (!children)
-    return;
-
-  GtkWidget *removable = NULL;
-
-  GList *list = children;
-  while (list)
-  {
-    GtkFlowBoxChild *child = GTK_FLOW_BOX_CHILD(list->data);
-    GList *items = gtk_container_get_children(GTK_CONTAINER(child));
-
-    if (items)
-    {
-      GtkLabel *tag_label = GTK_LABEL(items->data);
-
-      const struct GNUNET_CHAT_Message *msg = g_object_get_qdata(
-        G_OBJECT(tag_label),
-        app->quarks.data
-      );
-
-      if (tag_message == msg)
-        removable = GTK_WIDGET(child);
-
-      g_list_free(items);
-    }
-
-    list = list->next;
-
-    if (removable)
-      break;
-  }
-
-  if (children)
-    g_list_free(children);
+  GtkWidget *removable = g_hash_table_lookup(handle->tags, tag_message);
 
   if (!removable)
     return;
 
+  g_hash_table_remove(handle->tags, tag_message);
   _remove_tag_from_message(handle, app, removable);
 }
 
@@ -935,6 +902,15 @@ ui_message_delete(UI_MESSAGE_Handle *handle,
 {
   g_assert((handle) && (app));
 
+  struct GNUNET_CHAT_File *file = g_object_get_qdata(
+    G_OBJECT(handle->message_box),
+    app->quarks.data
+  );
+
+  // The file keeps updating its messages until they get removed
+  if (file)
+    file_remove_ui_message_from_info(file, handle);
+
   _update_message_with_file(handle, app, NULL);
   ui_message_set_contact(handle, NULL);
 
@@ -954,8 +930,8 @@ ui_message_delete(UI_MESSAGE_Handle *handle,
   if (children)
     g_list_free(children);
 
-  g_object_unref(handle->builder[1]);
-  g_object_unref(handle->builder[0]);
+  g_hash_table_destroy(handle->tags);
+  g_object_unref(handle->message_box);
 
   g_free(handle);
 }
@@ -57,9 +57,9 @@ typedef struct UI_MESSAGE_Handle
   UI_MESSAGE_StatusCallback status_cb;
   gpointer status_cls;
 
-  GtkBuilder *builder [2];
   GtkWidget *message_box;
   GtkFlowBox *tag_flow_box;
+  GHashTable *tags;
 
   HdyAvatar *sender_avatar;
   GtkLabel *sender_label;
@@ -35,6 +35,7 @@
 #include "new_group.h"
 #include "new_lobby.h"
 #include "new_platform.h"
+#include "picker.h"
 #include "settings.h"
 
 #include "../account.h"
@@ -325,7 +326,15 @@ handle_chats_listbox_row_activated(UNUSED GtkListBox* listbox,
     g_object_get_qdata(G_OBJECT(row), app->quarks.ui)
   );
 
-  if ((!entry) || (!(entry->chat)) || (!(entry->chat->chat_box)))
+  if (!entry)
+    return;
+
+  // Deferred messages get rendered via the chat library
+  application_chat_lock(app);
+  UI_CHAT_Handle *chat = ui_chat_entry_materialize(entry, app);
+  application_chat_unlock(app);
+
+  if ((!chat) || (!(chat->chat_box)))
     return;
 
   UI_MESSENGER_Handle *ui = &(app->ui.messenger);
@@ -337,8 +346,8 @@ handle_chats_listbox_row_activated(UNUSED GtkListBox* listbox,
   if (children)
     g_list_free(children);
 
-  gtk_stack_set_visible_child(ui->chats_stack, entry->chat->chat_box);
-  gtk_stack_set_visible_child(ui->chat_title_stack, entry->chat->title->chat_title_box);
+  gtk_stack_set_visible_child(ui->chats_stack, chat->chat_box);
+  gtk_stack_set_visible_child(ui->chat_title_stack, chat->title->chat_title_box);
 }
 
 static gint
@@ -390,26 +399,16 @@ handle_chats_listbox_filter_func(GtkListBoxRow *row,
       (gtk_list_box_row_is_selected(row)))
     return TRUE;
 
-  const gchar *filter = gtk_entry_get_text(
-    GTK_ENTRY(app->ui.messenger.chats_search_entry)
-  );
+  GHashTable *results = app->ui.messenger.search_results;
 
-  if (!filter)
+  if (!results)
     return TRUE;
 
   UI_CHAT_ENTRY_Handle *entry = (UI_CHAT_ENTRY_Handle*) (
     g_object_get_qdata(G_OBJECT(row), app->quarks.ui)
   );
 
-  if ((!entry) || (!(entry->title_label)))
-    return FALSE;
-
-  const gchar *title = gtk_label_get_text(entry->title_label);
-
-  if (!title)
-    return FALSE;
-
-  return g_str_match_string(filter, title, TRUE);
+  return ((entry) && (g_hash_table_contains(results, entry)));
 }
 
 static void
@@ -429,15 +428,143 @@ handle_search_button_click(UNUSED GtkButton *button,
     gtk_stack_set_visible_child(handle->chats_title_stack, handle->search_box);
 }
 
+static gboolean
+_messenger_search_chats(gpointer user_data)
+{
+  g_assert(user_data);
+
+  UI_MESSENGER_Handle *handle = (UI_MESSENGER_Handle*) user_data;
+
+  handle->search_update = 0;
+
+  if (handle->search_results)
+    g_hash_table_destroy(handle->search_results);
+
+  const gchar *filter = gtk_entry_get_text(
+    GTK_ENTRY(handle->chats_search_entry)
+  );
+
+  handle->search_results = search_query(&(handle->titles), filter);
+
+  if (!(handle->search_results))
+    goto update_filter;
+
+  GHashTable *contexts = index_query(&(handle->app->ui.index), filter);
+
+  if (!contexts)
+    goto update_filter;
+
+  GHashTableIter iter;
+  gpointer id;
+
+  // Chats also match by their messages from the stored search index
+  g_hash_table_iter_init(&iter, contexts);
+  while (g_hash_table_iter_next(&iter, &id, NULL))
+  {
+    UI_CHAT_ENTRY_Handle *entry = g_hash_table_lookup(
+      handle->chat_contexts, id
+    );
+
+    if (entry)
+      g_hash_table_add(handle->search_results, entry);
+  }
+
+  g_hash_table_destroy(contexts);
+
+update_filter:
+  gtk_list_box_invalidate_filter(handle->chats_listbox);
+  return FALSE;
+}
+
+static void
+_messenger_enqueue_search(UI_MESSENGER_Handle *handle)
+{
+  g_assert(handle);
+
+  // The search only needs to be updated once per frame
+  if (handle->search_update)
+    return;
+
+  handle->search_update = util_frame_add(_messenger_search_chats, handle);
+}
+
 static void
 handle_chats_search_changed(UNUSED GtkSearchEntry *search,
                             gpointer user_data)
 {
   g_assert(user_data);
 
-  GtkListBox *listbox = GTK_LIST_BOX(user_data);
+  UI_MESSENGER_Handle *handle = (UI_MESSENGER_Handle*) user_data;
+
+  _messenger_enqueue_search(handle);
+}
+
+static void
+handle_main_window_frame_update(GdkFrameClock *clock,
+                                UNUSED gpointer user_data)
+{
+  g_assert(clock);
+
+  // Pending updates get flushed once per frame within a budget
+  if (util_frame_flush(UTIL_FRAME_BUDGET))
+    gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+}
+
+static void
+handle_main_window_realize(GtkWidget *window,
+                           gpointer user_data)
+{
+  g_assert((window) && (user_data));
 
-  gtk_list_box_invalidate_filter(listbox);
+  GdkFrameClock *clock = gtk_widget_get_frame_clock(window);
+
+  if (!clock)
+    return;
+
+  g_signal_connect(
+    clock,
+    "update",
+    G_CALLBACK(handle_main_window_frame_update),
+    user_data
+  );
+}
+
+static void
+handle_main_window_unrealize(GtkWidget *window,
+                             gpointer user_data)
+{
+  g_assert((window) && (user_data));
+
+  GdkFrameClock *clock = gtk_widget_get_frame_clock(window);
+
+  if (!clock)
+    return;
+
+  g_signal_handlers_disconnect_by_func(
+    clock,
+    handle_main_window_frame_update,
+    user_data
+  );
+}
+
+static gboolean
+_messenger_request_frame(gpointer cls)
+{
+  g_assert(cls);
+
+  UI_MESSENGER_Handle *handle = (UI_MESSENGER_Handle*) cls;
+  GtkWidget *window = GTK_WIDGET(handle->main_window);
+
+  if (!gtk_widget_get_mapped(window))
+    return FALSE;
+
+  GdkFrameClock *clock = gtk_widget_get_frame_clock(window);
+
+  if (!clock)
+    return FALSE;
+
+  gdk_frame_clock_request_phase(clock, GDK_FRAME_CLOCK_PHASE_UPDATE);
+  return TRUE;
 }
 
 static void
@@ -448,6 +575,8 @@ handle_main_window_destroy(UNUSED GtkWidget *window,
 
   MESSENGER_Application *app = (MESSENGER_Application*) user_data;
 
+  util_frame_set_driver(NULL, NULL);
+
 #ifndef MESSENGER_APPLICATION_NO_PORTAL
   if (app->parent)
     xdp_parent_free(app->parent);
@@ -471,6 +600,10 @@ ui_messenger_init(MESSENGER_Application *app,
   memset(handle, 0, sizeof(*handle));
   handle->app = app;
 
+  search_init(&(handle->titles));
+
+  handle->chat_contexts = g_hash_table_new(g_direct_hash, g_direct_equal);
+
   handle->builder = ui_builder_from_resource(
     application_get_resource_path(app, "ui/messenger.ui")
   );
@@ -793,7 +926,7 @@ ui_messenger_init(MESSENGER_Application *app,
     handle->chats_search_entry,
     "search-changed",
     G_CALLBACK(handle_chats_search_changed),
-    handle->chats_listbox
+    handle
   );
 
   g_signal_connect(
@@ -815,12 +948,28 @@ ui_messenger_init(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "chat_title_stack")
   );
 
+  g_signal_connect(
+    handle->main_window,
+    "realize",
+    G_CALLBACK(handle_main_window_realize),
+    handle
+  );
+
+  g_signal_connect(
+    handle->main_window,
+    "unrealize",
+    G_CALLBACK(handle_main_window_unrealize),
+    handle
+  );
+
   g_signal_connect(
     handle->main_window,
     "destroy",
     G_CALLBACK(handle_main_window_destroy),
     app
   );
+
+  util_frame_set_driver(_messenger_request_frame, handle);
 }
 
 static int
@@ -939,6 +1088,64 @@ ui_messenger_is_context_active(UI_MESSENGER_Handle *handle,
   return gtk_list_box_row_is_selected(row);
 }
 
+void
+ui_messenger_add_chat_entry(UI_MESSENGER_Handle *handle,
+                            UI_CHAT_ENTRY_Handle *entry)
+{
+  g_assert((handle) && (entry) && (entry->context));
+
+  handle->chat_entries = g_list_append(handle->chat_entries, entry);
+
+  const gchar *id = index_add_context(
+    &(handle->app->ui.index),
+    entry->context
+  );
+
+  if (id)
+    g_hash_table_insert(handle->chat_contexts, (gpointer) id, entry);
+}
+
+void
+ui_messenger_index_chat_entry(UI_MESSENGER_Handle *handle,
+                              UI_CHAT_ENTRY_Handle *entry)
+{
+  g_assert((handle) && (entry));
+
+  search_remove_item(&(handle->titles), entry);
+  search_add_text(
+    &(handle->titles),
+    entry,
+    gtk_label_get_text(entry->title_label)
+  );
+
+  // Renamed chats need to be filtered again while searching
+  if (handle->search_results)
+    _messenger_enqueue_search(handle);
+}
+
+void
+ui_messenger_drop_chat_entry(UI_MESSENGER_Handle *handle,
+                             UI_CHAT_ENTRY_Handle *entry)
+{
+  g_assert((handle) && (entry));
+
+  search_remove_item(&(handle->titles), entry);
+
+  if (handle->search_results)
+    g_hash_table_remove(handle->search_results, entry);
+
+  const gchar *id = entry->context? index_get_context_id(
+    &(handle->app->ui.index),
+    entry->context
+  ) : NULL;
+
+  if ((id) && (entry == g_hash_table_lookup(handle->chat_contexts, id)))
+    g_hash_table_remove(handle->chat_contexts, id);
+
+  if (entry->context)
+    index_drop_context(&(handle->app->ui.index), entry->context);
+}
+
 void
 ui_messenger_cleanup(UI_MESSENGER_Handle *handle)
 {
@@ -949,11 +1156,27 @@ ui_messenger_cleanup(UI_MESSENGER_Handle *handle)
   if (handle->chat_entries)
     g_list_free_full(handle->chat_entries, (GDestroyNotify) ui_chat_entry_delete);
 
+  if (handle->pipelines)
+    ui_chat_pipelines_delete(handle->pipelines);
+
+  if (handle->picker)
+    ui_picker_delete(handle->picker);
+
   if (handle->chat_selection)
     util_source_remove(handle->chat_selection);
 
   if (handle->account_refresh)
     util_source_remove(handle->account_refresh);
 
+  if (handle->search_update)
+    util_source_remove(handle->search_update);
+
+  if (handle->search_results)
+    g_hash_table_destroy(handle->search_results);
+
+  search_cleanup(&(handle->titles));
+
+  g_hash_table_destroy(handle->chat_contexts);
+
   memset(handle, 0, sizeof(*handle));
 }
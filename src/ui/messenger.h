@@ -31,16 +31,29 @@
 
 #include <gnunet/gnunet_chat_lib.h>
 
+#include "../search.h"
+
 typedef struct MESSENGER_Application MESSENGER_Application;
+typedef struct UI_CHAT_Pipelines UI_CHAT_Pipelines;
+typedef struct UI_PICKER_Handle UI_PICKER_Handle;
+typedef struct UI_CHAT_ENTRY_Handle UI_CHAT_ENTRY_Handle;
 
 typedef struct UI_MESSENGER_Handle
 {
   MESSENGER_Application *app;
 
   GList *chat_entries;
+  GHashTable *chat_contexts;
   guint chat_selection;
   guint account_refresh;
 
+  MESSENGER_Search titles;
+  GHashTable *search_results;
+  guint search_update;
+
+  UI_CHAT_Pipelines *pipelines;
+  UI_PICKER_Handle *picker;
+
   GtkBuilder *builder;
   GtkApplicationWindow *main_window;
 
@@ -128,6 +141,41 @@ gboolean
 ui_messenger_is_context_active(UI_MESSENGER_Handle *handle,
                                struct GNUNET_CHAT_Context *context);
 
+/**
+ * Adds a chat entry to a given messenger window
+ * handle, so its chat can be found by the messages
+ * from the search index. This needs to be called
+ * while the chat handle can be accessed.
+ *
+ * @param handle Messenger window handle
+ * @param entry Chat entry handle
+ */
+void
+ui_messenger_add_chat_entry(UI_MESSENGER_Handle *handle,
+                            UI_CHAT_ENTRY_Handle *entry);
+
+/**
+ * Updates the title of a chat entry in the search
+ * index of a given messenger window handle.
+ *
+ * @param handle Messenger window handle
+ * @param entry Chat entry handle
+ */
+void
+ui_messenger_index_chat_entry(UI_MESSENGER_Handle *handle,
+                              UI_CHAT_ENTRY_Handle *entry);
+
+/**
+ * Removes a chat entry from the search index of
+ * a given messenger window handle.
+ *
+ * @param handle Messenger window handle
+ * @param entry Chat entry handle
+ */
+void
+ui_messenger_drop_chat_entry(UI_MESSENGER_Handle *handle,
+                             UI_CHAT_ENTRY_Handle *entry);
+
 /**
  * Cleans up the allocated resources and resets the
  * state of a given messenger window handle.
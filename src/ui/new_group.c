@@ -24,7 +24,6 @@
 
 #include "new_platform.h"
 
-#include "contact_entry.h"
 #include "../application.h"
 #include "../ui.h"
 
@@ -179,45 +178,12 @@ handle_dialog_destroy(UNUSED GtkWidget *window,
   ui_new_group_dialog_cleanup((UI_NEW_GROUP_Handle*) user_data);
 }
 
-static int
-_iterate_contacts(void *cls,
-                  UNUSED struct GNUNET_CHAT_Handle *handle,
-                  struct GNUNET_CHAT_Contact *contact)
-{
-  g_assert((cls) && (contact));
-
-  if (GNUNET_YES == GNUNET_CHAT_contact_is_owned(contact))
-    return GNUNET_YES;
-
-  MESSENGER_Application *app = (MESSENGER_Application*) cls;
-
-  UI_CONTACT_ENTRY_Handle *entry = ui_contact_entry_new(app);
-  ui_contact_entry_set_contact(entry, contact);
-
-  gtk_list_box_prepend(
-    app->ui.new_group.contacts_listbox,
-    entry->entry_box
-  );
-
-  GtkWidget *row = gtk_widget_get_parent(entry->entry_box);
-  g_object_set_qdata(G_OBJECT(row), app->quarks.data, contact);
-
-  app->ui.new_group.contact_entries = g_list_append(
-    app->ui.new_group.contact_entries,
-    entry
-  );
-
-  return GNUNET_YES;
-}
-
 void
 ui_new_group_dialog_init(MESSENGER_Application *app,
                          UI_NEW_GROUP_Handle *handle)
 {
   g_assert((app) && (handle));
 
-  handle->contact_entries = NULL;
-
   handle->builder = ui_builder_from_resource(
     application_get_resource_path(app, "ui/new_group.ui")
   );
@@ -328,10 +294,11 @@ ui_new_group_dialog_init(MESSENGER_Application *app,
     handle
   );
 
-  GNUNET_CHAT_iterate_contacts(
-    app->chat.messenger.handle,
-    _iterate_contacts,
-    app
+  ui_contact_list_init(
+    app,
+    &(handle->contact_list),
+    handle->contacts_listbox,
+    GTK_ENTRY(handle->contact_search_entry)
   );
 }
 
@@ -340,13 +307,9 @@ ui_new_group_dialog_cleanup(UI_NEW_GROUP_Handle *handle)
 {
   g_assert(handle);
 
-  g_object_unref(handle->builder);
-
-  for (GList *list = handle->contact_entries; list; list = list->next)
-    ui_contact_entry_delete((UI_CONTACT_ENTRY_Handle*) list->data);
+  ui_contact_list_cleanup(&(handle->contact_list));
 
-  if (handle->contact_entries)
-    g_list_free(handle->contact_entries);
+  g_object_unref(handle->builder);
 
   memset(handle, 0, sizeof(*handle));
 }
@@ -26,11 +26,10 @@
 #define UI_NEW_GROUP_H_
 
 #include "messenger.h"
+#include "contact_list.h"
 
 typedef struct UI_NEW_GROUP_Handle
 {
-  GList *contact_entries;
-
   GtkBuilder *builder;
   GtkDialog *dialog;
 
@@ -46,6 +45,7 @@ typedef struct UI_NEW_GROUP_Handle
   GtkSearchEntry *contact_search_entry;
 
   GtkListBox *contacts_listbox;
+  UI_CONTACT_LIST_Handle contact_list;
 
   GtkButton *cancel_button;
   GtkButton *previous_button;
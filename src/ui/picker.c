@@ -31,128 +31,408 @@
 #include <glib-2.0/glib.h>
 #include <uniname.h>
 
+static gint
+_picker_grid_get_index(const UI_PICKER_Grid *grid,
+                       gdouble x,
+                       gdouble y)
+{
+  g_assert(grid);
+
+  if ((x < 0) || (y < 0) || (!(grid->columns)))
+    return -1;
+
+  const guint column = (guint) x / UI_PICKER_EMOJI_CELL_SIZE;
+  const guint row = (guint) y / UI_PICKER_EMOJI_CELL_SIZE;
+
+  if (column >= grid->columns)
+    return -1;
+
+  const guint index = row * grid->columns + column;
+
+  if (index >= grid->visible->len)
+    return -1;
+
+  return (gint) index;
+}
+
+static void
+_picker_grid_update_size(UI_PICKER_Grid *grid)
+{
+  g_assert(grid);
+
+  if (!(grid->columns))
+    return;
+
+  const guint rows = (
+    (grid->visible->len + grid->columns - 1) / grid->columns
+  );
+
+  gtk_widget_set_size_request(
+    GTK_WIDGET(grid->drawing_area),
+    -1,
+    rows * UI_PICKER_EMOJI_CELL_SIZE
+  );
+
+  gtk_widget_queue_draw(GTK_WIDGET(grid->drawing_area));
+}
+
+static gboolean
+handle_emoji_grid_draw(GtkWidget *widget,
+                       cairo_t *cairo,
+                       gpointer user_data)
+{
+  g_assert((widget) && (cairo) && (user_data));
+
+  UI_PICKER_Grid *grid = (UI_PICKER_Grid*) user_data;
+
+  if ((!(grid->columns)) || (!(grid->visible->len)))
+    return FALSE;
+
+  GtkStyleContext *context = gtk_widget_get_style_context(widget);
+
+  GdkRGBA color;
+  gtk_style_context_get_color(
+    context,
+    gtk_style_context_get_state(context),
+    &color
+  );
+
+  // Only the rows intersecting the clip area get drawn
+  gdouble x1, y1, x2, y2;
+  cairo_clip_extents(cairo, &x1, &y1, &x2, &y2);
+
+  const guint first = (guint) MAX(y1, 0) / UI_PICKER_EMOJI_CELL_SIZE;
+  const guint last = (guint) MAX(y2, 0) / UI_PICKER_EMOJI_CELL_SIZE;
+
+  PangoLayout *layout = gtk_widget_create_pango_layout(widget, NULL);
+
+  for (guint row = first; row <= last; row++)
+    for (guint column = 0; column < grid->columns; column++)
+    {
+      const guint index = row * grid->columns + column;
+
+      if (index >= grid->visible->len)
+        goto draw_done;
+
+      const gdouble x = column * UI_PICKER_EMOJI_CELL_SIZE;
+      const gdouble y = row * UI_PICKER_EMOJI_CELL_SIZE;
+
+      if (grid->hovered == (gint) index)
+      {
+        cairo_set_source_rgba(cairo, color.red, color.green, color.blue, 0.1);
+        cairo_rectangle(
+          cairo, x, y, UI_PICKER_EMOJI_CELL_SIZE, UI_PICKER_EMOJI_CELL_SIZE
+        );
+        cairo_fill(cairo);
+      }
+
+      const guint emoji = g_array_index(grid->visible, guint, index);
+
+      pango_layout_set_text(layout, grid->emojis[emoji], -1);
+
+      int width, height;
+      pango_layout_get_pixel_size(layout, &width, &height);
+
+      gdk_cairo_set_source_rgba(cairo, &color);
+      cairo_move_to(
+        cairo,
+        x + (UI_PICKER_EMOJI_CELL_SIZE - width) / 2.0,
+        y + (UI_PICKER_EMOJI_CELL_SIZE - height) / 2.0
+      );
+
+      pango_cairo_show_layout(cairo, layout);
+    }
+
+draw_done:
+  g_object_unref(layout);
+  return FALSE;
+}
+
 static void
-handle_emoji_button_click(GtkButton *button,
-			                    gpointer user_data)
+handle_emoji_grid_size_allocate(UNUSED GtkWidget *widget,
+                                GdkRectangle *allocation,
+                                gpointer user_data)
+{
+  g_assert((allocation) && (user_data));
+
+  UI_PICKER_Grid *grid = (UI_PICKER_Grid*) user_data;
+
+  const guint columns = MAX(allocation->width / UI_PICKER_EMOJI_CELL_SIZE, 1);
+
+  if (columns == grid->columns)
+    return;
+
+  grid->columns = columns;
+  _picker_grid_update_size(grid);
+}
+
+static gboolean
+handle_emoji_grid_button_press(UNUSED GtkWidget *widget,
+                               GdkEventButton *event,
+                               gpointer user_data)
+{
+  g_assert((event) && (user_data));
+
+  UI_PICKER_Grid *grid = (UI_PICKER_Grid*) user_data;
+  UI_PICKER_Handle *handle = grid->picker;
+
+  if ((GDK_BUTTON_PRIMARY != event->button) || (!(handle->chat)))
+    return FALSE;
+
+  const gint index = _picker_grid_get_index(grid, event->x, event->y);
+
+  if (index < 0)
+    return FALSE;
+
+  const gchar *emoji = grid->emojis[
+    g_array_index(grid->visible, guint, index)
+  ];
+
+  GtkTextBuffer *text_buffer = gtk_text_view_get_buffer(
+    handle->chat->send_text_view
+  );
+
+  gtk_text_buffer_insert_at_cursor(text_buffer, emoji, strlen(emoji));
+  return TRUE;
+}
+
+static gboolean
+handle_emoji_grid_motion_notify(GtkWidget *widget,
+                                GdkEventMotion *event,
+                                gpointer user_data)
+{
+  g_assert((widget) && (event) && (user_data));
+
+  UI_PICKER_Grid *grid = (UI_PICKER_Grid*) user_data;
+
+  const gint index = _picker_grid_get_index(grid, event->x, event->y);
+
+  if (index == grid->hovered)
+    return FALSE;
+
+  grid->hovered = index;
+  gtk_widget_queue_draw(widget);
+  return FALSE;
+}
+
+static gboolean
+handle_emoji_grid_leave_notify(GtkWidget *widget,
+                               UNUSED GdkEventCrossing *event,
+                               gpointer user_data)
 {
-  g_assert((button) && (user_data));
+  g_assert((widget) && (user_data));
 
-  GtkTextView *text_view = GTK_TEXT_VIEW(user_data);
-  GtkTextBuffer *text_buffer = gtk_text_view_get_buffer(text_view);
+  UI_PICKER_Grid *grid = (UI_PICKER_Grid*) user_data;
 
-  const gchar *label = gtk_button_get_label(button);
+  if (grid->hovered < 0)
+    return FALSE;
 
-  if (label)
-    gtk_text_buffer_insert_at_cursor(text_buffer, label, strlen(label));
+  grid->hovered = -1;
+  gtk_widget_queue_draw(widget);
+  return FALSE;
 }
 
 static void
-_add_emoji_buttons(GtkFlowBox *flow_box,
-		               GtkTextView *text_view,
-		               size_t characters_count,
-		               const uint32_t *characters)
+_picker_grid_init(UI_PICKER_Grid *grid,
+                  UI_PICKER_Handle *handle,
+                  const gchar *name,
+                  size_t characters_count,
+                  const uint32_t *characters)
 {
-  g_assert((flow_box) && (text_view) && (characters));
+  g_assert((grid) && (handle) && (name));
+
+  grid->picker = handle;
+  grid->drawing_area = GTK_DRAWING_AREA(
+    gtk_builder_get_object(handle->builder, name)
+  );
+
+  grid->characters = characters;
+  grid->emojis = g_malloc(sizeof(gchar*) * (characters_count + 1));
+  grid->count = 0;
 
   glong items_written;
   GError *error;
   gchar *utf8;
-  
-  for (size_t i = 0; i < characters_count; i++) {
+
+  for (size_t i = 0; i < characters_count; i++)
+  {
+    error = NULL;
     utf8 = g_ucs4_to_utf8(characters + i, 1, NULL, &items_written, &error);
 
     if (!utf8)
     {
       fprintf(stderr, "ERROR: %s\n", error->message);
       g_error_free(error);
-      continue;
+      utf8 = g_strdup("");
     }
 
-    GtkButton *emoji_button = GTK_BUTTON(
-      gtk_button_new_with_label(utf8)
-    );
+    grid->emojis[grid->count++] = utf8;
+  }
 
-    g_free(utf8);
+  grid->emojis[grid->count] = NULL;
 
-    gtk_button_set_relief(emoji_button, GTK_RELIEF_NONE);
+  grid->matches = g_malloc0(sizeof(guint8) * (grid->count + 1));
+  grid->visible = g_array_sized_new(FALSE, FALSE, sizeof(guint), grid->count);
+  grid->columns = 0;
+  grid->hovered = -1;
 
-    g_signal_connect(
-      emoji_button,
-      "clicked",
-      G_CALLBACK(handle_emoji_button_click),
-      text_view
-    );
+  for (guint i = 0; i < grid->count; i++)
+    if (*(grid->emojis[i]))
+      g_array_append_val(grid->visible, i);
 
-    gtk_flow_box_insert(flow_box, GTK_WIDGET(emoji_button), -1);
-    gtk_widget_show(GTK_WIDGET(emoji_button));
-  }
+  gtk_widget_add_events(
+    GTK_WIDGET(grid->drawing_area),
+    GDK_BUTTON_PRESS_MASK |
+    GDK_POINTER_MOTION_MASK |
+    GDK_LEAVE_NOTIFY_MASK
+  );
+
+  g_signal_connect(
+    grid->drawing_area,
+    "draw",
+    G_CALLBACK(handle_emoji_grid_draw),
+    grid
+  );
+
+  g_signal_connect(
+    grid->drawing_area,
+    "size-allocate",
+    G_CALLBACK(handle_emoji_grid_size_allocate),
+    grid
+  );
+
+  g_signal_connect(
+    grid->drawing_area,
+    "button-press-event",
+    G_CALLBACK(handle_emoji_grid_button_press),
+    grid
+  );
+
+  g_signal_connect(
+    grid->drawing_area,
+    "motion-notify-event",
+    G_CALLBACK(handle_emoji_grid_motion_notify),
+    grid
+  );
+
+  g_signal_connect(
+    grid->drawing_area,
+    "leave-notify-event",
+    G_CALLBACK(handle_emoji_grid_leave_notify),
+    grid
+  );
 }
 
 static void
-_filter_emoji_buttons(GtkWidget* widget,
-                      gpointer user_data)
+_picker_grid_update_visible(UI_PICKER_Grid *grid,
+                            gboolean all)
 {
-  g_assert((widget) && (user_data));
+  g_assert(grid);
 
-  GtkSearchEntry *entry = GTK_SEARCH_ENTRY(user_data);
+  g_array_set_size(grid->visible, 0);
 
-  const gchar *filter = gtk_entry_get_text(GTK_ENTRY(entry));
+  for (guint i = 0; i < grid->count; i++)
+    if ((*(grid->emojis[i])) && ((all) || (grid->matches[i])))
+      g_array_append_val(grid->visible, i);
 
-  GList *list = gtk_container_get_children(GTK_CONTAINER(widget));
+  grid->hovered = -1;
+  _picker_grid_update_size(grid);
+}
 
-  if (!list)
-    return;
-  
-  GtkButton *emoji_button = GTK_BUTTON(list->data);
-  g_list_free(list);
+static void
+_picker_grid_cleanup(UI_PICKER_Grid *grid)
+{
+  g_assert(grid);
 
-  list = gtk_container_get_children(GTK_CONTAINER(emoji_button));
+  if (grid->emojis)
+    g_strfreev(grid->emojis);
 
-  if (!list)
-    return;
-  
-  GtkLabel *label = GTK_LABEL(list->data);
-  g_list_free(list);
+  if (grid->matches)
+    g_free(grid->matches);
 
-  const gchar *text = gtk_label_get_text(label);
+  if (grid->visible)
+    g_array_free(grid->visible, TRUE);
 
-  if (!text)
-    return;
+  memset(grid, 0, sizeof(*grid));
+}
 
-  gunichar *characters;
-  glong items_written;
-  GError *error;
+static void
+_picker_index_add_grid(UI_PICKER_Index *index,
+                       UI_PICKER_Grid *grid)
+{
+  g_assert((index) && (grid));
 
-  characters = g_utf8_to_ucs4 (
-    text,
-    strlen(text),
-    NULL,
-    &items_written,
-    &error
-  );
+  UI_PICKER_IndexEntry entry;
+  entry.grid = grid;
 
-  if (!characters)
+  gchar buffer [UNINAME_MAX];
+  for (guint i = 0; i < grid->count; i++)
   {
-    fprintf(stderr, "ERROR: %s\n", error->message);
-    g_error_free(error);
-    return;
+    if ((!*(grid->emojis[i])) ||
+        (!unicode_character_name(grid->characters[i], buffer)))
+      continue;
+
+    entry.offset = index->names->len;
+    entry.emoji = i;
+
+    g_array_append_val(index->entries, entry);
+
+    g_string_append(index->names, buffer);
+    g_string_append_c(index->names, '\n');
   }
+}
 
-  GString *search = g_string_new(filter);
-  g_string_ascii_up(search);
+static const UI_PICKER_IndexEntry*
+_picker_index_find_entry(const UI_PICKER_Index *index,
+                         guint offset)
+{
+  g_assert((index) && (index->entries->len > 0));
 
-  gchar buffer [UNINAME_MAX];
-  if (!unicode_character_name(*characters, buffer))
-    goto skip_emoji;
+  guint lower = 0;
+  guint upper = index->entries->len;
 
-  gtk_widget_set_visible(
-    widget, 
-    g_strrstr(buffer, search->str)? TRUE : FALSE
-  );
+  // Entries are sorted by offset, find the last one starting before
+  while (upper - lower > 1)
+  {
+    const guint middle = (lower + upper) / 2;
 
-skip_emoji:
-  g_string_free(search, TRUE);
-  g_free(characters);
+    if (g_array_index(index->entries, UI_PICKER_IndexEntry, middle).offset > offset)
+      upper = middle;
+    else
+      lower = middle;
+  }
+
+  return &g_array_index(index->entries, UI_PICKER_IndexEntry, lower);
+}
+
+static void
+_picker_index_query(const UI_PICKER_Index *index,
+                    const gchar *search)
+{
+  g_assert((index) && (search));
+
+  if (!(index->entries->len))
+    return;
+
+  const gchar *names = index->names->str;
+  const gchar *hit = names;
+
+  while ((hit = strstr(hit, search)))
+  {
+    const UI_PICKER_IndexEntry *entry = _picker_index_find_entry(
+      index, (guint) (hit - names)
+    );
+
+    entry->grid->matches[entry->emoji] = TRUE;
+
+    // Continue with the next name after a match
+    hit = strchr(hit, '\n');
+
+    if (!hit)
+      break;
+
+    hit++;
+  }
 }
 
 static void
@@ -163,59 +443,44 @@ handle_emoji_search_entry_search_changed(GtkSearchEntry *entry,
 
   UI_PICKER_Handle *handle = (UI_PICKER_Handle*) user_data;
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->recent_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
-
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->people_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
-
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->nature_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
-
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->food_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+  UI_PICKER_Grid *grids [] = {
+    &(handle->recent_grid),
+    &(handle->people_grid),
+    &(handle->nature_grid),
+    &(handle->food_grid),
+    &(handle->activities_grid),
+    &(handle->travel_grid),
+    &(handle->objects_grid),
+    &(handle->symbols_grid),
+    &(handle->flags_grid)
+  };
+
+  const gsize grids_count = sizeof(grids) / sizeof(*grids);
+  UI_PICKER_Index *index = &(handle->index);
+
+  gchar *search = g_ascii_strup(gtk_entry_get_text(GTK_ENTRY(entry)), -1);
+  const gboolean all = (!*search);
+
+  if ((!all) && (!(index->names)))
+  {
+    // The index gets built once on the first search
+    index->names = g_string_new(NULL);
+    index->entries = g_array_new(FALSE, FALSE, sizeof(UI_PICKER_IndexEntry));
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->activities_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+    for (gsize i = 0; i < grids_count; i++)
+      _picker_index_add_grid(index, grids[i]);
+  }
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->travel_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+  for (gsize i = 0; i < grids_count; i++)
+    memset(grids[i]->matches, 0, grids[i]->count);
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->objects_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+  if (!all)
+    _picker_index_query(index, search);
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->symbols_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+  for (gsize i = 0; i < grids_count; i++)
+    _picker_grid_update_visible(grids[i], all);
 
-  gtk_container_foreach(
-    GTK_CONTAINER(handle->flags_flow_box),
-    _filter_emoji_buttons,
-    entry
-  );
+  g_free(search);
 }
 
 static void
@@ -251,13 +516,14 @@ handle_settings_button_click(UNUSED GtkButton *button,
 }
 
 UI_PICKER_Handle*
-ui_picker_new(MESSENGER_Application *app,
-              UI_CHAT_Handle *chat)
+ui_picker_new(MESSENGER_Application *app)
 {
-  g_assert((app) && (chat));
+  g_assert(app);
 
   UI_PICKER_Handle *handle = g_malloc(sizeof(UI_PICKER_Handle));
 
+  memset(handle, 0, sizeof(*handle));
+
   handle->builder = ui_builder_from_resource(
     application_get_resource_path(app, "ui/picker.ui")
   );
@@ -286,94 +552,74 @@ ui_picker_new(MESSENGER_Application *app,
     gtk_builder_get_object(handle->builder, "emoji_switcher_bar")
   );
 
-  handle->recent_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "recent_flow_box")
-  );
-
-  handle->people_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "people_flow_box")
+  _picker_grid_init(
+    &(handle->recent_grid),
+    handle,
+    "recent_drawing_area",
+    0,
+    NULL
   );
 
-  _add_emoji_buttons(
-    handle->people_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->people_grid),
+    handle,
+    "people_drawing_area",
     EMOJI_SMILEYS_CHARACTER_COUNT,
     emoji_smileys_characters
   );
 
-  handle->nature_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "nature_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->nature_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->nature_grid),
+    handle,
+    "nature_drawing_area",
     EMOJI_ANIMALS_CHARACTER_COUNT,
     emoji_animals_characters
   );
 
-  handle->food_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "food_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->food_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->food_grid),
+    handle,
+    "food_drawing_area",
     EMOJI_FOOD_CHARACTER_COUNT,
     emoji_food_characters
   );
 
-  handle->activities_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "activities_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->activities_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->activities_grid),
+    handle,
+    "activities_drawing_area",
     EMOJI_ACTIVITIES_CHARACTER_COUNT,
     emoji_activities_characters
   );
 
-  handle->travel_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "travel_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->travel_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->travel_grid),
+    handle,
+    "travel_drawing_area",
     EMOJI_TRAVEL_CHARACTER_COUNT,
     emoji_travel_characters
   );
 
-  handle->objects_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "objects_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->objects_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->objects_grid),
+    handle,
+    "objects_drawing_area",
     EMOJI_OBJECTS_CHARACTER_COUNT,
     emoji_objects_characters
   );
 
-  handle->symbols_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "symbols_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->symbols_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->symbols_grid),
+    handle,
+    "symbols_drawing_area",
     EMOJI_SYMBOLS_CHARACTER_COUNT,
     emoji_symbols_characters
   );
 
-  handle->flags_flow_box = GTK_FLOW_BOX(
-    gtk_builder_get_object(handle->builder, "flags_flow_box")
-  );
-
-  _add_emoji_buttons(
-    handle->flags_flow_box,
-    chat->send_text_view,
+  _picker_grid_init(
+    &(handle->flags_grid),
+    handle,
+    "flags_drawing_area",
     EMOJI_FLAGS_CHARACTER_COUNT,
     emoji_flags_characters
   );
@@ -418,14 +664,73 @@ ui_picker_new(MESSENGER_Application *app,
   return handle;
 }
 
+void
+ui_picker_attach(UI_PICKER_Handle *handle,
+                 UI_CHAT_Handle *chat)
+{
+  g_assert((handle) && (chat));
+
+  if (handle->chat == chat)
+    return;
+
+  if (handle->chat)
+  {
+    gtk_revealer_set_reveal_child(handle->chat->picker_revealer, FALSE);
+    ui_picker_detach(handle, handle->chat);
+  }
+
+  gtk_container_add(
+    GTK_CONTAINER(chat->picker_revealer),
+    handle->picker_box
+  );
+
+  handle->chat = chat;
+}
+
+void
+ui_picker_detach(UI_PICKER_Handle *handle,
+                 UI_CHAT_Handle *chat)
+{
+  g_assert((handle) && (chat));
+
+  if (handle->chat != chat)
+    return;
+
+  GtkWidget *parent = gtk_widget_get_parent(handle->picker_box);
+
+  if (parent == GTK_WIDGET(chat->picker_revealer))
+    gtk_container_remove(GTK_CONTAINER(parent), handle->picker_box);
+
+  handle->chat = NULL;
+}
+
 void
 ui_picker_delete(UI_PICKER_Handle *handle)
 {
   g_assert(handle);
 
+  if (handle->chat)
+    ui_picker_detach(handle, handle->chat);
+
   hdy_view_switcher_bar_set_stack(handle->picker_switcher_bar, NULL);
   hdy_view_switcher_bar_set_stack(handle->emoji_switcher_bar, NULL);
 
+  _picker_grid_cleanup(&(handle->recent_grid));
+  _picker_grid_cleanup(&(handle->people_grid));
+  _picker_grid_cleanup(&(handle->nature_grid));
+  _picker_grid_cleanup(&(handle->food_grid));
+  _picker_grid_cleanup(&(handle->activities_grid));
+  _picker_grid_cleanup(&(handle->travel_grid));
+  _picker_grid_cleanup(&(handle->objects_grid));
+  _picker_grid_cleanup(&(handle->symbols_grid));
+  _picker_grid_cleanup(&(handle->flags_grid));
+
+  if (handle->index.names)
+    g_string_free(handle->index.names, TRUE);
+
+  if (handle->index.entries)
+    g_array_free(handle->index.entries, TRUE);
+
   g_object_unref(handle->builder);
 
   g_free(handle);
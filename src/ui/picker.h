@@ -27,8 +27,40 @@
 
 #include "chat.h"
 
+#define UI_PICKER_EMOJI_CELL_SIZE 40
+
+typedef struct UI_PICKER_Grid
+{
+  struct UI_PICKER_Handle *picker;
+  GtkDrawingArea *drawing_area;
+
+  const uint32_t *characters;
+  gchar **emojis;
+  guint count;
+
+  guint8 *matches;
+  GArray *visible;
+  guint columns;
+  gint hovered;
+} UI_PICKER_Grid;
+
+typedef struct UI_PICKER_IndexEntry
+{
+  guint offset;
+  UI_PICKER_Grid *grid;
+  guint emoji;
+} UI_PICKER_IndexEntry;
+
+typedef struct UI_PICKER_Index
+{
+  GString *names;
+  GArray *entries;
+} UI_PICKER_Index;
+
 typedef struct UI_PICKER_Handle
 {
+  UI_CHAT_Handle *chat;
+
   GtkBuilder *builder;
   GtkWidget *picker_box;
 
@@ -40,15 +72,17 @@ typedef struct UI_PICKER_Handle
   HdyViewSwitcherBar *picker_switcher_bar;
   HdyViewSwitcherBar *emoji_switcher_bar;
 
-  GtkFlowBox *recent_flow_box;
-  GtkFlowBox *people_flow_box;
-  GtkFlowBox *nature_flow_box;
-  GtkFlowBox *food_flow_box;
-  GtkFlowBox *activities_flow_box;
-  GtkFlowBox *travel_flow_box;
-  GtkFlowBox *objects_flow_box;
-  GtkFlowBox *symbols_flow_box;
-  GtkFlowBox *flags_flow_box;
+  UI_PICKER_Grid recent_grid;
+  UI_PICKER_Grid people_grid;
+  UI_PICKER_Grid nature_grid;
+  UI_PICKER_Grid food_grid;
+  UI_PICKER_Grid activities_grid;
+  UI_PICKER_Grid travel_grid;
+  UI_PICKER_Grid objects_grid;
+  UI_PICKER_Grid symbols_grid;
+  UI_PICKER_Grid flags_grid;
+
+  UI_PICKER_Index index;
 
   HdySearchBar *emoji_search_bar;
   GtkSearchEntry *emoji_search_entry;
@@ -59,16 +93,39 @@ typedef struct UI_PICKER_Handle
 
 /**
  * Allocates and creates a new picker handle to
- * manage emoji selection in a chat for a given
- * messenger application.
+ * manage emoji selection for a given messenger
+ * application. The picker is shared between all
+ * chats and gets attached to one at a time.
  *
  * @param app Messenger application
- * @param chat Chat handle
  * @return New picker handle
  */
 UI_PICKER_Handle*
-ui_picker_new(MESSENGER_Application *app,
-              UI_CHAT_Handle *chat);
+ui_picker_new(MESSENGER_Application *app);
+
+/**
+ * Attaches a given picker handle to a chat
+ * handle, moving its widgets into the picker
+ * revealer of the chat. Picked emoji will be
+ * inserted into the text view of that chat.
+ *
+ * @param handle Picker handle
+ * @param chat Chat handle
+ */
+void
+ui_picker_attach(UI_PICKER_Handle *handle,
+                 UI_CHAT_Handle *chat);
+
+/**
+ * Detaches a given picker handle from a chat
+ * handle if it is currently attached to it.
+ *
+ * @param handle Picker handle
+ * @param chat Chat handle
+ */
+void
+ui_picker_detach(UI_PICKER_Handle *handle,
+                 UI_CHAT_Handle *chat);
 
 /**
  * Frees its resources and destroys a given picker
@@ -143,12 +143,15 @@ _leave_group_iteration(UNUSED void *cls,
 }
 
 int
-_delete_contact_iteration(UNUSED void *cls,
+_delete_contact_iteration(void *cls,
                           UNUSED struct GNUNET_CHAT_Handle *handle,
                           struct GNUNET_CHAT_Contact *contact)
 {
-  g_assert(contact);
+  g_assert((cls) && (contact));
+
+  MESSENGER_Roster *roster = (MESSENGER_Roster*) cls;
 
+  roster_remove_contact(roster, contact);
   GNUNET_CHAT_contact_delete(contact);
   return GNUNET_YES;
 }
@@ -172,7 +175,7 @@ handle_leave_chats_button_click(UNUSED GtkButton* button,
   GNUNET_CHAT_iterate_contacts(
     app->chat.messenger.handle,
     _delete_contact_iteration,
-    NULL
+    &(app->ui.roster)
   );
 
   application_chat_unlock(app);
@@ -22,41 +22,169 @@
  * @file util.c
  */
 
+
 #include "util.h"
 
 #include <pthread.h>
 #include <stdio.h>
 
-static GList *tasks = NULL;
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+#define UTIL_TIMER_WHEEL_SLOTS 64
+#define UTIL_TIMER_WHEEL_TAG 0x80000000u
+
+#define UTIL_FRAME_FALLBACK_INTERVAL 250 // in milliseconds
 
 struct UTIL_CompleteTask
 {
   GSourceFunc function;
   gpointer data;
   guint id;
+
+  guint source;
+  guint interval;
+  guint rounds;
+  guint slot;
+  GList *link;
+
+  gboolean frame;
+  guint round;
+
+  gboolean running;
+  gboolean cancelled;
 };
 
+static struct
+{
+  GHashTable *tasks;
+  GHashTable *owners;
+
+  GQueue slots [UTIL_TIMER_WHEEL_SLOTS];
+  guint cursor;
+  guint timers;
+  guint tick;
+  guint next_tag;
+
+  GQueue frames;
+  guint frame_round;
+  guint frame_request;
+  guint frame_fallback;
+
+  UTIL_FrameRequest frame_driver;
+  gpointer frame_cls;
+} registry;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void
-util_kill_task(gpointer task_data)
+util_registry_init(void)
 {
-  g_assert(task_data);
+  if (registry.tasks)
+    return;
+
+  registry.tasks = g_hash_table_new(g_direct_hash, g_direct_equal);
+  registry.owners = g_hash_table_new_full(
+    g_direct_hash,
+    g_direct_equal,
+    NULL,
+    (GDestroyNotify) g_hash_table_destroy
+  );
+
+  for (guint i = 0; i < UTIL_TIMER_WHEEL_SLOTS; i++)
+    g_queue_init(&(registry.slots[i]));
+
+  g_queue_init(&(registry.frames));
+
+  registry.cursor = 0;
+  registry.timers = 0;
+  registry.tick = 0;
+  registry.next_tag = 0;
+}
 
-  struct UTIL_CompleteTask *task = (struct UTIL_CompleteTask*) task_data;
+static void
+util_register_task(struct UTIL_CompleteTask *task)
+{
+  g_assert((task) && (task->id));
+
+  util_registry_init();
+
+  g_hash_table_insert(registry.tasks, GUINT_TO_POINTER(task->id), task);
+
+  GHashTable *owned = g_hash_table_lookup(registry.owners, task->data);
+
+  if (!owned)
+  {
+    owned = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(registry.owners, task->data, owned);
+  }
+
+  g_hash_table_add(owned, task);
+}
+
+static void
+util_unregister_task(struct UTIL_CompleteTask *task)
+{
+  g_assert(task);
+
+  g_hash_table_remove(registry.tasks, GUINT_TO_POINTER(task->id));
+
+  GHashTable *owned = g_hash_table_lookup(registry.owners, task->data);
+
+  if ((owned) && (g_hash_table_remove(owned, task)) &&
+      (0 == g_hash_table_size(owned)))
+    g_hash_table_remove(registry.owners, task->data);
+
+  if ((task->link) && (task->frame))
+  {
+    g_queue_delete_link(&(registry.frames), task->link);
+    task->link = NULL;
+  }
+  else if (task->link)
+  {
+    g_queue_delete_link(&(registry.slots[task->slot]), task->link);
 
-  if (task->id)
-    g_source_remove(task->id);
+    task->link = NULL;
+    registry.timers--;
+  }
 
   g_free(task);
 }
 
-void
-util_scheduler_cleanup()
+static gboolean
+util_run_task(struct UTIL_CompleteTask *task)
 {
-  if (tasks)
-    g_list_free_full(tasks, (GDestroyNotify) util_kill_task);
+  g_assert(task);
+
+  const GSourceFunc function = task->function;
+  gpointer data = task->data;
+
+  pthread_mutex_lock(&mutex);
+
+  if (task->cancelled)
+  {
+    util_unregister_task(task);
+    pthread_mutex_unlock(&mutex);
+    return FALSE;
+  }
+
+  task->running = TRUE;
+  pthread_mutex_unlock(&mutex);
+
+  // The mutex must not be held while the callback runs
+  gboolean result = function(data);
+
+  pthread_mutex_lock(&mutex);
 
-  tasks = NULL;
+  if (task->cancelled)
+    result = FALSE;
+
+  // Repeated tasks without a source stay running until queued again
+  if ((!result) || (task->source))
+    task->running = FALSE;
+
+  if (!result)
+    util_unregister_task(task);
+
+  pthread_mutex_unlock(&mutex);
+  return result;
 }
 
 static gboolean
@@ -64,92 +192,254 @@ util_complete_task(gpointer task_data)
 {
   g_assert(task_data);
 
-  struct UTIL_CompleteTask *task = (struct UTIL_CompleteTask*) task_data;
-  gboolean result = FALSE;
+  return util_run_task((struct UTIL_CompleteTask*) task_data);
+}
+
+static gboolean
+util_cancel_task(struct UTIL_CompleteTask *task)
+{
+  g_assert(task);
+
+  gboolean result = TRUE;
+
+  if (task->cancelled)
+    return FALSE;
+
+  if (task->source)
+    result = g_source_remove(task->source);
+
+  // Running tasks get released once their callback returns
+  if (task->running)
+    task->cancelled = TRUE;
+  else
+    util_unregister_task(task);
+
+  return result;
+}
 
+void
+util_scheduler_cleanup()
+{
   pthread_mutex_lock(&mutex);
-  if (!tasks)
+
+  if (!registry.tasks)
     goto unlock_mutex;
 
-  const GSourceFunc function = task->function;
-  gpointer data = task->data;
+  GHashTableIter iter;
+  gpointer value;
 
-  if (tasks)
-    tasks = g_list_remove(tasks, task);
+  g_hash_table_iter_init(&iter, registry.tasks);
+  while (g_hash_table_iter_next(&iter, NULL, &value))
+  {
+    struct UTIL_CompleteTask *task = (struct UTIL_CompleteTask*) value;
 
-  g_free(task);
+    if (task->source)
+      g_source_remove(task->source);
 
-  result = function(data);
+    g_free(task);
+  }
+
+  for (guint i = 0; i < UTIL_TIMER_WHEEL_SLOTS; i++)
+    g_queue_clear(&(registry.slots[i]));
+
+  g_queue_clear(&(registry.frames));
+
+  if (registry.tick)
+    g_source_remove(registry.tick);
+
+  if (registry.frame_request)
+    g_source_remove(registry.frame_request);
+
+  if (registry.frame_fallback)
+    g_source_remove(registry.frame_fallback);
+
+  g_hash_table_destroy(registry.tasks);
+  g_hash_table_destroy(registry.owners);
+
+  registry.tasks = NULL;
+  registry.owners = NULL;
+  registry.tick = 0;
+  registry.frame_request = 0;
+  registry.frame_fallback = 0;
 
 unlock_mutex:
   pthread_mutex_unlock(&mutex);
-  return result;
 }
 
-guint
-util_idle_add(GSourceFunc function,
-              gpointer data)
+void
+util_scheduler_log_stats()
 {
-  struct UTIL_CompleteTask *task = g_malloc(sizeof(struct UTIL_CompleteTask));
+  pthread_mutex_lock(&mutex);
 
-  task->function = function;
-  task->data = data;
-  task->id = g_idle_add(
-    G_SOURCE_FUNC(util_complete_task),
-    task
-  );
+  if (!registry.tasks)
+    goto unlock_mutex;
 
-  tasks = g_list_append(
-    tasks,
-    task
+  g_debug(
+    "tasks: %u live (%u owners, %u timers, %u frame tasks)",
+    g_hash_table_size(registry.tasks),
+    g_hash_table_size(registry.owners),
+    registry.timers,
+    g_queue_get_length(&(registry.frames))
   );
 
-  return task->id;
+unlock_mutex:
+  pthread_mutex_unlock(&mutex);
 }
 
-guint
-util_immediate_add(GSourceFunc function,
-                   gpointer data)
+static guint
+util_add_source_task(guint interval,
+                     GSourceFunc function,
+                     gpointer data,
+                     guint (*add)(guint, GSourceFunc, gpointer))
 {
-  struct UTIL_CompleteTask *task = g_malloc(sizeof(struct UTIL_CompleteTask));
+  struct UTIL_CompleteTask *task = g_new0(struct UTIL_CompleteTask, 1);
 
   task->function = function;
   task->data = data;
-  task->id = g_timeout_add(
-    0,
+
+  pthread_mutex_lock(&mutex);
+
+  task->source = add(
+    interval,
     G_SOURCE_FUNC(util_complete_task),
     task
   );
 
-  tasks = g_list_append(
-    tasks,
-    task
-  );
+  task->id = task->source;
+  util_register_task(task);
 
+  pthread_mutex_unlock(&mutex);
   return task->id;
 }
 
+static guint
+util_add_idle(UNUSED guint interval,
+              GSourceFunc function,
+              gpointer data)
+{
+  return g_idle_add(function, data);
+}
+
+guint
+util_idle_add(GSourceFunc function,
+              gpointer data)
+{
+  return util_add_source_task(0, function, data, util_add_idle);
+}
+
+guint
+util_immediate_add(GSourceFunc function,
+                   gpointer data)
+{
+  return util_add_source_task(0, function, data, g_timeout_add);
+}
+
 guint
 util_timeout_add(guint interval,
                  GSourceFunc function,
                  gpointer data)
 {
-  struct UTIL_CompleteTask *task = g_malloc(sizeof(struct UTIL_CompleteTask));
+  return util_add_source_task(interval, function, data, g_timeout_add);
+}
 
-  task->function = function;
-  task->data = data;
-  task->id = g_timeout_add(
-    interval,
-    G_SOURCE_FUNC(util_complete_task),
-    task
-  );
+static guint
+util_next_tag(void)
+{
+  guint tag;
 
-  tasks = g_list_append(
-    tasks,
-    task
-  );
+  // Tasks without their own source get tags outside of the source range
+  do
+  {
+    registry.next_tag = (registry.next_tag + 1) & ~UTIL_TIMER_WHEEL_TAG;
+    tag = UTIL_TIMER_WHEEL_TAG | registry.next_tag;
+  }
+  while ((!(registry.next_tag)) ||
+         (g_hash_table_contains(registry.tasks, GUINT_TO_POINTER(tag))));
 
-  return task->id;
+  return tag;
+}
+
+static void
+util_wheel_insert(struct UTIL_CompleteTask *task)
+{
+  g_assert((task) && (task->interval > 0));
+
+  task->slot = (registry.cursor + task->interval) % UTIL_TIMER_WHEEL_SLOTS;
+  task->rounds = (task->interval - 1) / UTIL_TIMER_WHEEL_SLOTS;
+
+  g_queue_push_tail(&(registry.slots[task->slot]), task);
+  task->link = registry.slots[task->slot].tail;
+}
+
+static gboolean
+util_wheel_tick(UNUSED gpointer user_data)
+{
+  GList *expired = NULL;
+
+  pthread_mutex_lock(&mutex);
+
+  registry.cursor = (registry.cursor + 1) % UTIL_TIMER_WHEEL_SLOTS;
+
+  GQueue *slot = &(registry.slots[registry.cursor]);
+  GList *link = slot->head;
+
+  while (link)
+  {
+    struct UTIL_CompleteTask *task = (struct UTIL_CompleteTask*) link->data;
+    GList *next = link->next;
+
+    if (task->rounds > 0)
+      task->rounds--;
+    else
+    {
+      g_queue_delete_link(slot, link);
+      task->link = NULL;
+      task->running = TRUE;
+      registry.timers--;
+
+      // Expired timers may still get cancelled by earlier callbacks
+      expired = g_list_prepend(expired, task);
+    }
+
+    link = next;
+  }
+
+  pthread_mutex_unlock(&mutex);
+
+  // Run expired timers in order of their insertion
+  expired = g_list_reverse(expired);
+
+  for (link = expired; link; link = link->next)
+  {
+    struct UTIL_CompleteTask *task = (struct UTIL_CompleteTask*) link->data;
+
+    if (!util_run_task(task))
+      continue;
+
+    pthread_mutex_lock(&mutex);
+    task->running = FALSE;
+
+    if (task->cancelled)
+      util_unregister_task(task);
+    else
+    {
+      util_wheel_insert(task);
+      registry.timers++;
+    }
+
+    pthread_mutex_unlock(&mutex);
+  }
+
+  g_list_free(expired);
+
+  pthread_mutex_lock(&mutex);
+
+  const gboolean keep = (registry.timers > 0);
+  if (!keep)
+    registry.tick = 0;
+
+  pthread_mutex_unlock(&mutex);
+  return keep;
 }
 
 guint
@@ -157,87 +447,241 @@ util_timeout_add_seconds(guint interval,
                          GSourceFunc function,
                          gpointer data)
 {
-  struct UTIL_CompleteTask *task = g_malloc(sizeof(struct UTIL_CompleteTask));
+  struct UTIL_CompleteTask *task = g_new0(struct UTIL_CompleteTask, 1);
 
   task->function = function;
   task->data = data;
-  task->id = g_timeout_add_seconds(
-    interval,
-    G_SOURCE_FUNC(util_complete_task),
-    task
-  );
+  task->interval = interval > 0? interval : 1;
 
-  tasks = g_list_append(
-    tasks,
-    task
-  );
+  pthread_mutex_lock(&mutex);
+  util_registry_init();
+
+  // Timers in seconds share one wheel instead of separate sources
+  task->id = util_next_tag();
+
+  util_register_task(task);
+  util_wheel_insert(task);
+  registry.timers++;
+
+  if (!(registry.tick))
+    registry.tick = g_timeout_add_seconds(1, util_wheel_tick, NULL);
+
+  pthread_mutex_unlock(&mutex);
+  return task->id;
+}
+
+static gboolean
+util_frame_fallback(UNUSED gpointer user_data)
+{
+  // Frames may not get drawn at all while the window is hidden
+  if (util_frame_flush(UTIL_FRAME_BUDGET))
+    return TRUE;
+
+  pthread_mutex_lock(&mutex);
+  registry.frame_fallback = 0;
+  pthread_mutex_unlock(&mutex);
+  return FALSE;
+}
+
+static gboolean
+util_frame_request(UNUSED gpointer user_data)
+{
+  pthread_mutex_lock(&mutex);
+
+  const UTIL_FrameRequest driver = registry.frame_driver;
+  gpointer cls = registry.frame_cls;
+
+  registry.frame_request = 0;
+  pthread_mutex_unlock(&mutex);
+
+  if ((driver) && (driver(cls)))
+    goto arm_fallback;
+
+  if (!util_frame_flush(UTIL_FRAME_BUDGET))
+    return FALSE;
+
+arm_fallback:
+  pthread_mutex_lock(&mutex);
+
+  if (!(registry.frame_fallback))
+    registry.frame_fallback = g_timeout_add(
+      UTIL_FRAME_FALLBACK_INTERVAL,
+      util_frame_fallback,
+      NULL
+    );
+
+  pthread_mutex_unlock(&mutex);
+  return FALSE;
+}
+
+guint
+util_frame_add(GSourceFunc function,
+               gpointer data)
+{
+  struct UTIL_CompleteTask *task = g_new0(struct UTIL_CompleteTask, 1);
+
+  task->function = function;
+  task->data = data;
+  task->frame = TRUE;
+
+  pthread_mutex_lock(&mutex);
+  util_registry_init();
 
+  task->id = util_next_tag();
+  task->round = registry.frame_round;
+
+  util_register_task(task);
+
+  g_queue_push_tail(&(registry.frames), task);
+  task->link = registry.frames.tail;
+
+  // Requests get made from the main context, tasks may come from others
+  if (!(registry.frame_request))
+    registry.frame_request = g_idle_add_full(
+      G_PRIORITY_HIGH_IDLE,
+      util_frame_request,
+      NULL,
+      NULL
+    );
+
+  pthread_mutex_unlock(&mutex);
   return task->id;
 }
 
+void
+util_frame_set_driver(UTIL_FrameRequest request,
+                      gpointer cls)
+{
+  pthread_mutex_lock(&mutex);
+
+  registry.frame_driver = request;
+  registry.frame_cls = cls;
+
+  pthread_mutex_unlock(&mutex);
+}
+
 gboolean
-util_source_remove(guint tag)
+util_frame_flush(gint64 budget)
 {
-  struct UTIL_CompleteTask *task = NULL;
-  GList *current = tasks;
+  const gint64 deadline = g_get_monotonic_time() + budget;
+
+  pthread_mutex_lock(&mutex);
+
+  if (!registry.tasks)
+  {
+    pthread_mutex_unlock(&mutex);
+    return FALSE;
+  }
+
+  // Tasks queued during this flush belong to the next frame
+  const guint round = ++(registry.frame_round);
 
-  while (current)
+  while (!g_queue_is_empty(&(registry.frames)))
   {
-    task = (struct UTIL_CompleteTask*) current->data;
+    struct UTIL_CompleteTask *task = g_queue_peek_head(&(registry.frames));
 
-    if (task->id == tag)
+    if (round == task->round)
       break;
 
-    current = g_list_next(current);
-    task = NULL;
+    g_queue_pop_head(&(registry.frames));
+    task->link = NULL;
+
+    pthread_mutex_unlock(&mutex);
+
+    const gboolean keep = util_run_task(task);
+
+    pthread_mutex_lock(&mutex);
+
+    if (!keep)
+      goto check_deadline;
+
+    task->running = FALSE;
+
+    if (task->cancelled)
+    {
+      util_unregister_task(task);
+      goto check_deadline;
+    }
+
+    task->round = round;
+
+    g_queue_push_tail(&(registry.frames), task);
+    task->link = registry.frames.tail;
+
+check_deadline:
+    if (g_get_monotonic_time() >= deadline)
+      break;
   }
 
-  if (!task)
-    return FALSE;
+  const gboolean remaining = !g_queue_is_empty(&(registry.frames));
 
-  const gboolean result = g_source_remove(task->id);
+  if ((!remaining) && (registry.frame_fallback))
+  {
+    g_source_remove(registry.frame_fallback);
+    registry.frame_fallback = 0;
+  }
 
-  tasks = g_list_remove(tasks, task);
-  g_free(task);
+  pthread_mutex_unlock(&mutex);
+  return remaining;
+}
 
-  return result;
+gboolean
+util_frame_pending(void)
+{
+  pthread_mutex_lock(&mutex);
+
+  const gboolean pending = !g_queue_is_empty(&(registry.frames));
+
+  pthread_mutex_unlock(&mutex);
+  return pending;
 }
 
 gboolean
-util_source_remove_by_data(gpointer data)
+util_source_remove(guint tag)
 {
-  struct UTIL_CompleteTask *task = NULL;
-  GList *current = tasks;
-  GList *matches = NULL;
+  gboolean result = FALSE;
 
-  while (current)
-  {
-    task = (struct UTIL_CompleteTask*) current->data;
+  pthread_mutex_lock(&mutex);
 
-    if (task->data == data)
-      matches = g_list_append(matches, task);
+  if (!registry.tasks)
+    goto unlock_mutex;
 
-    current = g_list_next(current);
-    task = NULL;
-  }
+  struct UTIL_CompleteTask *task = g_hash_table_lookup(
+    registry.tasks, GUINT_TO_POINTER(tag)
+  );
 
-  if (!matches)
-    return FALSE;
+  if (task)
+    result = util_cancel_task(task);
 
-  gboolean result = TRUE;
+unlock_mutex:
+  pthread_mutex_unlock(&mutex);
+  return result;
+}
 
-  current = matches;
-  while (current)
-  {
-    task = (struct UTIL_CompleteTask*) current->data;
+gboolean
+util_source_remove_by_data(gpointer data)
+{
+  gboolean result = FALSE;
 
-    result &= g_source_remove(task->id);
-    tasks = g_list_remove(tasks, task);
-    g_free(task);
+  pthread_mutex_lock(&mutex);
 
-    current = g_list_next(current);
-  }
+  if (!registry.owners)
+    goto unlock_mutex;
+
+  GHashTable *owned = g_hash_table_lookup(registry.owners, data);
+
+  if (!owned)
+    goto unlock_mutex;
+
+  GList *matches = g_hash_table_get_keys(owned);
+  result = TRUE;
+
+  for (GList *current = matches; current; current = current->next)
+    result &= util_cancel_task((struct UTIL_CompleteTask*) current->data);
 
   g_list_free(matches);
+
+unlock_mutex:
+  pthread_mutex_unlock(&mutex);
   return result;
 }
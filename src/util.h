@@ -29,6 +29,8 @@
 
 #define UNUSED __attribute__((unused))
 
+#define UTIL_FRAME_BUDGET 8000 // in microseconds
+
 #define _(String) (               \
   (const gchar*) g_dgettext(      \
     MESSENGER_APPLICATION_DOMAIN, \
@@ -42,6 +44,14 @@
 void
 util_scheduler_cleanup();
 
+/**
+ * Prints the amount of live asynchronous tasks, owner
+ * groups, wheel timers and pending frame tasks for
+ * debugging.
+ */
+void
+util_scheduler_log_stats();
+
 /**
  * Abstraction of `g_idle_add()` task
  * to be cancelled externally.
@@ -65,13 +75,66 @@ util_timeout_add(guint interval,
 
 /**
  * Abstraction of `g_timeout_add_seconds()` task
- * to be cancelled externally.
+ * to be cancelled externally. All of those tasks
+ * share a single timer wheel ticking each second.
  */
 guint
 util_timeout_add_seconds(guint interval,
                          GSourceFunc function,
                          gpointer data);
 
+/**
+ * Request the next frame of the user interface
+ * to flush pending frame tasks.
+ *
+ * @param cls Closure
+ * @return TRUE if a frame got requested, otherwise FALSE
+ */
+typedef gboolean (*UTIL_FrameRequest)(gpointer cls);
+
+/**
+ * Abstraction of `g_idle_add()` task which gets
+ * flushed together with all other frame tasks once
+ * per frame of the user interface. Tasks returning
+ * TRUE run again with the next frame.
+ */
+guint
+util_frame_add(GSourceFunc function,
+               gpointer data);
+
+/**
+ * Sets the driver requesting frames to flush the
+ * pending frame tasks. Without any driver or while
+ * the driver can't provide frames, the tasks get
+ * flushed from the main loop instead.
+ *
+ * @param request Frame request function or NULL
+ * @param cls Closure of the request function
+ */
+void
+util_frame_set_driver(UTIL_FrameRequest request,
+                      gpointer cls);
+
+/**
+ * Runs pending frame tasks in order until a given
+ * time budget is used up. Remaining tasks carry
+ * over to the next flush.
+ *
+ * @param budget Time budget in microseconds
+ * @return TRUE if tasks remain, otherwise FALSE
+ */
+gboolean
+util_frame_flush(gint64 budget);
+
+/**
+ * Returns whether any frame tasks are still pending
+ * to be flushed with the next frames.
+ *
+ * @return TRUE if tasks are pending, otherwise FALSE
+ */
+gboolean
+util_frame_pending(void);
+
 /**
  * Abstraction of `g_source_remove()` to
  * cancel a task by its tag.